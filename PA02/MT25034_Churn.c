@@ -0,0 +1,300 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "MT25034_Churn.h"
+#include "MT25034_Interval.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+// A connection started this far behind its slot in the --connect-rate
+// schedule counts as late: the client could not keep up with the rate
+#define CHURN_LATE_NS 1000000ULL
+// Pause after a failed connect, so running out of ports does not spin
+#define CHURN_RETRY_NS 1000000ULL
+#define FASTOPEN_QLEN 4096
+
+static const char *accept_names[] = { "thread", "reuseport", "prespawn" };
+
+const char *accept_mode_name(int mode) {
+    if (mode < 0 || mode > ACCEPT_PRESPAWN) {
+        return "unknown";
+    }
+    return accept_names[mode];
+}
+
+int accept_mode_parse(const char *name) {
+    for (int i = 0; i <= ACCEPT_PRESPAWN; i++) {
+        if (strcmp(accept_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *host;
+    int port;
+    size_t msg_size;
+    int duration;
+    int index;
+    double rate;        // connections per second for this thread, 0 = unlimited
+    mux_strategy_init_fn init;
+    mux_strategy_free_fn fini;
+
+    latency_stats_t stats;      // every request
+    latency_stats_t connect;    // connect() call
+    latency_stats_t setup;      // scheduled start to the first response
+    uint64_t conns;
+    uint64_t failed;
+    uint64_t late;
+    uint64_t fastopen;  // connections whose first request rode in the SYN
+} churn_thread_t;
+
+static void sleep_until(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// Blocking connect, set up like engine_connect(). With --fastopen the
+// connect() returns at once and the SYN leaves with the first send.
+static int churn_connect(const struct sockaddr_in *dst) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    transport_prepare_socket(sock);
+    int one = 1;
+    if (bench_opts.fastopen &&
+        setsockopt(sock, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one)) < 0) {
+        close(sock);
+        return -1;
+    }
+    if (connect(sock, (const struct sockaddr *)dst, sizeof(*dst)) < 0) {
+        close(sock);
+        return -1;
+    }
+    transport_setup_socket(sock);
+    ktls_setup_socket(sock, ROLE_CLIENT);
+    return sock;
+}
+
+static void *churn_thread(void *arg) {
+    churn_thread_t *t = (churn_thread_t *)arg;
+    transport_pin_thread(t->index);
+
+    struct sockaddr_in dst = {0};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(t->port);
+    if (inet_pton(AF_INET, t->host, &dst.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        return NULL;
+    }
+
+    // Buffers live for the thread; only the connections churn
+    mux_strategy_t s = {0};
+    if (t->init(&s, t->msg_size) < 0) {
+        perror("malloc failed");
+        return NULL;
+    }
+    struct msghdr msg_hdr = {0};
+    msg_hdr.msg_iov = s.send_iov;
+    msg_hdr.msg_iovlen = (size_t)s.send_iovcnt;
+    struct msghdr resp_hdr = {0};
+    resp_hdr.msg_iov = s.recv_iov;
+    resp_hdr.msg_iovlen = (size_t)s.recv_iovcnt;
+
+    uint64_t interval = t->rate > 0 ? (uint64_t)(1e9 / t->rate) : 0;
+    uint64_t start = now_ns();
+    uint64_t end = start + (uint64_t)t->duration * 1000000000ULL;
+    uint64_t next = start;
+    int logged = 0;
+
+    while (now_ns() < end) {
+        // Open loop: setup latency counts from the slot the schedule gave
+        // this connection, so falling behind shows up instead of hiding
+        uint64_t scheduled = now_ns();
+        if (interval > 0) {
+            if (next >= end) {
+                break;
+            }
+            sleep_until(next);
+            scheduled = next;
+            next += interval;
+            if (now_ns() - scheduled > CHURN_LATE_NS) {
+                t->late++;
+            }
+        }
+
+        uint64_t t0 = now_ns();
+        int sock = churn_connect(&dst);
+        if (sock < 0) {
+            if (!logged) {
+                perror("Connection Failed");
+                logged = 1;
+            }
+            t->failed++;
+            sleep_until(now_ns() + CHURN_RETRY_NS);
+            continue;
+        }
+        latency_record(&t->connect, now_ns() - t0);
+
+        int ok = 1;
+        for (int m = 0; m < bench_opts.churn && ok; m++) {
+            uint64_t begin = now_ns();
+            s.prepare(&s);
+            if (transport_sendmsg_all(sock, &msg_hdr, s.send_flags) < 0 ||
+                transport_recvmsg_all(sock, &resp_hdr, 0) < 0) {
+                ok = 0;
+                break;
+            }
+            uint64_t done = now_ns();
+            if (m == 0) {
+                latency_record(&t->setup, done - scheduled);
+            }
+            latency_record(&t->stats, done - begin);
+            t->stats.bytes += t->msg_size;
+            interval_record(t->index, done - begin, t->msg_size);
+        }
+
+        if (bench_opts.fastopen) {
+            struct tcp_info info;
+            socklen_t len = sizeof(info);
+            if (getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 &&
+                (info.tcpi_options & TCPI_OPT_SYN_DATA)) {
+                t->fastopen++;
+            }
+        }
+        close(sock);
+        if (ok) {
+            t->conns++;
+        } else {
+            t->failed++;
+        }
+    }
+
+    t->fini(&s);
+    return NULL;
+}
+
+int run_churn_clients(const char *label, const char *host, int port,
+                      int threads, size_t msg_size, int duration,
+                      mux_strategy_init_fn init, mux_strategy_free_fn fini) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)threads);
+    churn_thread_t *args = calloc((size_t)threads, sizeof(churn_thread_t));
+    if (!tids || !args) {
+        perror("malloc failed");
+        free(tids);
+        free(args);
+        return -1;
+    }
+
+    interval_start("client", label);
+    uint64_t wall_start = now_ns();
+    double cpu_start = process_cpu_seconds();
+
+    for (int i = 0; i < threads; i++) {
+        args[i].host = host;
+        args[i].port = port;
+        args[i].msg_size = msg_size;
+        args[i].duration = duration;
+        args[i].index = i;
+        args[i].rate = bench_opts.connect_rate > 0 ? bench_opts.connect_rate / threads : 0;
+        args[i].init = init;
+        args[i].fini = fini;
+        latency_reset(&args[i].stats);
+        latency_reset(&args[i].connect);
+        latency_reset(&args[i].setup);
+        pthread_create(&tids[i], NULL, churn_thread, &args[i]);
+    }
+
+    latency_stats_t total, connect, setup;
+    latency_reset(&total);
+    latency_reset(&connect);
+    latency_reset(&setup);
+    unsigned long long conns = 0, failed = 0, late = 0, fastopen = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        latency_merge(&total, &args[i].stats);
+        latency_merge(&connect, &args[i].connect);
+        latency_merge(&setup, &args[i].setup);
+        conns += args[i].conns;
+        failed += args[i].failed;
+        late += args[i].late;
+        fastopen += args[i].fastopen;
+    }
+    interval_stop();
+    double wall_s = (double)(now_ns() - wall_start) / 1e9;
+
+    char profile[160];
+    socket_profile_describe(&bench_opts.profile, profile, sizeof(profile));
+    print_client_summary(label, profile, &total, wall_s, process_cpu_seconds() - cpu_start);
+    printf("CHURN connections=%llu conn_per_s=%.1f target_per_s=%.1f messages_per_conn=%d "
+           "failed=%llu late=%llu fastopen=%s fastopen_conns=%llu connect_p50_us=%.3f "
+           "connect_p99_us=%.3f setup_avg_us=%.3f setup_p50_us=%.3f setup_p99_us=%.3f "
+           "setup_p999_us=%.3f setup_max_us=%.3f\n",
+           conns, wall_s > 0 ? (double)conns / wall_s : 0.0, bench_opts.connect_rate,
+           bench_opts.churn, failed, late, bench_opts.fastopen ? "on" : "off", fastopen,
+           latency_percentile_us(&connect, 50.0), latency_percentile_us(&connect, 99.0),
+           setup.count ? (double)setup.total_ns / (double)setup.count / 1000.0 : 0.0,
+           latency_percentile_us(&setup, 50.0), latency_percentile_us(&setup, 99.0),
+           latency_percentile_us(&setup, 99.9), (double)setup.max_ns / 1000.0);
+    fflush(stdout);
+
+    free(tids);
+    free(args);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------
+
+void churn_prepare_listener(int fd) {
+    if (!bench_opts.fastopen) {
+        return;
+    }
+    int qlen = FASTOPEN_QLEN;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &qlen, sizeof(qlen)) < 0) {
+        perror("TCP_FASTOPEN failed");
+    }
+
+    // Bit 2 of the sysctl turns on the server side; without it SYN data is
+    // ignored and every connection does the full handshake
+    static int warned;
+    FILE *f = fopen("/proc/sys/net/ipv4/tcp_fastopen", "r");
+    int mode = 0;
+    if (f) {
+        if (fscanf(f, "%d", &mode) != 1) {
+            mode = 0;
+        }
+        fclose(f);
+    }
+    if (!(mode & 2) && !warned) {
+        fprintf(stderr, "warning: net.ipv4.tcp_fastopen=%d, server-side Fast Open is off "
+                        "(set it to 3)\n", mode);
+        warned = 1;
+    }
+}
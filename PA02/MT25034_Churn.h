@@ -0,0 +1,40 @@
+#ifndef MT25034_CHURN_H
+#define MT25034_CHURN_H
+//MT25034
+
+#include <stddef.h>
+
+#include "MT25034_Multiplex.h"
+
+// Connection-setup benchmark (--churn=N on the client): instead of one
+// connection per thread for the whole run, every client thread opens a
+// connection, exchanges N requests on it and closes it, over and over, at
+// --connect-rate connections per second across all threads (open loop) or
+// as fast as it can. Handshake, accept and connection-thread start-up are
+// then part of what is measured. --fastopen puts the first request in the
+// SYN (TCP Fast Open, both sides); --accept picks how the server takes
+// connections in.
+
+enum {
+    ACCEPT_THREAD,      // one accept loop, a new thread per connection
+    ACCEPT_REUSEPORT,   // --acceptors SO_REUSEPORT listeners, each serving its own connections
+    ACCEPT_PRESPAWN,    // --acceptors threads started up front, sharing one listener
+};
+
+const char *accept_mode_name(int mode);
+int accept_mode_parse(const char *name);
+
+// Runs `threads` churning client threads against host:port for `duration`
+// seconds. Prints the SUMMARY line (every request) and a CHURN line with
+// connections per second and connect+first-response latency percentiles.
+// Returns 0 on success.
+int run_churn_clients(const char *label, const char *host, int port,
+                      int threads, size_t msg_size, int duration,
+                      mux_strategy_init_fn init, mux_strategy_free_fn fini);
+
+// Server side of --fastopen: enables TCP_FASTOPEN on a listening socket
+// (before listen()) and warns once when the kernel has server-side Fast
+// Open turned off.
+void churn_prepare_listener(int fd);
+
+#endif
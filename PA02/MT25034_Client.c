@@ -0,0 +1,183 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "MT25034_Churn.h"
+#include "MT25034_Client.h"
+#include "MT25034_Hybrid.h"
+#include "MT25034_Interval.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Stream.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+typedef struct {
+    const copy_engine_t *engine;
+    const char *host;
+    int port;
+    size_t msg_size;
+    int duration;
+    int index;
+    latency_stats_t stats;
+    hybrid_sender_t sender;
+} thread_args_t;
+
+int engine_connect(const char *host, int port) {
+    struct sockaddr_in serv_addr = {0};
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("Socket creation error");
+        return -1;
+    }
+
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &serv_addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        close(sock);
+        return -1;
+    }
+
+    transport_prepare_socket(sock);
+    if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        perror("Connection Failed");
+        close(sock);
+        return -1;
+    }
+    transport_setup_socket(sock);
+    ktls_setup_socket(sock, ROLE_CLIENT);
+    return sock;
+}
+
+// One blocking connection: prepare, send the request, wait for the response
+static void *send_messages(void *arg) {
+    thread_args_t *args = (thread_args_t *)arg;
+    const copy_engine_t *e = args->engine;
+
+    transport_pin_thread(args->index);
+    int sock = engine_connect(args->host, args->port);
+    if (sock < 0) {
+        return NULL;
+    }
+    mux_strategy_t s = {0};
+    if (e->client_init(&s, args->msg_size) < 0) {
+        perror("malloc failed");
+        close(sock);
+        return NULL;
+    }
+
+    struct msghdr msg_hdr = {0};
+    msg_hdr.msg_iov = s.send_iov;
+    msg_hdr.msg_iovlen = (size_t)s.send_iovcnt;
+    struct msghdr resp_hdr = {0};
+    resp_hdr.msg_iov = s.recv_iov;
+    resp_hdr.msg_iovlen = (size_t)s.recv_iovcnt;
+
+    // Without --send-mode this is the engine's plain sendmsg(send_flags) call
+    if (e->hybrid) {
+        hybrid_init(&args->sender, sock, s.send_flags);
+    }
+
+    time_t end_time = time(NULL) + args->duration;
+    while (time(NULL) < end_time) {
+        uint64_t start = now_ns();
+        s.prepare(&s);
+
+        int rc = e->hybrid ? hybrid_send(&args->sender, sock, &msg_hdr)
+                           : transport_sendmsg_all(sock, &msg_hdr, s.send_flags);
+        if (rc < 0) {
+            break;
+        }
+        if (transport_recvmsg_all(sock, &resp_hdr, 0) < 0) {
+            break;
+        }
+        // The response is in, so the request pages can be released before refilling
+        if (e->hybrid) {
+            hybrid_release(&args->sender, sock);
+        }
+        uint64_t ns = now_ns() - start;
+        latency_record(&args->stats, ns);
+        args->stats.bytes += args->msg_size;
+        interval_record(args->index, ns, args->msg_size);
+    }
+
+    close(sock);
+    e->client_free(&s);
+    return NULL;
+}
+
+int run_engine_clients(const copy_engine_t *e, const char *host, int port,
+                       int threads, size_t msg_size, int duration) {
+    if (bench_opts.streams > 0) {
+        return run_stream_clients(e->label, host, port, threads, msg_size, duration,
+                                  e->client_init, e->client_free);
+    }
+    if (bench_opts.churn > 0) {
+        return run_churn_clients(e->label, host, port, threads, msg_size, duration,
+                                 e->client_init, e->client_free);
+    }
+    if (bench_opts.conns > 0) {
+        return run_multiplexed_clients(e->label, host, port, threads, msg_size, duration,
+                                       e->client_init, e->client_free);
+    }
+
+    pthread_t *thread_ids = malloc(sizeof(pthread_t) * (size_t)threads);
+    thread_args_t *args = calloc((size_t)threads, sizeof(thread_args_t));
+    if (!thread_ids || !args) {
+        perror("malloc failed");
+        free(thread_ids);
+        free(args);
+        return -1;
+    }
+
+    interval_start("client", e->label);
+    uint64_t wall_start = now_ns();
+    double cpu_start = process_cpu_seconds();
+
+    for (int i = 0; i < threads; i++) {
+        args[i].engine = e;
+        args[i].host = host;
+        args[i].port = port;
+        args[i].msg_size = msg_size;
+        args[i].duration = duration;
+        args[i].index = i;
+        latency_reset(&args[i].stats);
+        pthread_create(&thread_ids[i], NULL, send_messages, &args[i]);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(thread_ids[i], NULL);
+    }
+    interval_stop();
+
+    latency_stats_t total;
+    hybrid_sender_t sender;
+    latency_reset(&total);
+    memset(&sender, 0, sizeof(sender));
+    for (int i = 0; i < threads; i++) {
+        latency_merge(&total, &args[i].stats);
+        hybrid_merge(&sender, &args[i].sender);
+    }
+    char profile[160];
+    socket_profile_describe(&bench_opts.profile, profile, sizeof(profile));
+    print_client_summary(e->label, profile, &total,
+                         (double)(now_ns() - wall_start) / 1e9,
+                         process_cpu_seconds() - cpu_start);
+    if (e->hybrid) {
+        hybrid_print(&sender);
+    }
+
+    free(thread_ids);
+    free(args);
+    return 0;
+}
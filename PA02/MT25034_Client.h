@@ -0,0 +1,20 @@
+#ifndef MT25034_CLIENT_H
+#define MT25034_CLIENT_H
+//MT25034
+
+#include <stddef.h>
+
+#include "MT25034_Engine.h"
+
+// Client side of the copy engines. Runs `threads` client threads against
+// host:port with engine `e` for `duration` seconds: one blocking socket per
+// thread, or the --conns / --streams / --churn modes. Prints the SUMMARY line (plus
+// the mode's extra lines) under the engine's label. Returns 0 on success.
+int run_engine_clients(const copy_engine_t *e, const char *host, int port,
+                       int threads, size_t msg_size, int duration);
+
+// Connects a set-up blocking client socket (socket options, kTLS) to
+// host:port; -1 after printing the error.
+int engine_connect(const char *host, int port);
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "MT25034_ConnMem.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+void buf_pool_init(buf_pool_t *pool, size_t block_size) {
+    pthread_mutex_init(&pool->lock, NULL);
+    // Idle blocks store the free-list link in place
+    pool->block_size = block_size < sizeof(void *) ? sizeof(void *) : block_size;
+    pool->free_list = NULL;
+    pool->blocks = 0;
+    pool->in_use = 0;
+    pool->peak = 0;
+}
+
+void *buf_pool_get(buf_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    void *block = pool->free_list;
+    if (block) {
+        pool->free_list = *(void **)block;
+    } else {
+        block = msgbuf_alloc(pool->block_size);
+        if (block) {
+            pool->blocks++;
+        }
+    }
+    if (block) {
+        pool->in_use++;
+        if (pool->in_use > pool->peak) {
+            pool->peak = pool->in_use;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return block;
+}
+
+void buf_pool_put(buf_pool_t *pool, void *block) {
+    if (!block) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int conn_thread_spawn(void *(*fn)(void *), void *arg) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (bench_opts.stack_kb > 0) {
+        size_t size = (size_t)bench_opts.stack_kb * 1024;
+        if (size < PTHREAD_STACK_MIN) {
+            size = PTHREAD_STACK_MIN;
+        }
+        int err = pthread_attr_setstacksize(&attr, size);
+        if (err != 0) {
+            errno = err;
+            perror("pthread_attr_setstacksize (using the default stack)");
+        }
+    }
+
+    pthread_t tid;
+    int err = pthread_create(&tid, &attr, fn, arg);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int conn_wait_request(int sock) {
+    char c;
+    for (;;) {
+        ssize_t n = transport_recv(sock, &c, 1, MSG_PEEK);
+        if (n > 0) {
+            return 0;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return -1;
+    }
+}
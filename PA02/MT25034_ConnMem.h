@@ -0,0 +1,34 @@
+#ifndef MT25034_CONNMEM_H
+#define MT25034_CONNMEM_H
+//MT25034
+
+#include <stddef.h>
+#include <pthread.h>
+
+// Per-connection memory on the servers: thread stacks sized by --stack-kb,
+// and (with --buffer-pool) message buffers borrowed from a shared pool only
+// while a request is being handled instead of held for the connection's life.
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t block_size;
+    void *free_list;    // idle blocks, linked through their first word
+    size_t blocks;      // blocks ever allocated (in use + idle)
+    size_t in_use;
+    size_t peak;
+} buf_pool_t;
+
+void buf_pool_init(buf_pool_t *pool, size_t block_size);
+
+// Takes a block from the pool, allocating one when none is idle; NULL on OOM.
+void *buf_pool_get(buf_pool_t *pool);
+void buf_pool_put(buf_pool_t *pool, void *block);
+
+// Starts a detached connection thread on a --stack-kb stack; -1 on error.
+int conn_thread_spawn(void *(*fn)(void *), void *arg);
+
+// Blocks until the next request starts arriving (peeks one byte) so no
+// buffer is borrowed for idle connections. -1 on EOF or error.
+int conn_wait_request(int sock);
+
+#endif
@@ -0,0 +1,208 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "MT25034_Engine.h"
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Server.h"
+//MT25034
+
+// ---------------------------------------------------------------------------
+// TwoCopy: fields packed into one buffer, echoed into another
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    Message msg;
+    msg_layout_t layout;
+    char *buffer;
+    char *echo;
+    struct iovec send_iov;
+    struct iovec recv_iov;
+} packed_ctx_t;
+
+static void packed_prepare(mux_strategy_t *s) {
+    packed_ctx_t *ctx = (packed_ctx_t *)s->ctx;
+    fill_message_fields(&ctx->msg, &ctx->layout);
+    pack_message(&ctx->msg, &ctx->layout, ctx->buffer);
+}
+
+static int packed_init(mux_strategy_t *s, size_t msg_size) {
+    packed_ctx_t *ctx = calloc(1, sizeof(packed_ctx_t));
+    if (!ctx) {
+        return -1;
+    }
+    size_t resp_size = response_size_for(msg_size);
+    ctx->buffer = msgbuf_alloc(msg_size);
+    ctx->echo = msgbuf_alloc(resp_size);
+    if (compute_field_sizes(&ctx->layout, msg_size) < 0 ||
+        allocate_message(&ctx->msg, &ctx->layout) < 0 || !ctx->buffer || !ctx->echo) {
+        free_message(&ctx->msg);
+        free_field_sizes(&ctx->layout);
+        msgbuf_free(ctx->buffer); msgbuf_free(ctx->echo);
+        free(ctx);
+        return -1;
+    }
+
+    ctx->send_iov.iov_base = ctx->buffer; ctx->send_iov.iov_len = msg_size;
+    ctx->recv_iov.iov_base = ctx->echo; ctx->recv_iov.iov_len = resp_size;
+    s->send_iov = &ctx->send_iov;
+    s->send_iovcnt = 1;
+    s->send_flags = 0;
+    s->recv_iov = &ctx->recv_iov;
+    s->recv_iovcnt = 1;
+    s->prepare = packed_prepare;
+    s->ctx = ctx;
+    return 0;
+}
+
+static void packed_free(mux_strategy_t *s) {
+    packed_ctx_t *ctx = (packed_ctx_t *)s->ctx;
+    free_message(&ctx->msg);
+    free_field_sizes(&ctx->layout);
+    msgbuf_free(ctx->buffer); msgbuf_free(ctx->echo);
+    free(ctx);
+}
+
+// ---------------------------------------------------------------------------
+// OneCopy / ZeroCopy: the fields are the iovec, responses scattered back
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    Message msg;
+    Message resp;
+    int asymmetric;
+    msg_layout_t layout;
+    msg_layout_t resp_layout;
+    struct iovec *iov;
+    struct iovec *resp_iov;
+} scatter_ctx_t;
+
+static void scatter_prepare(mux_strategy_t *s) {
+    scatter_ctx_t *ctx = (scatter_ctx_t *)s->ctx;
+    fill_message_fields(&ctx->msg, &ctx->layout);
+}
+
+static void scatter_free_ctx(scatter_ctx_t *ctx) {
+    free_message(&ctx->msg);
+    free_message(&ctx->resp);
+    free_field_sizes(&ctx->layout);
+    free_field_sizes(&ctx->resp_layout);
+    free(ctx->iov);
+    free(ctx->resp_iov);
+    free(ctx);
+}
+
+static int scatter_init(mux_strategy_t *s, size_t msg_size, int send_flags) {
+    scatter_ctx_t *ctx = calloc(1, sizeof(scatter_ctx_t));
+    if (!ctx) {
+        return -1;
+    }
+    size_t resp_size = response_size_for(msg_size);
+    ctx->asymmetric = resp_size != msg_size;
+    if (compute_field_sizes(&ctx->layout, msg_size) < 0 ||
+        compute_field_sizes(&ctx->resp_layout, resp_size) < 0 ||
+        !(ctx->iov = malloc(sizeof(struct iovec) * (size_t)ctx->layout.count)) ||
+        !(ctx->resp_iov = malloc(sizeof(struct iovec) * (size_t)ctx->resp_layout.count)) ||
+        allocate_message(&ctx->msg, &ctx->layout) < 0 ||
+        (ctx->asymmetric && allocate_message(&ctx->resp, &ctx->resp_layout) < 0)) {
+        scatter_free_ctx(ctx);
+        return -1;
+    }
+
+    setup_iovec(ctx->iov, &ctx->msg, &ctx->layout);
+    if (ctx->asymmetric) {
+        setup_iovec(ctx->resp_iov, &ctx->resp, &ctx->resp_layout);
+    }
+    s->send_iov = ctx->iov;
+    s->send_iovcnt = ctx->layout.count;
+    s->send_flags = send_flags;
+    s->recv_iov = ctx->asymmetric ? ctx->resp_iov : ctx->iov;
+    s->recv_iovcnt = ctx->asymmetric ? ctx->resp_layout.count : ctx->layout.count;
+    s->prepare = scatter_prepare;
+    s->ctx = ctx;
+    return 0;
+}
+
+static int onecopy_init(mux_strategy_t *s, size_t msg_size) {
+    return scatter_init(s, msg_size, 0);
+}
+
+static int zerocopy_init(mux_strategy_t *s, size_t msg_size) {
+    return scatter_init(s, msg_size, MSG_ZEROCOPY);
+}
+
+static void scatter_free(mux_strategy_t *s) {
+    scatter_free_ctx((scatter_ctx_t *)s->ctx);
+}
+
+// ---------------------------------------------------------------------------
+// Registry
+// ---------------------------------------------------------------------------
+
+const copy_engine_t engine_twocopy = {
+    "twocopy", "TwoCopy", 0, packed_init, packed_free, serve_packed, serve_packed_block,
+};
+
+const copy_engine_t engine_onecopy = {
+    "onecopy", "OneCopy", 0, onecopy_init, scatter_free, serve_scatter, serve_scatter_block,
+};
+
+// The server's sends only change path under --send-mode (its default is a
+// plain sendmsg, as in the original ZeroCopy server)
+const copy_engine_t engine_zerocopy = {
+    "zerocopy", "ZeroCopy", 1, zerocopy_init, scatter_free, serve_scatter, serve_scatter_block,
+};
+
+static const copy_engine_t *const engines[] = { &engine_twocopy, &engine_onecopy, &engine_zerocopy };
+
+int engine_count(void) {
+    return (int)(sizeof(engines) / sizeof(engines[0]));
+}
+
+const copy_engine_t *engine_at(int i) {
+    return i >= 0 && i < engine_count() ? engines[i] : NULL;
+}
+
+int engine_index(const copy_engine_t *e) {
+    for (int i = 0; i < engine_count(); i++) {
+        if (engines[i] == e) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const copy_engine_t *engine_find(const char *name) {
+    for (int i = 0; i < engine_count(); i++) {
+        if (strcmp(engines[i]->name, name) == 0) {
+            return engines[i];
+        }
+    }
+    return NULL;
+}
+
+int engine_list_parse(const char *list, const copy_engine_t **out) {
+    if (strcmp(list, "all") == 0) {
+        for (int i = 0; i < engine_count(); i++) {
+            out[i] = engines[i];
+        }
+        return engine_count();
+    }
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    int n = 0;
+    char *save = NULL;
+    for (char *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save)) {
+        const copy_engine_t *e = engine_find(name);
+        if (!e || n == ENGINE_MAX) {
+            return -1;
+        }
+        out[n++] = e;
+    }
+    return n > 0 ? n : -1;
+}
@@ -0,0 +1,44 @@
+#ifndef MT25034_ENGINE_H
+#define MT25034_ENGINE_H
+//MT25034
+
+#include <stddef.h>
+
+#include "MT25034_Multiplex.h"
+
+// Copy engines: how one request/response exchange moves the message bytes.
+// Every client mode (one socket per thread, --conns, --streams) drives an
+// engine's mux strategy, and the servers hand each accepted connection to
+// its serve function, so the pair binaries differ only in the engine they
+// pass to run_engine_clients()/run_engine_server(). The engines are wire
+// compatible: any client engine works against any server engine.
+typedef struct copy_engine {
+    const char *name;       // --engine=NAME
+    const char *label;      // SUMMARY/interval label
+    int hybrid;             // sends go through the --send-mode sender (MT25034_Hybrid.h)
+    // Client side: the request buffers and how they are sent
+    mux_strategy_init_fn client_init;
+    mux_strategy_free_fn client_free;
+    // Server side: serves one accepted, set-up connection until it closes
+    void (*serve)(const struct copy_engine *e, int sock, int index, size_t msg_size);
+    // --buffer-pool block a request borrows for a request of msg_size bytes
+    size_t (*pool_block)(size_t msg_size);
+} copy_engine_t;
+
+#define ENGINE_MAX 8
+
+extern const copy_engine_t engine_twocopy;     // pack into one buffer, send/recv
+extern const copy_engine_t engine_onecopy;     // sendmsg/recvmsg on the fields
+extern const copy_engine_t engine_zerocopy;    // sendmsg(MSG_ZEROCOPY) on the fields
+
+// Registered engines, in a fixed order (the unified server's port offsets).
+int engine_count(void);
+const copy_engine_t *engine_at(int i);
+int engine_index(const copy_engine_t *e);
+const copy_engine_t *engine_find(const char *name);
+
+// Parses "NAME[,NAME...]" or "all" into out (at most ENGINE_MAX entries).
+// Returns the number of engines, -1 on an unknown name.
+int engine_list_parse(const char *list, const copy_engine_t **out);
+
+#endif
@@ -0,0 +1,76 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MT25034_Handler.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+//MT25034
+
+static const char *handler_names[] = { "echo", "checksum", "transform", "cpu" };
+
+// Results land here so the compiler cannot drop the work as dead code
+static volatile uint64_t handler_sink;
+
+const char *handler_name(int handler) {
+    if (handler < 0 || handler > HANDLER_CPU) {
+        return "unknown";
+    }
+    return handler_names[handler];
+}
+
+int handler_parse(const char *name) {
+    for (int i = 0; i <= HANDLER_CPU; i++) {
+        if (strcmp(handler_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint64_t fnv1a(const unsigned char *p, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void handler_spin(uint64_t ns) {
+    uint64_t x = 88172645463325252ULL;
+    uint64_t deadline = now_ns() + ns;
+    do {
+        // Check the clock only every 64 rounds so the work dominates
+        for (int i = 0; i < 64; i++) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+    } while (now_ns() < deadline);
+    handler_sink = x;
+}
+
+int run_handler(char *const *fields, const size_t *sizes, int count) {
+    switch (bench_opts.handler) {
+    case HANDLER_CHECKSUM: {
+        uint64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            sum ^= fnv1a((const unsigned char *)fields[i], sizes[i]);
+        }
+        handler_sink = sum;
+        return 0;
+    }
+    case HANDLER_TRANSFORM:
+        for (int i = 0; i < count; i++) {
+            for (size_t j = 0; j < sizes[i]; j++) {
+                fields[i][j] ^= 0x20;
+            }
+        }
+        return 1;
+    case HANDLER_CPU:
+        handler_spin((uint64_t)bench_opts.work_ns);
+        return 0;
+    default:
+        return 0;
+    }
+}
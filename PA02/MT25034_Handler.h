@@ -0,0 +1,28 @@
+#ifndef MT25034_HANDLER_H
+#define MT25034_HANDLER_H
+//MT25034
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-request work done by the servers between receiving a request and
+// sending the response (--handler), so copy savings can be set against a
+// realistic processing cost.
+enum {
+    HANDLER_ECHO,       // no work, the request is returned as is
+    HANDLER_CHECKSUM,   // FNV-1a over each field
+    HANDLER_TRANSFORM,  // rewrite every field in place (ASCII case flip)
+    HANDLER_CPU,        // spin on arithmetic for --work-ns nanoseconds
+};
+
+const char *handler_name(int handler);
+int handler_parse(const char *name);
+
+// Runs bench_opts.handler over the `count` request fields. Returns 1 when
+// the fields were modified in place (so a packed copy must be rebuilt).
+int run_handler(char *const *fields, const size_t *sizes, int count);
+
+// Spins on arithmetic for `ns` nanoseconds (the "cpu" handler's work).
+void handler_spin(uint64_t ns);
+
+#endif
@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "MT25034_Hybrid.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+// Messages per path before a bucket picks one
+#define HYBRID_WARMUP 16
+// After calibration, one message in this many tries the other path
+#define HYBRID_PROBE_EVERY 128
+// Hysteresis: switch only when the other path is this much cheaper...
+#define HYBRID_MARGIN 0.20
+// ...and the current one has been kept for at least this many messages
+#define HYBRID_MIN_DWELL 256
+
+static const char *send_mode_names[] = { "default", "copy", "zerocopy", "adaptive" };
+
+const char *send_mode_name(int mode) {
+    if (mode < 0 || mode > SEND_MODE_ADAPTIVE) {
+        return "unknown";
+    }
+    return send_mode_names[mode];
+}
+
+int send_mode_parse(const char *name) {
+    for (int i = 0; i <= SEND_MODE_ADAPTIVE; i++) {
+        if (strcmp(send_mode_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int size_bucket(size_t len) {
+    int b = len ? 63 - __builtin_clzll((unsigned long long)len) : 0;
+    return b < HYBRID_BUCKETS ? b : HYBRID_BUCKETS - 1;
+}
+
+void hybrid_init(hybrid_sender_t *h, int sock, int default_flags) {
+    memset(h, 0, sizeof(*h));
+    h->mode = bench_opts.send_mode;
+    h->default_flags = default_flags;
+    h->pending_bucket = -1;
+    if (h->mode != SEND_MODE_ZEROCOPY && h->mode != SEND_MODE_ADAPTIVE) {
+        return;
+    }
+    if (ktls_active(sock)) {
+        static int warned;
+        if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "send mode %s: MSG_ZEROCOPY is not supported on kTLS sockets, sending with copies\n",
+                    send_mode_name(h->mode));
+        }
+        h->mode = SEND_MODE_COPY;
+        return;
+    }
+    // Without SO_ZEROCOPY the kernel silently ignores MSG_ZEROCOPY
+    int one = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+        h->zc.enabled = 1;
+        // A zero-copy send's short tail otherwise waits for the peer's
+        // delayed ACK under Nagle (~40 ms per message); keep an explicit
+        // --nodelay choice
+        if (bench_opts.profile.nodelay < 0) {
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    } else {
+        perror("setsockopt SO_ZEROCOPY (sending with plain copies)");
+        h->mode = SEND_MODE_COPY;
+    }
+}
+
+static int choose_path(hybrid_sender_t *h, hybrid_bucket_t *b) {
+    if (h->mode == SEND_MODE_COPY) {
+        return HYBRID_COPY;
+    }
+    if (h->mode == SEND_MODE_ZEROCOPY) {
+        return HYBRID_ZEROCOPY;
+    }
+    // Calibrate by alternating until both paths have enough samples
+    if (!b->calibrated) {
+        return b->samples[HYBRID_COPY] <= b->samples[HYBRID_ZEROCOPY] ? HYBRID_COPY : HYBRID_ZEROCOPY;
+    }
+    // Keep the other estimate fresh in case the machine's balance shifts
+    if (++b->since_probe >= HYBRID_PROBE_EVERY) {
+        b->since_probe = 0;
+        h->probes++;
+        return !b->path;
+    }
+    return b->path;
+}
+
+static void record_cost(hybrid_sender_t *h, int bucket, int path, uint64_t ns) {
+    hybrid_bucket_t *b = &h->buckets[bucket];
+    if (b->samples[path] == 0) {
+        b->cost_ns[path] = (double)ns;
+    } else {
+        b->cost_ns[path] += ((double)ns - b->cost_ns[path]) / 16.0;
+    }
+    b->samples[path]++;
+    b->since_switch++;
+
+    if (h->mode != SEND_MODE_ADAPTIVE) {
+        b->path = path;
+        return;
+    }
+    if (!b->calibrated) {
+        if (b->samples[HYBRID_COPY] < HYBRID_WARMUP || b->samples[HYBRID_ZEROCOPY] < HYBRID_WARMUP) {
+            return;
+        }
+        b->calibrated = 1;
+        b->path = b->cost_ns[HYBRID_ZEROCOPY] < b->cost_ns[HYBRID_COPY] ? HYBRID_ZEROCOPY : HYBRID_COPY;
+        b->since_switch = 0;
+        return;
+    }
+    int other = !b->path;
+    if (b->since_switch >= HYBRID_MIN_DWELL &&
+        b->cost_ns[other] < b->cost_ns[b->path] * (1.0 - HYBRID_MARGIN)) {
+        b->path = other;
+        b->since_switch = 0;
+        h->switches++;
+    }
+}
+
+static size_t msg_len(const struct msghdr *msg) {
+    size_t len = 0;
+    for (size_t i = 0; i < msg->msg_iovlen; i++) {
+        len += msg->msg_iov[i].iov_len;
+    }
+    return len;
+}
+
+int hybrid_send(hybrid_sender_t *h, int sock, const struct msghdr *msg) {
+    if (h->mode == SEND_MODE_DEFAULT) {
+        return transport_sendmsg_all(sock, msg, h->default_flags);
+    }
+
+    size_t len = msg_len(msg);
+    int bucket = size_bucket(len);
+    int path = choose_path(h, &h->buckets[bucket]);
+    int flags = path == HYBRID_ZEROCOPY ? MSG_ZEROCOPY : 0;
+
+    iov_cursor_t cur;
+    iov_cursor_init(&cur, msg);
+    struct msghdr part = *msg;
+    size_t sent = 0;
+    uint64_t start = now_ns();
+    while (sent < len) {
+        iov_cursor_part(&cur, &part);
+        ssize_t n = transport_sendmsg(sock, &part, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Too many pinned pages outstanding: wait for completions and retry
+            if (errno == ENOBUFS && path == HYBRID_ZEROCOPY) {
+                zerocopy_reap(sock, &h->zc, 1);
+                continue;
+            }
+            return -1;
+        }
+        if (path == HYBRID_ZEROCOPY) {
+            h->zc.sends++;
+        }
+        sent += (size_t)n;
+        iov_cursor_advance(&cur, (size_t)n);
+    }
+    uint64_t cost = now_ns() - start;
+
+    h->sends[path]++;
+    h->bytes[path] += len;
+    if (path == HYBRID_ZEROCOPY) {
+        h->pending_bucket = bucket;
+        h->pending_ns = cost;
+    } else {
+        record_cost(h, bucket, path, cost);
+    }
+    return 0;
+}
+
+void hybrid_release(hybrid_sender_t *h, int sock) {
+    if (!h->zc.enabled || h->zc.completions >= h->zc.sends) {
+        return;
+    }
+    // Charge the reaping itself, not the wait for the peer to read the data
+    uint64_t start = now_ns();
+    zerocopy_reap(sock, &h->zc, 0);
+    uint64_t reap_ns = now_ns() - start;
+    if (h->pending_bucket >= 0) {
+        record_cost(h, h->pending_bucket, HYBRID_ZEROCOPY, h->pending_ns + reap_ns);
+        h->pending_bucket = -1;
+    }
+    if (h->zc.completions < h->zc.sends) {
+        zerocopy_reap(sock, &h->zc, 1);
+    }
+}
+
+void hybrid_merge(hybrid_sender_t *dst, const hybrid_sender_t *src) {
+    if (dst->mode == SEND_MODE_DEFAULT) {
+        dst->mode = src->mode;
+    }
+    for (int p = 0; p < 2; p++) {
+        dst->sends[p] += src->sends[p];
+        dst->bytes[p] += src->bytes[p];
+    }
+    dst->switches += src->switches;
+    dst->probes += src->probes;
+    dst->zc.sends += src->zc.sends;
+    dst->zc.completions += src->zc.completions;
+    dst->zc.copied += src->zc.copied;
+
+    for (int i = 0; i < HYBRID_BUCKETS; i++) {
+        hybrid_bucket_t *d = &dst->buckets[i];
+        const hybrid_bucket_t *s = &src->buckets[i];
+        for (int p = 0; p < 2; p++) {
+            uint32_t n = d->samples[p] + s->samples[p];
+            if (n > 0) {
+                d->cost_ns[p] = (d->cost_ns[p] * d->samples[p] + s->cost_ns[p] * s->samples[p]) / n;
+            }
+            d->samples[p] = n;
+        }
+        if (d->samples[HYBRID_COPY] && d->samples[HYBRID_ZEROCOPY]) {
+            d->path = d->cost_ns[HYBRID_ZEROCOPY] < d->cost_ns[HYBRID_COPY] ? HYBRID_ZEROCOPY : HYBRID_COPY;
+        } else {
+            d->path = d->samples[HYBRID_ZEROCOPY] ? HYBRID_ZEROCOPY : HYBRID_COPY;
+        }
+    }
+}
+
+long hybrid_threshold(const hybrid_sender_t *h) {
+    long threshold = -1;
+    for (int i = HYBRID_BUCKETS - 1; i >= 0; i--) {
+        const hybrid_bucket_t *b = &h->buckets[i];
+        if (b->samples[HYBRID_COPY] + b->samples[HYBRID_ZEROCOPY] == 0) {
+            continue;
+        }
+        if (b->path != HYBRID_ZEROCOPY) {
+            break;
+        }
+        threshold = 1L << i;
+    }
+    return threshold;
+}
+
+void hybrid_print(const hybrid_sender_t *h) {
+    if (h->mode == SEND_MODE_DEFAULT) {
+        return;
+    }
+    printf("HYBRID mode=%s threshold=%ld copy_sends=%llu zc_sends=%llu copy_bytes=%llu "
+           "zc_bytes=%llu switches=%llu probes=%llu zc_completions=%llu zc_copied=%llu\n",
+           send_mode_name(h->mode), hybrid_threshold(h),
+           (unsigned long long)h->sends[HYBRID_COPY],
+           (unsigned long long)h->sends[HYBRID_ZEROCOPY],
+           (unsigned long long)h->bytes[HYBRID_COPY],
+           (unsigned long long)h->bytes[HYBRID_ZEROCOPY],
+           (unsigned long long)h->switches,
+           (unsigned long long)h->probes,
+           (unsigned long long)h->zc.completions,
+           (unsigned long long)h->zc.copied);
+    fflush(stdout);
+}
@@ -0,0 +1,71 @@
+#ifndef MT25034_HYBRID_H
+#define MT25034_HYBRID_H
+//MT25034
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "MT25034_Payload.h"
+
+// How the ZeroCopy pair sends messages (--send-mode). "default" keeps each
+// binary's historical call; the other modes enable SO_ZEROCOPY as needed.
+enum {
+    SEND_MODE_DEFAULT,
+    SEND_MODE_COPY,         // plain sendmsg
+    SEND_MODE_ZEROCOPY,     // MSG_ZEROCOPY on every send, completions reaped
+    SEND_MODE_ADAPTIVE,     // cheaper of the two per message-size bucket
+};
+
+enum { HYBRID_COPY, HYBRID_ZEROCOPY };
+
+// Message sizes are bucketed by power of two: bucket b holds [2^b, 2^(b+1))
+#define HYBRID_BUCKETS 32
+
+typedef struct {
+    int calibrated;         // both paths have HYBRID_WARMUP samples
+    int path;               // current choice once calibrated
+    double cost_ns[2];      // EWMA cost per message on each path
+    uint32_t samples[2];
+    uint32_t since_switch;  // messages since the last change of path
+    uint32_t since_probe;   // messages since the other path was last tried
+} hybrid_bucket_t;
+
+// Per-socket sender state. Zero-copy cost is sendmsg time plus the time to
+// reap its completions, so it is charged when hybrid_release() runs.
+typedef struct {
+    int mode;
+    int default_flags;      // flags used by SEND_MODE_DEFAULT
+    zc_counters_t zc;
+    hybrid_bucket_t buckets[HYBRID_BUCKETS];
+    int pending_bucket;     // zero-copy send still to be charged, -1 if none
+    uint64_t pending_ns;
+    uint64_t sends[2];      // messages per path
+    uint64_t bytes[2];
+    uint64_t switches;
+    uint64_t probes;
+} hybrid_sender_t;
+
+const char *send_mode_name(int mode);
+int send_mode_parse(const char *name);
+
+// Sets up `h` for bench_opts.send_mode on `sock` (SO_ZEROCOPY when needed).
+void hybrid_init(hybrid_sender_t *h, int sock, int default_flags);
+
+// Sends the whole message on the path chosen for its size; -1 on error.
+int hybrid_send(hybrid_sender_t *h, int sock, const struct msghdr *msg);
+
+// Reaps zero-copy completions and charges them to the last send. Must run
+// before the sent buffers are modified.
+void hybrid_release(hybrid_sender_t *h, int sock);
+
+// Adds src's counters and cost estimates into dst (for a process summary).
+void hybrid_merge(hybrid_sender_t *dst, const hybrid_sender_t *src);
+
+// Smallest message size from which every used bucket goes zero-copy, or -1.
+long hybrid_threshold(const hybrid_sender_t *h);
+
+// Prints "HYBRID mode= threshold= copy_sends= zc_sends= ..." (non-default modes).
+void hybrid_print(const hybrid_sender_t *h);
+
+#endif
@@ -0,0 +1,212 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "MT25034_Interval.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+//MT25034
+
+#define INTERVAL_HEADER "Run_ID,Role,Label,Interval,Time_s,Messages,Bytes,Throughput_Gbps," \
+                        "Avg_Latency_us,P50_Latency_us,P99_Latency_us,P999_Latency_us,Context_Switches\n"
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t total_ns;
+    uint64_t buckets[LAT_BUCKETS];
+} interval_counts_t;
+
+// Cache-line aligned so client threads never share a line
+typedef struct {
+    interval_counts_t c;
+} __attribute__((aligned(64))) interval_slot_t;
+
+static interval_slot_t *slots;
+static interval_counts_t *seen;     // what the reporter saw last time
+static pthread_t reporter_tid;
+static pthread_mutex_t reporter_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reporter_wake;
+static int reporter_stop;
+static const char *interval_role;
+static const char *interval_label;
+static uint64_t interval_origin;
+static uint64_t last_emit;
+static int interval_index;
+static long last_csw;
+static int out_fd = -1;
+
+static long context_switches(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) < 0) {
+        return 0;
+    }
+    return ru.ru_nvcsw + ru.ru_nivcsw;
+}
+
+void interval_record(int slot, uint64_t ns, uint64_t bytes) {
+    if (!slots) {
+        return;
+    }
+    interval_counts_t *c = &slots[slot % INTERVAL_SLOTS].c;
+    __atomic_fetch_add(&c->bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&c->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&c->buckets[latency_bucket(ns)], 1, __ATOMIC_RELAXED);
+}
+
+// Change of a counter since the last sample
+static uint64_t take_delta(uint64_t *cur, uint64_t *prev) {
+    uint64_t now = __atomic_load_n(cur, __ATOMIC_RELAXED);
+    uint64_t d = now - *prev;
+    *prev = now;
+    return d;
+}
+
+static void emit_interval(uint64_t now) {
+    static latency_stats_t d;
+    latency_reset(&d);
+    for (int i = 0; i < INTERVAL_SLOTS; i++) {
+        interval_counts_t *c = &slots[i].c;
+        d.bytes += take_delta(&c->bytes, &seen[i].bytes);
+        d.total_ns += take_delta(&c->total_ns, &seen[i].total_ns);
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            uint64_t n = take_delta(&c->buckets[b], &seen[i].buckets[b]);
+            d.buckets[b] += n;
+            d.count += n;
+        }
+    }
+    // No per-interval maximum; percentiles are the bucket upper edges
+    d.max_ns = UINT64_MAX;
+
+    long csw = context_switches();
+    double t = (double)(now - interval_origin) / 1e9;
+    // The last interval is usually shorter than --interval-ms
+    double period_s = (double)(now - last_emit) / 1e9;
+    double gbps = period_s > 0 ? (double)d.bytes * 8.0 / (period_s * 1e9) : 0.0;
+    double avg_us = d.count ? (double)d.total_ns / (double)d.count / 1000.0 : 0.0;
+    const char *run_id = bench_opts.run_id ? bench_opts.run_id : "";
+
+    char row[512];
+    int len;
+    if (out_fd >= 0) {
+        len = snprintf(row, sizeof(row), "%s,%s,%s,%d,%.3f,%llu,%llu,%.6f,%.3f,%.3f,%.3f,%.3f,%ld\n",
+                       run_id, interval_role, interval_label, interval_index, t,
+                       (unsigned long long)d.count, (unsigned long long)d.bytes, gbps, avg_us,
+                       latency_percentile_us(&d, 50.0), latency_percentile_us(&d, 99.0),
+                       latency_percentile_us(&d, 99.9), csw - last_csw);
+        // One write per row: client and server may append to the same file
+        if (write(out_fd, row, (size_t)len) != len) {
+            perror("interval csv write");
+        }
+    } else {
+        printf("INTERVAL run_id=%s role=%s label=%s interval=%d time_s=%.3f messages=%llu bytes=%llu "
+               "throughput_gbps=%.6f avg_us=%.3f p50_us=%.3f p99_us=%.3f p999_us=%.3f csw=%ld\n",
+               run_id, interval_role, interval_label, interval_index, t,
+               (unsigned long long)d.count, (unsigned long long)d.bytes, gbps, avg_us,
+               latency_percentile_us(&d, 50.0), latency_percentile_us(&d, 99.0),
+               latency_percentile_us(&d, 99.9), csw - last_csw);
+        fflush(stdout);
+    }
+    last_csw = csw;
+    last_emit = now;
+    interval_index++;
+}
+
+static void *reporter(void *arg) {
+    (void)arg;
+    uint64_t period = (uint64_t)bench_opts.interval_ms * 1000000ULL;
+    uint64_t next = interval_origin + period;
+    pthread_mutex_lock(&reporter_lock);
+    while (!reporter_stop) {
+        struct timespec ts = { (time_t)(next / 1000000000ULL), (long)(next % 1000000000ULL) };
+        if (pthread_cond_timedwait(&reporter_wake, &reporter_lock, &ts) == 0 && reporter_stop) {
+            break;
+        }
+        if (now_ns() >= next) {
+            emit_interval(next);
+            next += period;
+        }
+    }
+    pthread_mutex_unlock(&reporter_lock);
+    emit_interval(now_ns());
+    return NULL;
+}
+
+void interval_start(const char *role, const char *label) {
+    if (bench_opts.interval_ms <= 0) {
+        return;
+    }
+    slots = aligned_alloc(64, sizeof(interval_slot_t) * INTERVAL_SLOTS);
+    seen = calloc(INTERVAL_SLOTS, sizeof(interval_counts_t));
+    if (!slots || !seen) {
+        perror("interval counters");
+        free(slots);
+        free(seen);
+        slots = NULL;
+        seen = NULL;
+        return;
+    }
+    memset(slots, 0, sizeof(interval_slot_t) * INTERVAL_SLOTS);
+
+    if (bench_opts.interval_csv) {
+        out_fd = open(bench_opts.interval_csv, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (out_fd < 0) {
+            perror("open interval csv (printing INTERVAL lines instead)");
+        } else {
+            struct stat st;
+            if (fstat(out_fd, &st) == 0 && st.st_size == 0 &&
+                write(out_fd, INTERVAL_HEADER, strlen(INTERVAL_HEADER)) < 0) {
+                perror("interval csv write");
+            }
+        }
+    }
+
+    // The reporter sleeps on CLOCK_MONOTONIC deadlines, like now_ns()
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&reporter_wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    interval_role = role;
+    interval_label = label;
+    interval_index = 0;
+    reporter_stop = 0;
+    interval_origin = now_ns();
+    last_emit = interval_origin;
+    last_csw = context_switches();
+    if (pthread_create(&reporter_tid, NULL, reporter, NULL) != 0) {
+        perror("interval reporter");
+        free(slots);
+        free(seen);
+        slots = NULL;
+        seen = NULL;
+    }
+}
+
+void interval_stop(void) {
+    if (!slots) {
+        return;
+    }
+    pthread_mutex_lock(&reporter_lock);
+    reporter_stop = 1;
+    pthread_cond_signal(&reporter_wake);
+    pthread_mutex_unlock(&reporter_lock);
+    pthread_join(reporter_tid, NULL);
+    pthread_cond_destroy(&reporter_wake);
+    if (out_fd >= 0) {
+        close(out_fd);
+        out_fd = -1;
+    }
+    // Recording has stopped, so the counters can go (a later start re-creates them)
+    free(slots);
+    free(seen);
+    slots = NULL;
+    seen = NULL;
+}
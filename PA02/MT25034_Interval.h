@@ -0,0 +1,27 @@
+#ifndef MT25034_INTERVAL_H
+#define MT25034_INTERVAL_H
+//MT25034
+
+#include <stdint.h>
+
+// Interval time series (--interval-ms=N). Threads add every completed
+// request to a counter slot with relaxed atomic adds; a reporter thread
+// samples all slots once per period, without locking the workers out, and
+// writes that period's messages, bytes, latency percentiles and context
+// switches as one row: appended to --interval-csv, or an INTERVAL line on
+// stdout. Rows carry --run-id so they can be joined to the aggregate results.
+#define INTERVAL_SLOTS 64
+
+// Starts the reporter; does nothing when --interval-ms is 0. `role` is
+// "client" or "server".
+void interval_start(const char *role, const char *label);
+
+// Counts one request of `bytes` that took `ns` in slot `slot % INTERVAL_SLOTS`
+// (client threads own a slot each, server connections share them).
+void interval_record(int slot, uint64_t ns, uint64_t bytes);
+
+// Writes the last, partial interval and stops the reporter. Recording
+// threads must be done; interval_start() may then begin a new series.
+void interval_stop(void);
+
+#endif
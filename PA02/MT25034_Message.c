@@ -0,0 +1,187 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+//MT25034
+
+static const char *field_dist_names[] = { "even", "geometric", "random" };
+
+const char *field_dist_name(int dist) {
+    if (dist < 0 || dist > FIELD_DIST_RANDOM) {
+        return "unknown";
+    }
+    return field_dist_names[dist];
+}
+
+int field_dist_parse(const char *name) {
+    for (int i = 0; i <= FIELD_DIST_RANDOM; i++) {
+        if (strcmp(field_dist_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Weight of field i out of n; geometric halves every field but never drops
+// below 1/64 of the first so long chains keep non-empty tails.
+static double field_weight(int dist, int i, unsigned *seed) {
+    switch (dist) {
+    case FIELD_DIST_GEOMETRIC:
+        return i < 6 ? (double)(64 >> i) : 1.0;
+    case FIELD_DIST_RANDOM:
+        *seed = *seed * 1103515245u + 12345u;
+        return 1.0 + (double)((*seed >> 16) & 0xff);
+    default:
+        return 1.0;
+    }
+}
+
+int compute_field_sizes(msg_layout_t *layout, size_t msg_size) {
+    int n = bench_opts.fields;
+    layout->count = n;
+    layout->total = msg_size;
+    layout->sizes = malloc(sizeof(size_t) * (size_t)n);
+    if (!layout->sizes) {
+        return -1;
+    }
+
+    if (bench_opts.field_dist == FIELD_DIST_EVEN) {
+        size_t base = msg_size / (size_t)n;
+        size_t rem = msg_size % (size_t)n;
+        for (int i = 0; i < n; i++) {
+            layout->sizes[i] = base + ((size_t)i < rem ? 1 : 0);
+        }
+        return 0;
+    }
+
+    double weights = 0.0;
+    unsigned seed = 25034;
+    for (int i = 0; i < n; i++) {
+        weights += field_weight(bench_opts.field_dist, i, &seed);
+    }
+    seed = 25034;
+    size_t assigned = 0;
+    for (int i = 0; i < n; i++) {
+        double w = field_weight(bench_opts.field_dist, i, &seed);
+        layout->sizes[i] = (size_t)((double)msg_size * w / weights);
+        assigned += layout->sizes[i];
+    }
+    // Rounding leftovers go to the first field
+    layout->sizes[0] += msg_size - assigned;
+    return 0;
+}
+
+void free_field_sizes(msg_layout_t *layout) {
+    free(layout->sizes);
+    layout->sizes = NULL;
+}
+
+int allocate_message(Message *msg, const msg_layout_t *layout) {
+    msg->count = layout->count;
+    msg->owned = 1;
+    msg->fields = calloc((size_t)layout->count, sizeof(char *));
+    if (!msg->fields) {
+        return -1;
+    }
+    for (int i = 0; i < layout->count; i++) {
+        // Empty fields (more fields than bytes) still get a distinct buffer
+        msg->fields[i] = msgbuf_alloc(layout->sizes[i] ? layout->sizes[i] : 1);
+        if (!msg->fields[i]) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int bind_message(Message *msg, const msg_layout_t *layout, char *block) {
+    if (!msg->fields) {
+        msg->fields = calloc((size_t)layout->count, sizeof(char *));
+        if (!msg->fields) {
+            return -1;
+        }
+    }
+    msg->count = layout->count;
+    msg->owned = 0;
+    size_t offset = 0;
+    for (int i = 0; i < layout->count; i++) {
+        msg->fields[i] = block + offset;
+        offset += layout->sizes[i];
+    }
+    return 0;
+}
+
+void free_message(Message *msg) {
+    if (!msg->fields) {
+        return;
+    }
+    if (msg->owned) {
+        for (int i = 0; i < msg->count; i++) {
+            msgbuf_free(msg->fields[i]);
+        }
+    }
+    free(msg->fields);
+    msg->fields = NULL;
+}
+
+// Specialized bodies: with a constant `n` the compiler fully unrolls the
+// loops for the common field counts below; other counts use the generic one.
+#define MSG_FAST_PATHS(fn, ...) \
+    switch (layout->count) { \
+    case 1: fn(__VA_ARGS__, 1); return; \
+    case 2: fn(__VA_ARGS__, 2); return; \
+    case 4: fn(__VA_ARGS__, 4); return; \
+    case 8: fn(__VA_ARGS__, 8); return; \
+    case 16: fn(__VA_ARGS__, 16); return; \
+    default: fn(__VA_ARGS__, layout->count); return; \
+    }
+
+static inline __attribute__((always_inline))
+void fill_n(char *const *fields, const size_t *sizes, int n) {
+    for (int i = 0; i < n; i++) {
+        memset(fields[i], 'A' + i % 26, sizes[i]);
+    }
+}
+
+static inline __attribute__((always_inline))
+void iovec_n(struct iovec *iov, char *const *fields, const size_t *sizes, int n) {
+    for (int i = 0; i < n; i++) {
+        iov[i].iov_base = fields[i];
+        iov[i].iov_len = sizes[i];
+    }
+}
+
+static inline __attribute__((always_inline))
+void pack_n(char *const *fields, const size_t *sizes, char *buffer, int n) {
+    size_t offset = 0;
+    for (int i = 0; i < n; i++) {
+        memcpy(buffer + offset, fields[i], sizes[i]);
+        offset += sizes[i];
+    }
+}
+
+static inline __attribute__((always_inline))
+void unpack_n(char *const *fields, const size_t *sizes, const char *buffer, int n) {
+    size_t offset = 0;
+    for (int i = 0; i < n; i++) {
+        memcpy(fields[i], buffer + offset, sizes[i]);
+        offset += sizes[i];
+    }
+}
+
+void fill_message_fields(Message *msg, const msg_layout_t *layout) {
+    MSG_FAST_PATHS(fill_n, msg->fields, layout->sizes)
+}
+
+void setup_iovec(struct iovec *iov, const Message *msg, const msg_layout_t *layout) {
+    MSG_FAST_PATHS(iovec_n, iov, msg->fields, layout->sizes)
+}
+
+void pack_message(const Message *msg, const msg_layout_t *layout, char *buffer) {
+    MSG_FAST_PATHS(pack_n, msg->fields, layout->sizes, buffer)
+}
+
+void unpack_message(Message *msg, const msg_layout_t *layout, const char *buffer) {
+    MSG_FAST_PATHS(unpack_n, msg->fields, layout->sizes, buffer)
+}
@@ -0,0 +1,47 @@
+#ifndef MT25034_MESSAGE_H
+#define MT25034_MESSAGE_H
+//MT25034
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Scatter/gather message shared by all clients and servers: --fields=N
+// separately allocated fields (1..IOV_MAX, default 8) whose sizes follow
+// --field-dist. Client and server derive the same layout from msg_size.
+enum {
+    FIELD_DIST_EVEN,        // msg_size / N each, remainder on the first fields
+    FIELD_DIST_GEOMETRIC,   // each field about half the previous one
+    FIELD_DIST_RANDOM,      // fixed-seed random weights (same on both sides)
+};
+
+typedef struct {
+    int count;
+    size_t total;
+    size_t *sizes;
+} msg_layout_t;
+
+typedef struct {
+    int count;
+    char **fields;
+    int owned;              // fields allocated one by one, not bound to a block
+} Message;
+
+const char *field_dist_name(int dist);
+int field_dist_parse(const char *name);
+
+// Splits msg_size into bench_opts.fields fields; -1 on allocation failure.
+int compute_field_sizes(msg_layout_t *layout, size_t msg_size);
+void free_field_sizes(msg_layout_t *layout);
+
+int allocate_message(Message *msg, const msg_layout_t *layout);
+// Points the fields into one contiguous block of layout->total bytes.
+int bind_message(Message *msg, const msg_layout_t *layout, char *block);
+void free_message(Message *msg);
+
+// Field i is filled with 'A' + i % 26.
+void fill_message_fields(Message *msg, const msg_layout_t *layout);
+void setup_iovec(struct iovec *iov, const Message *msg, const msg_layout_t *layout);
+void pack_message(const Message *msg, const msg_layout_t *layout, char *buffer);
+void unpack_message(Message *msg, const msg_layout_t *layout, const char *buffer);
+
+#endif
@@ -0,0 +1,245 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+// Chunks buffers are carved from; larger requests get a mapping of their own
+#define MSGBUF_CHUNK (4 * HUGE_PAGE_SIZE)
+// Power-of-two size classes from 64 B up to 1 MiB (header included)
+#define MSGBUF_MIN_SHIFT 6
+#define MSGBUF_CLASSES 15
+#define MSGBUF_LARGE MSGBUF_CLASSES
+#define MSGBUF_MALLOC (MSGBUF_CLASSES + 1)
+// NUMA nodes with chunks of their own (--placement); slot 0 is unbound memory
+#define MSGBUF_NODES 64
+
+// Sits in front of every huge-page buffer; keeps the buffer 16-byte aligned
+typedef struct {
+    uint32_t size_class;    // MSGBUF_LARGE: own mapping, MSGBUF_MALLOC: fallback
+    uint32_t slot;          // node + 1 of the chunks it came from, 0 if unbound
+    size_t map_len;         // dedicated mappings only
+} msgbuf_hdr_t;
+
+static const char *hugepage_names[] = { "off", "thp", "hugetlb" };
+
+static pthread_mutex_t msgbuf_lock = PTHREAD_MUTEX_INITIALIZER;
+static int effective_mode = -1;
+static void *free_lists[MSGBUF_NODES + 1][MSGBUF_CLASSES];
+static char *chunk_next[MSGBUF_NODES + 1];
+static size_t chunk_left[MSGBUF_NODES + 1];
+static int mbind_failed;
+
+const char *hugepage_mode_name(int mode) {
+    if (mode < 0 || mode > HUGEPAGES_HUGETLB) {
+        return "unknown";
+    }
+    return hugepage_names[mode];
+}
+
+int hugepage_mode_parse(const char *name) {
+    for (int i = 0; i <= HUGEPAGES_HUGETLB; i++) {
+        if (strcmp(hugepage_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int msgbuf_effective_mode(void) {
+    pthread_mutex_lock(&msgbuf_lock);
+    if (effective_mode < 0) {
+        effective_mode = bench_opts.hugepages;
+    }
+    int mode = effective_mode;
+    pthread_mutex_unlock(&msgbuf_lock);
+    return mode;
+}
+
+// Buffers go through the chunks with huge pages or with --placement (which
+// needs page-granular memory to bind); otherwise they are plain malloc.
+static int use_chunks(void) {
+    return bench_opts.hugepages != HUGEPAGES_OFF || bench_opts.placement != PLACEMENT_NONE;
+}
+
+// Prefers `node` for a range that has not been faulted in yet. MPOL_PREFERRED
+// rather than MPOL_BIND so a full node spills over instead of failing.
+static void bind_node(void *p, size_t len, int node) {
+    if (node < 0) {
+        return;
+    }
+    unsigned long mask[MSGBUF_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_mbind, p, len, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0) < 0 && !mbind_failed) {
+        perror("mbind (buffers left to first touch)");
+        mbind_failed = 1;
+    }
+}
+
+static void prefault(char *p, size_t len, size_t step) {
+    for (size_t off = 0; off < len; off += step) {
+        p[off] = 0;
+    }
+}
+
+// THP: over-map, trim to a 2 MiB boundary, advise, then fault every page in
+// (MAP_POPULATE would fault before the madvise and get small pages).
+static void *map_thp(size_t len, int node) {
+    size_t span = len + HUGE_PAGE_SIZE;
+    char *raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+    char *aligned = (char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if (aligned > raw) {
+        munmap(raw, (size_t)(aligned - raw));
+    }
+    size_t tail = (size_t)(raw + span - (aligned + len));
+    if (tail > 0) {
+        munmap(aligned + len, tail);
+    }
+    if (madvise(aligned, len, MADV_HUGEPAGE) < 0) {
+        perror("madvise MADV_HUGEPAGE");
+    }
+    bind_node(aligned, len, node);
+    prefault(aligned, len, (size_t)sysconf(_SC_PAGESIZE));
+    return aligned;
+}
+
+// Maps `len` bytes (a multiple of HUGE_PAGE_SIZE) in the effective mode,
+// downgrading it on failure, and prefers `node` (-1: first touch). Called
+// with msgbuf_lock held.
+static void *map_chunk(size_t len, int node) {
+    if (effective_mode == HUGEPAGES_HUGETLB) {
+        // Populating has to wait for the policy when binding
+        int populate = node < 0 ? MAP_POPULATE : 0;
+        char *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+        if (p != MAP_FAILED) {
+            if (node >= 0) {
+                bind_node(p, len, node);
+                prefault(p, len, HUGE_PAGE_SIZE);
+            }
+            return p;
+        }
+        perror("mmap MAP_HUGETLB (falling back to transparent huge pages)");
+        effective_mode = HUGEPAGES_THP;
+    }
+    if (effective_mode == HUGEPAGES_THP) {
+        void *p = map_thp(len, node);
+        if (!p) {
+            perror("mmap huge page chunk (falling back to malloc)");
+            effective_mode = HUGEPAGES_OFF;
+        }
+        return p;
+    }
+    // --placement without huge pages: small pages, still node-local
+    char *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    bind_node(p, len, node);
+    prefault(p, len, (size_t)sysconf(_SC_PAGESIZE));
+    return p;
+}
+
+static void *chunk_alloc(size_t len, int node) {
+    int slot = node + 1;
+    size_t need = len + sizeof(msgbuf_hdr_t);
+    int cls = 0;
+    while (cls < MSGBUF_CLASSES && ((size_t)1 << (cls + MSGBUF_MIN_SHIFT)) < need) {
+        cls++;
+    }
+
+    msgbuf_hdr_t *h = NULL;
+    if (cls == MSGBUF_LARGE) {
+        size_t map_len = (need + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        h = map_chunk(map_len, node);
+        if (!h) {
+            return NULL;
+        }
+        h->map_len = map_len;
+    } else if (free_lists[slot][cls]) {
+        h = free_lists[slot][cls];
+        free_lists[slot][cls] = *(void **)(h + 1);   // link lives in the buffer
+    } else {
+        size_t block = (size_t)1 << (cls + MSGBUF_MIN_SHIFT);
+        if (chunk_left[slot] < block) {
+            // The tail of the old chunk is abandoned; chunks are never unmapped
+            chunk_next[slot] = map_chunk(MSGBUF_CHUNK, node);
+            chunk_left[slot] = chunk_next[slot] ? MSGBUF_CHUNK : 0;
+            if (!chunk_next[slot]) {
+                return NULL;
+            }
+        }
+        h = (msgbuf_hdr_t *)chunk_next[slot];
+        chunk_next[slot] += block;
+        chunk_left[slot] -= block;
+    }
+    h->size_class = (uint32_t)cls;
+    h->slot = (uint32_t)slot;
+    return h + 1;
+}
+
+void *msgbuf_alloc(size_t len) {
+    if (!use_chunks()) {
+        return malloc(len);
+    }
+    // Node of the (already pinned) calling thread
+    int node = placement_buffer_node();
+    if (node >= MSGBUF_NODES) {
+        node = -1;
+    }
+    pthread_mutex_lock(&msgbuf_lock);
+    if (effective_mode < 0) {
+        effective_mode = bench_opts.hugepages;
+    }
+    void *p = NULL;
+    if (effective_mode != HUGEPAGES_OFF || node >= 0) {
+        p = chunk_alloc(len, node);
+    }
+    int mode = effective_mode;
+    pthread_mutex_unlock(&msgbuf_lock);
+    if (!p && mode == HUGEPAGES_OFF) {
+        // Keep the header so msgbuf_free() can tell the two kinds apart
+        msgbuf_hdr_t *h = malloc(sizeof(msgbuf_hdr_t) + len);
+        if (!h) {
+            return NULL;
+        }
+        h->size_class = MSGBUF_MALLOC;
+        p = h + 1;
+    }
+    return p;
+}
+
+void msgbuf_free(void *p) {
+    if (!p) {
+        return;
+    }
+    if (!use_chunks()) {
+        free(p);
+        return;
+    }
+    msgbuf_hdr_t *h = (msgbuf_hdr_t *)p - 1;
+    if (h->size_class == MSGBUF_MALLOC) {
+        free(h);
+    } else if (h->size_class == MSGBUF_LARGE) {
+        munmap(h, h->map_len);
+    } else {
+        pthread_mutex_lock(&msgbuf_lock);
+        *(void **)p = free_lists[h->slot][h->size_class];
+        free_lists[h->slot][h->size_class] = h;
+        pthread_mutex_unlock(&msgbuf_lock);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef MT25034_MSGBUF_H
+#define MT25034_MSGBUF_H
+//MT25034
+
+#include <stddef.h>
+
+// Allocator for message buffers (fields, packed buffers, pool blocks) in
+// clients and servers. With --hugepages the buffers are carved out of
+// prefaulted 2 MiB-aligned chunks so large messages touch few TLB entries
+// and MSG_ZEROCOPY pins huge pages instead of 4 KiB ones.
+enum {
+    HUGEPAGES_OFF,      // plain malloc
+    HUGEPAGES_THP,      // anonymous chunks with madvise(MADV_HUGEPAGE)
+    HUGEPAGES_HUGETLB,  // MAP_HUGETLB chunks from the reserved hugetlb pool
+};
+
+const char *hugepage_mode_name(int mode);
+int hugepage_mode_parse(const char *name);
+
+// Mode actually in use: hugetlb falls back to THP when no huge pages are
+// reserved, THP to plain malloc when mmap fails.
+int msgbuf_effective_mode(void);
+
+void *msgbuf_alloc(size_t len);
+void msgbuf_free(void *p);
+
+#endif
@@ -0,0 +1,492 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "MT25034_Interval.h"
+#include "MT25034_Multiplex.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+#define MUX_MAX_EVENTS 1024
+#define MUX_OPEN_BATCH 256
+// Loopback has ~28k ephemeral ports per source address; beyond this many
+// connections the client binds further sources 127.0.0.2, 127.0.0.3, ...
+#define MUX_CONNS_PER_SRC 20000
+// Connections still not established this long after the last connect()
+// are ignored and the measurement starts without them.
+#define MUX_RAMP_GRACE_NS (10ULL * 1000000000ULL)
+
+// CONN_IDLE: connected but parked until the --idle-s hold is over
+enum { CONN_CLOSED, CONN_CONNECTING, CONN_IDLE, CONN_SENDING, CONN_RECEIVING };
+
+typedef struct {
+    int fd;
+    int state;
+    int want_out;       // EPOLLOUT currently registered
+    size_t offset;
+    uint64_t start;
+} mux_conn_t;
+
+typedef struct {
+    const char *host;
+    int port;
+    size_t msg_size;
+    int duration;
+    int index;
+    int conns;
+    int conn_base;      // global index of this thread's first connection
+    double rate;        // connects per second for this thread, 0 = unlimited
+    mux_strategy_init_fn init;
+    mux_strategy_free_fn fini;
+
+    latency_stats_t stats;
+    int established;
+    int failed;
+    int dropped;
+    uint64_t ramp_ns;
+    uint64_t steady_ns;
+    double steady_cpu_s;
+} mux_thread_t;
+
+typedef struct {
+    mux_thread_t *t;
+    mux_strategy_t strategy;
+    int epfd;
+    struct iovec *scratch;
+    size_t send_len;
+    size_t recv_len;
+    int steady;
+    uint64_t end;
+    int holding;        // park new connections instead of sending (--idle-s)
+    uint64_t idle_end;
+} mux_loop_t;
+
+static void conn_close(mux_loop_t *l, mux_conn_t *c, int dropped) {
+    if (c->state == CONN_CLOSED) {
+        return;
+    }
+    epoll_ctl(l->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->state = CONN_CLOSED;
+    if (dropped) {
+        l->t->dropped++;
+    }
+}
+
+static void conn_want_out(mux_loop_t *l, mux_conn_t *c, int on) {
+    if (c->want_out == on) {
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN | (on ? EPOLLOUT : 0), .data.ptr = c };
+    epoll_ctl(l->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->want_out = on;
+}
+
+static void conn_continue_send(mux_loop_t *l, mux_conn_t *c) {
+    mux_strategy_t *s = &l->strategy;
+    size_t len = l->send_len;
+
+    while (c->offset < len) {
+        struct msghdr mh = {0};
+        mh.msg_iov = l->scratch;
+        mh.msg_iovlen = (size_t)iov_slice(s->send_iov, s->send_iovcnt, c->offset, l->scratch);
+        ssize_t n = sendmsg(c->fd, &mh, ktls_send_flags(s->send_flags) | MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                conn_want_out(l, c, 1);
+                return;
+            }
+            conn_close(l, c, 1);
+            return;
+        }
+        c->offset += (size_t)n;
+    }
+
+    conn_want_out(l, c, 0);
+    c->state = CONN_RECEIVING;
+    c->offset = 0;
+}
+
+static void conn_start_request(mux_loop_t *l, mux_conn_t *c) {
+    c->state = CONN_SENDING;
+    c->offset = 0;
+    c->start = now_ns();
+    if (l->strategy.prepare) {
+        l->strategy.prepare(&l->strategy);
+    }
+    conn_continue_send(l, c);
+}
+
+static void conn_continue_recv(mux_loop_t *l, mux_conn_t *c) {
+    mux_strategy_t *s = &l->strategy;
+    size_t len = l->recv_len;
+
+    while (c->offset < len) {
+        struct msghdr mh = {0};
+        mh.msg_iov = l->scratch;
+        mh.msg_iovlen = (size_t)iov_slice(s->recv_iov, s->recv_iovcnt, c->offset, l->scratch);
+        ssize_t n = recvmsg(c->fd, &mh, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            conn_close(l, c, 1);
+            return;
+        }
+        if (n == 0) {
+            conn_close(l, c, 1);
+            return;
+        }
+        c->offset += (size_t)n;
+    }
+
+    uint64_t now = now_ns();
+    if (l->steady) {
+        latency_record(&l->t->stats, now - c->start);
+        l->t->stats.bytes += l->send_len;
+        interval_record(l->t->index, now - c->start, l->send_len);
+    }
+    if (!l->steady || now < l->end) {
+        conn_start_request(l, c);
+    } else {
+        conn_close(l, c, 0);
+    }
+}
+
+static void conn_connected(mux_loop_t *l, mux_conn_t *c) {
+    int err = 0;
+    socklen_t elen = sizeof(err);
+    if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &elen) < 0 || err != 0) {
+        l->t->failed++;
+        epoll_ctl(l->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        c->state = CONN_CLOSED;
+        return;
+    }
+    l->t->established++;
+    socket_profile_apply(c->fd, &bench_opts.profile);
+    ktls_setup_socket(c->fd, ROLE_CLIENT);
+    conn_want_out(l, c, 0);
+    if (l->holding) {
+        c->state = CONN_IDLE;
+        return;
+    }
+    conn_start_request(l, c);
+}
+
+static int conn_open(mux_loop_t *l, mux_conn_t *c, const struct sockaddr_in *dst, int global_idx) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    transport_prepare_socket(fd);
+
+    int src_slot = global_idx / MUX_CONNS_PER_SRC;
+    if (src_slot > 0 && (ntohl(dst->sin_addr.s_addr) >> 24) == 127) {
+        struct sockaddr_in src = {0};
+        int one = 1;
+        setsockopt(fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &one, sizeof(one));
+        src.sin_family = AF_INET;
+        src.sin_addr.s_addr = htonl(INADDR_LOOPBACK + (uint32_t)src_slot);
+        if (bind(fd, (struct sockaddr *)&src, sizeof(src)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (connect(fd, (const struct sockaddr *)dst, sizeof(*dst)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+
+    c->fd = fd;
+    c->state = CONN_CONNECTING;
+    c->want_out = 1;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT, .data.ptr = c };
+    if (epoll_ctl(l->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        c->state = CONN_CLOSED;
+        return -1;
+    }
+    return 0;
+}
+
+static void *mux_thread(void *arg) {
+    mux_thread_t *t = (mux_thread_t *)arg;
+    mux_loop_t l = { .t = t, .epfd = -1, .holding = bench_opts.idle_s > 0 };
+    mux_conn_t *conns = NULL;
+    struct epoll_event *events = NULL;
+
+    transport_pin_thread(t->index);
+
+    struct sockaddr_in dst = {0};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(t->port);
+    if (inet_pton(AF_INET, t->host, &dst.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        return NULL;
+    }
+
+    if (t->init(&l.strategy, t->msg_size) < 0) {
+        perror("malloc failed");
+        return NULL;
+    }
+    int max_iov = l.strategy.send_iovcnt > l.strategy.recv_iovcnt ?
+                  l.strategy.send_iovcnt : l.strategy.recv_iovcnt;
+    l.scratch = malloc(sizeof(struct iovec) * (size_t)max_iov);
+    for (int i = 0; i < l.strategy.send_iovcnt; i++) {
+        l.send_len += l.strategy.send_iov[i].iov_len;
+    }
+    for (int i = 0; i < l.strategy.recv_iovcnt; i++) {
+        l.recv_len += l.strategy.recv_iov[i].iov_len;
+    }
+    conns = calloc((size_t)t->conns, sizeof(mux_conn_t));
+    events = malloc(sizeof(struct epoll_event) * MUX_MAX_EVENTS);
+    l.epfd = epoll_create1(0);
+    if (!l.scratch || !conns || !events || l.epfd < 0) {
+        perror("mux setup failed");
+        goto out;
+    }
+
+    uint64_t interval = t->rate > 0 ? (uint64_t)(1e9 / t->rate) : 0;
+    uint64_t ramp_start = now_ns();
+    uint64_t last_open = ramp_start;
+    uint64_t steady_start = 0;
+    double cpu_start = 0.0;
+    int opened = 0;
+    int open_failed_logged = 0;
+
+    for (;;) {
+        uint64_t now = now_ns();
+
+        // Open new connections at the configured rate
+        int batch = 0;
+        while (opened < t->conns && batch < MUX_OPEN_BATCH &&
+               (interval == 0 || now >= ramp_start + (uint64_t)opened * interval)) {
+            if (conn_open(&l, &conns[opened], &dst, t->conn_base + opened) < 0) {
+                if (!open_failed_logged) {
+                    perror("connect setup failed");
+                    open_failed_logged = 1;
+                }
+                conns[opened].state = CONN_CLOSED;
+                t->failed++;
+                if (errno == EMFILE || errno == ENFILE) {
+                    t->conns = opened;
+                    break;
+                }
+            }
+            opened++;
+            batch++;
+            last_open = now;
+        }
+
+        // Steady phase starts once every connection is up (or given up on),
+        // after holding them idle for --idle-s if requested
+        int ramp_done = opened >= t->conns &&
+            (t->established + t->failed >= t->conns || now - last_open > MUX_RAMP_GRACE_NS);
+        if (ramp_done && l.holding && l.idle_end == 0) {
+            t->ramp_ns = now - ramp_start;
+            l.idle_end = now + (uint64_t)(bench_opts.idle_s * 1e9);
+        }
+        if (l.holding && l.idle_end != 0 && now >= l.idle_end) {
+            l.holding = 0;
+            for (int i = 0; i < t->conns; i++) {
+                if (conns[i].state == CONN_IDLE) {
+                    conn_start_request(&l, &conns[i]);
+                }
+            }
+        }
+        if (!l.steady && !l.holding && ramp_done) {
+            steady_start = now;
+            cpu_start = thread_cpu_seconds();
+            if (t->ramp_ns == 0) {
+                t->ramp_ns = now - ramp_start;
+            }
+            l.steady = 1;
+            l.end = now + (uint64_t)t->duration * 1000000000ULL;
+        }
+        if (l.steady && now >= l.end) {
+            break;
+        }
+
+        int timeout_ms = 100;
+        if (opened < t->conns && interval > 0) {
+            uint64_t next = ramp_start + (uint64_t)opened * interval;
+            timeout_ms = next > now ? (int)((next - now) / 1000000ULL) : 0;
+        } else if (l.steady) {
+            uint64_t left_ms = (l.end - now) / 1000000ULL;
+            timeout_ms = left_ms < 100 ? (int)left_ms : 100;
+        }
+
+        int nev = epoll_wait(l.epfd, events, MUX_MAX_EVENTS, timeout_ms);
+        if (nev < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait failed");
+            break;
+        }
+        for (int i = 0; i < nev; i++) {
+            mux_conn_t *c = (mux_conn_t *)events[i].data.ptr;
+            uint32_t ev = events[i].events;
+
+            if (c->state == CONN_CONNECTING) {
+                if (ev & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    conn_connected(&l, c);
+                }
+            } else if (c->state == CONN_IDLE) {
+                // The server never talks first: anything here is a close
+                if (ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    conn_close(&l, c, 1);
+                }
+            } else if (c->state == CONN_SENDING) {
+                if (ev & (EPOLLERR | EPOLLHUP)) {
+                    conn_close(&l, c, 1);
+                } else if (ev & EPOLLOUT) {
+                    conn_continue_send(&l, c);
+                }
+            } else if (c->state == CONN_RECEIVING) {
+                if (ev & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    conn_continue_recv(&l, c);
+                }
+            }
+        }
+    }
+
+    if (l.steady) {
+        t->steady_ns = now_ns() - steady_start;
+        t->steady_cpu_s = thread_cpu_seconds() - cpu_start;
+    }
+
+out:
+    if (conns) {
+        for (int i = 0; i < t->conns; i++) {
+            if (conns[i].state != CONN_CLOSED) {
+                close(conns[i].fd);
+            }
+        }
+    }
+    if (l.epfd >= 0) {
+        close(l.epfd);
+    }
+    free(conns);
+    free(events);
+    free(l.scratch);
+    t->fini(&l.strategy);
+    return NULL;
+}
+
+// Every connection needs a descriptor; lift the soft limit as far as allowed.
+static void raise_fd_limit(int needed) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+        return;
+    }
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    if ((rlim_t)needed > rl.rlim_cur) {
+        fprintf(stderr, "warning: %d connections requested but RLIMIT_NOFILE is %llu\n",
+                needed, (unsigned long long)rl.rlim_cur);
+    }
+}
+
+int run_multiplexed_clients(const char *label, const char *host, int port,
+                            int threads, size_t msg_size, int duration,
+                            mux_strategy_init_fn init, mux_strategy_free_fn fini) {
+    int total = bench_opts.conns;
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > total) {
+        threads = total;
+    }
+
+    double rate = bench_opts.connect_rate;
+    if (rate <= 0 && bench_opts.ramp_up_s > 0) {
+        rate = (double)total / bench_opts.ramp_up_s;
+    }
+
+    raise_fd_limit(total + 64);
+
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)threads);
+    mux_thread_t *args = calloc((size_t)threads, sizeof(mux_thread_t));
+    if (!tids || !args) {
+        perror("malloc failed");
+        free(tids);
+        free(args);
+        return -1;
+    }
+
+    interval_start("client", label);
+    uint64_t wall_start = now_ns();
+
+    int base = 0;
+    for (int i = 0; i < threads; i++) {
+        args[i].host = host;
+        args[i].port = port;
+        args[i].msg_size = msg_size;
+        args[i].duration = duration;
+        args[i].index = i;
+        args[i].conns = total / threads + (i < total % threads ? 1 : 0);
+        args[i].conn_base = base;
+        args[i].rate = rate > 0 ? rate / threads : 0;
+        args[i].init = init;
+        args[i].fini = fini;
+        latency_reset(&args[i].stats);
+        base += args[i].conns;
+        pthread_create(&tids[i], NULL, mux_thread, &args[i]);
+    }
+
+    latency_stats_t stats;
+    latency_reset(&stats);
+    int established = 0, failed = 0, dropped = 0;
+    uint64_t ramp_ns = 0, steady_ns = 0;
+    double cpu_s = 0.0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        latency_merge(&stats, &args[i].stats);
+        established += args[i].established;
+        failed += args[i].failed;
+        dropped += args[i].dropped;
+        if (args[i].ramp_ns > ramp_ns) ramp_ns = args[i].ramp_ns;
+        if (args[i].steady_ns > steady_ns) steady_ns = args[i].steady_ns;
+        cpu_s += args[i].steady_cpu_s;
+    }
+    interval_stop();
+
+    // Throughput and CPU cover the steady phase only; ramp-up is reported apart
+    double steady_s = steady_ns ? (double)steady_ns / 1e9 : (double)(now_ns() - wall_start) / 1e9;
+
+    char profile[160];
+    socket_profile_describe(&bench_opts.profile, profile, sizeof(profile));
+    print_client_summary(label, profile, &stats, steady_s, cpu_s);
+    printf("MUX connections=%d established=%d failed=%d dropped=%d ramp_s=%.3f client_rss_kb=%ld\n",
+           total, established, failed, dropped, (double)ramp_ns / 1e9, process_rss_kb());
+    fflush(stdout);
+
+    free(tids);
+    free(args);
+    return 0;
+}
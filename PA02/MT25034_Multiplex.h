@@ -0,0 +1,35 @@
+#ifndef MT25034_MULTIPLEX_H
+#define MT25034_MULTIPLEX_H
+//MT25034
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+// Multiplexed client mode (--conns=N): each client thread drives many
+// non-blocking connections through one epoll instance instead of owning a
+// single blocking socket. Every connection runs the same ping-pong as the
+// one-socket client: send msg_size bytes, wait for the full echo.
+
+// How a copy strategy puts a request on the wire. All connections of a
+// thread share one instance; the payload is identical for every message,
+// so interleaved partial sends and receives cannot corrupt what is sent.
+typedef struct mux_strategy {
+    struct iovec *send_iov;
+    int send_iovcnt;
+    int send_flags;             // e.g. MSG_ZEROCOPY
+    struct iovec *recv_iov;
+    int recv_iovcnt;
+    void (*prepare)(struct mux_strategy *s);   // before each request (fill/pack)
+    void *ctx;
+} mux_strategy_t;
+
+typedef int (*mux_strategy_init_fn)(mux_strategy_t *s, size_t msg_size);
+typedef void (*mux_strategy_free_fn)(mux_strategy_t *s);
+
+// Runs the multiplexed client with bench_opts.conns connections spread over
+// `threads` threads and prints the SUMMARY and MUX lines. Returns 0 on success.
+int run_multiplexed_clients(const char *label, const char *host, int port,
+                            int threads, size_t msg_size, int duration,
+                            mux_strategy_init_fn init, mux_strategy_free_fn fini);
+
+#endif
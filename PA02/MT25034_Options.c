@@ -0,0 +1,463 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "MT25034_Churn.h"
+#include "MT25034_Handler.h"
+#include "MT25034_Hybrid.h"
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Payload.h"
+#include "MT25034_Stream.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Udp.h"
+//MT25034
+
+bench_options_t bench_opts = {
+    .busy_poll = 0,
+    .spin_us = 50,
+    .pin_cpu = -1,
+    .profile = { "default", -1, -1, -1, -1, -1, -1 },
+    .conns = 0,
+    .connect_rate = 0.0,
+    .ramp_up_s = 0.0,
+    .response = RESPONSE_ECHO,
+    .payload_tmpfile = 0,
+    .response_size = 0,
+    .handler = HANDLER_ECHO,
+    .work_ns = 1000,
+    .stack_kb = 0,
+    .buffer_pool = 0,
+    .idle_s = 0.0,
+    .hugepages = HUGEPAGES_OFF,
+    .send_mode = SEND_MODE_DEFAULT,
+    .fields = 8,
+    .field_dist = FIELD_DIST_EVEN,
+    .placement = PLACEMENT_NONE,
+    .interval_ms = 0,
+    .interval_csv = NULL,
+    .run_id = NULL,
+    .relay_delay_ms = 0.0,
+    .relay_jitter_ms = 0.0,
+    .relay_rate_mbit = 0.0,
+    .relay_reorder_pct = 0.0,
+    .relay_queue_kb = 4096,
+    .ktls = KTLS_OFF,
+    .udp_mode = UDP_MODE_SINGLE,
+    .udp_batch = 16,
+    .udp_zerocopy = 0,
+    .udp_workers = 0,
+    .ready_fd = -1,
+    .streams = 0,
+    .stream_order = STREAM_ORDER_ANY,
+    .stream_workers = 0,
+    .slow_pct = 0.0,
+    .slow_ns = 1000000,
+    .engines = "all",
+    .churn = 0,
+    .fastopen = 0,
+    .accept_mode = ACCEPT_THREAD,
+    .acceptors = 0,
+};
+
+static void usage_options(const char *prog) {
+    fprintf(stderr,
+            "Options for %s:\n"
+            "  --busy-poll        spin on non-blocking sockets (SO_BUSY_POLL where supported)\n"
+            "  --spin-us=N        max spin time in microseconds before blocking (default 50)\n"
+            "  --pin=N            pin threads to cores starting at N\n"
+            "  --profile=NAME     socket profile: default, latency, throughput, balanced\n"
+            "  --nodelay=0|1      TCP_NODELAY\n"
+            "  --quickack=0|1     TCP_QUICKACK (re-armed after every receive)\n"
+            "  --cork=0|1         hold TCP_CORK around each send call\n"
+            "  --sndbuf=BYTES     SO_SNDBUF\n"
+            "  --rcvbuf=BYTES     SO_RCVBUF\n"
+            "  --notsent-lowat=N  TCP_NOTSENT_LOWAT\n"
+            "  --conns=N          (client) multiplex N connections over epoll\n"
+            "  --connect-rate=R   (client, --conns/--churn) open at most R connections per second\n"
+            "  --ramp-up=S        (client) spread connects over S seconds\n"
+            "  --response=MODE    (server) echo, sendfile or mmap-zerocopy\n"
+            "  --payload-tmpfile  (server) payload in a temp file instead of a memfd\n"
+            "  --response-size=N  response bytes (both sides; default: same as request)\n"
+            "  --handler=NAME     (server) echo, checksum, transform or cpu\n"
+            "  --work-ns=N        (server) cost of the cpu handler per request (default 1000)\n"
+            "  --stack-kb=N       (server) connection thread stack size in KiB\n"
+            "  --buffer-pool      (server) borrow message buffers only while a request is handled\n"
+            "  --idle-s=S         (client, with --conns) keep connections idle S seconds before sending\n"
+            "  --hugepages=MODE   message buffers: off, thp or hugetlb (prefaulted 2 MiB pages)\n"
+            "  --send-mode=MODE   (ZeroCopy pair) default, copy, zerocopy or adaptive per message size\n"
+            "  --fields=N         fields per message, 1..IOV_MAX (both sides; default 8)\n"
+            "  --field-dist=NAME  field sizes: even, geometric or random (both sides)\n"
+            "  --placement=NAME   pin client/server threads by topology: none, same-core,\n"
+            "                     smt-sibling, same-llc, cross-llc or cross-node (both sides)\n"
+            "  --interval-ms=N    report messages, bytes, latency and context switches every N ms\n"
+            "  --interval-csv=F   append the interval rows to CSV file F (default: INTERVAL lines)\n"
+            "  --run-id=ID        run key written in every interval row\n"
+            "  --ktls[=CIPHER]    kernel TLS with static keys: aes-128-gcm (default), aes-256-gcm,\n"
+            "                     chacha20-poly1305 or off (both sides)\n"
+            "  --udp=MODE         (UDP pair) single, mmsg (sendmmsg/recvmmsg) or gso (UDP_SEGMENT/UDP_GRO)\n"
+            "  --batch=N          (UDP pair) datagrams per batch, 1..64 (default 16)\n"
+            "  --udp-zerocopy     (UDP pair) send with MSG_ZEROCOPY\n"
+            "  --udp-workers=N    (UDP server) SO_REUSEPORT worker threads (default: one per CPU)\n"
+            "  --delay-ms=MS      (relay) one-way delay added in each direction\n"
+            "  --jitter-ms=MS     (relay) uniform +- jitter on that delay\n"
+            "  --rate-mbit=R      (relay) bandwidth limit per direction in Mbit/s (0 = unlimited)\n"
+            "  --reorder-pct=P    (relay) percentage of chunks delivered late, stalling those behind\n"
+            "  --queue-kb=N       (relay) bytes queued per direction before reading stops (default 4096)\n"
+            "  --ready-fd=N       (server, relay) write READY to descriptor N once listening\n"
+            "  --streams=N        stream-tagged protocol with N requests in flight per connection (both sides)\n"
+            "  --stream-order=O   (with --streams) any (as they finish) or fifo (request order; both sides)\n"
+            "  --stream-workers=N (server, with --streams) request handling threads (default: one per CPU)\n"
+            "  --slow-pct=P       (client, with --streams) percentage of requests that ask for extra work\n"
+            "  --slow-ns=N        (client, with --streams) server work of those requests (default 1000000)\n"
+            "  --engine=LIST      (unified pair) copy engines: twocopy, onecopy, zerocopy, comma lists or all\n"
+            "  --churn=N          (client) N requests per connection, then reconnect (with --connect-rate)\n"
+            "  --fastopen         TCP Fast Open: first request in the SYN (both sides)\n"
+            "  --accept=MODE      (server, --churn) thread (one per connection), reuseport or prespawn\n"
+            "  --acceptors=N      (server, reuseport/prespawn) handler threads per port (default: one per CPU)\n",
+            prog);
+}
+
+// Matches "--name" or "--name=value"; sets *value to the part after '='.
+static int match_flag(const char *arg, const char *name, const char **value) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0) {
+        return 0;
+    }
+    if (arg[len] == '\0') {
+        *value = NULL;
+        return 1;
+    }
+    if (arg[len] == '=') {
+        *value = arg + len + 1;
+        return 1;
+    }
+    return 0;
+}
+
+static int need_int(const char *prog, const char *arg, const char *value) {
+    if (!value || *value == '\0') {
+        fprintf(stderr, "%s: option %s needs a value\n", prog, arg);
+        exit(EXIT_FAILURE);
+    }
+    return atoi(value);
+}
+
+static double need_double(const char *prog, const char *arg, const char *value) {
+    if (!value || *value == '\0') {
+        fprintf(stderr, "%s: option %s needs a value\n", prog, arg);
+        exit(EXIT_FAILURE);
+    }
+    return atof(value);
+}
+
+int parse_bench_options(int argc, char *argv[]) {
+    const char *profile_name = "default";
+    socket_profile_t explicit_opts = { NULL, -1, -1, -1, -1, -1, -1 };
+    int have_explicit = 0;
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = NULL;
+
+        if (strncmp(arg, "--", 2) != 0) {
+            argv[out++] = argv[i];
+            continue;
+        }
+
+        if (match_flag(arg, "--busy-poll", &value)) {
+            bench_opts.busy_poll = 1;
+        } else if (match_flag(arg, "--spin-us", &value)) {
+            bench_opts.spin_us = need_int(argv[0], arg, value);
+        } else if (match_flag(arg, "--pin", &value)) {
+            bench_opts.pin_cpu = need_int(argv[0], arg, value);
+        } else if (match_flag(arg, "--profile", &value)) {
+            if (!value || *value == '\0') {
+                fprintf(stderr, "%s: option %s needs a value\n", argv[0], arg);
+                exit(EXIT_FAILURE);
+            }
+            profile_name = value;
+        } else if (match_flag(arg, "--nodelay", &value)) {
+            explicit_opts.nodelay = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--quickack", &value)) {
+            explicit_opts.quickack = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--cork", &value)) {
+            explicit_opts.cork = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--sndbuf", &value)) {
+            explicit_opts.sndbuf = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--rcvbuf", &value)) {
+            explicit_opts.rcvbuf = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--notsent-lowat", &value)) {
+            explicit_opts.notsent_lowat = need_int(argv[0], arg, value);
+            have_explicit = 1;
+        } else if (match_flag(arg, "--stack-kb", &value)) {
+            bench_opts.stack_kb = need_int(argv[0], arg, value);
+            if (bench_opts.stack_kb < 0) {
+                fprintf(stderr, "%s: --stack-kb must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--buffer-pool", &value)) {
+            bench_opts.buffer_pool = 1;
+        } else if (match_flag(arg, "--idle-s", &value)) {
+            bench_opts.idle_s = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--hugepages", &value)) {
+            bench_opts.hugepages = value ? hugepage_mode_parse(value) : -1;
+            if (bench_opts.hugepages < 0) {
+                fprintf(stderr, "%s: unknown hugepage mode %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--send-mode", &value)) {
+            bench_opts.send_mode = value ? send_mode_parse(value) : -1;
+            if (bench_opts.send_mode < 0) {
+                fprintf(stderr, "%s: unknown send mode %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--fields", &value)) {
+            bench_opts.fields = need_int(argv[0], arg, value);
+            if (bench_opts.fields < 1 || bench_opts.fields > IOV_MAX) {
+                fprintf(stderr, "%s: --fields must be between 1 and %d\n", argv[0], IOV_MAX);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--field-dist", &value)) {
+            bench_opts.field_dist = value ? field_dist_parse(value) : -1;
+            if (bench_opts.field_dist < 0) {
+                fprintf(stderr, "%s: unknown field distribution %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--placement", &value)) {
+            bench_opts.placement = value ? placement_parse(value) : -1;
+            if (bench_opts.placement < 0) {
+                fprintf(stderr, "%s: unknown placement %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--interval-ms", &value)) {
+            bench_opts.interval_ms = need_int(argv[0], arg, value);
+            if (bench_opts.interval_ms < 0) {
+                fprintf(stderr, "%s: --interval-ms must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--interval-csv", &value)) {
+            if (!value || *value == '\0') {
+                fprintf(stderr, "%s: option %s needs a value\n", argv[0], arg);
+                exit(EXIT_FAILURE);
+            }
+            bench_opts.interval_csv = value;
+        } else if (match_flag(arg, "--run-id", &value)) {
+            if (!value || *value == '\0') {
+                fprintf(stderr, "%s: option %s needs a value\n", argv[0], arg);
+                exit(EXIT_FAILURE);
+            }
+            bench_opts.run_id = value;
+        } else if (match_flag(arg, "--ktls", &value)) {
+            bench_opts.ktls = value ? ktls_parse(value) : KTLS_AES_128_GCM;
+            if (bench_opts.ktls < 0) {
+                fprintf(stderr, "%s: unknown kTLS cipher %s\n", argv[0], value);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--udp", &value)) {
+            bench_opts.udp_mode = value ? udp_mode_parse(value) : -1;
+            if (bench_opts.udp_mode < 0) {
+                fprintf(stderr, "%s: unknown UDP mode %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--batch", &value)) {
+            bench_opts.udp_batch = need_int(argv[0], arg, value);
+            if (bench_opts.udp_batch < 1 || bench_opts.udp_batch > UDP_MAX_BATCH) {
+                fprintf(stderr, "%s: --batch must be between 1 and %d\n", argv[0], UDP_MAX_BATCH);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--udp-zerocopy", &value)) {
+            bench_opts.udp_zerocopy = 1;
+        } else if (match_flag(arg, "--udp-workers", &value)) {
+            bench_opts.udp_workers = need_int(argv[0], arg, value);
+            if (bench_opts.udp_workers < 0) {
+                fprintf(stderr, "%s: --udp-workers must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--delay-ms", &value)) {
+            bench_opts.relay_delay_ms = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--jitter-ms", &value)) {
+            bench_opts.relay_jitter_ms = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--rate-mbit", &value)) {
+            bench_opts.relay_rate_mbit = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--reorder-pct", &value)) {
+            bench_opts.relay_reorder_pct = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--queue-kb", &value)) {
+            bench_opts.relay_queue_kb = need_int(argv[0], arg, value);
+            if (bench_opts.relay_queue_kb < 16) {
+                fprintf(stderr, "%s: --queue-kb must be at least 16\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--ready-fd", &value)) {
+            bench_opts.ready_fd = need_int(argv[0], arg, value);
+        } else if (match_flag(arg, "--streams", &value)) {
+            bench_opts.streams = need_int(argv[0], arg, value);
+            if (bench_opts.streams < 0 || bench_opts.streams > STREAM_MAX) {
+                fprintf(stderr, "%s: --streams must be between 0 and %d\n", argv[0], STREAM_MAX);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--stream-order", &value)) {
+            bench_opts.stream_order = value ? stream_order_parse(value) : -1;
+            if (bench_opts.stream_order < 0) {
+                fprintf(stderr, "%s: unknown stream order %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--stream-workers", &value)) {
+            bench_opts.stream_workers = need_int(argv[0], arg, value);
+            if (bench_opts.stream_workers < 0) {
+                fprintf(stderr, "%s: --stream-workers must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--slow-pct", &value)) {
+            bench_opts.slow_pct = need_double(argv[0], arg, value);
+            if (bench_opts.slow_pct < 0.0 || bench_opts.slow_pct > 100.0) {
+                fprintf(stderr, "%s: --slow-pct must be between 0 and 100\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--slow-ns", &value)) {
+            bench_opts.slow_ns = need_int(argv[0], arg, value);
+            if (bench_opts.slow_ns < 0) {
+                fprintf(stderr, "%s: --slow-ns must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--engine", &value)) {
+            if (!value || *value == '\0') {
+                fprintf(stderr, "%s: option %s needs a value\n", argv[0], arg);
+                exit(EXIT_FAILURE);
+            }
+            bench_opts.engines = value;
+        } else if (match_flag(arg, "--churn", &value)) {
+            bench_opts.churn = need_int(argv[0], arg, value);
+            if (bench_opts.churn < 0) {
+                fprintf(stderr, "%s: --churn must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--fastopen", &value)) {
+            bench_opts.fastopen = 1;
+        } else if (match_flag(arg, "--acceptors", &value)) {
+            bench_opts.acceptors = need_int(argv[0], arg, value);
+            if (bench_opts.acceptors < 0) {
+                fprintf(stderr, "%s: --acceptors must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--accept", &value)) {
+            bench_opts.accept_mode = value ? accept_mode_parse(value) : -1;
+            if (bench_opts.accept_mode < 0) {
+                fprintf(stderr, "%s: unknown accept mode %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--conns", &value)) {
+            bench_opts.conns = need_int(argv[0], arg, value);
+            if (bench_opts.conns < 1) {
+                fprintf(stderr, "%s: --conns must be at least 1\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--connect-rate", &value)) {
+            bench_opts.connect_rate = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--ramp-up", &value)) {
+            bench_opts.ramp_up_s = need_double(argv[0], arg, value);
+        } else if (match_flag(arg, "--response", &value)) {
+            bench_opts.response = value ? response_mode_parse(value) : -1;
+            if (bench_opts.response < 0) {
+                fprintf(stderr, "%s: unknown response mode %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--payload-tmpfile", &value)) {
+            bench_opts.payload_tmpfile = 1;
+        } else if (match_flag(arg, "--response-size", &value)) {
+            int n = need_int(argv[0], arg, value);
+            if (n < 0) {
+                fprintf(stderr, "%s: --response-size must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            bench_opts.response_size = (size_t)n;
+        } else if (match_flag(arg, "--handler", &value)) {
+            bench_opts.handler = value ? handler_parse(value) : -1;
+            if (bench_opts.handler < 0) {
+                fprintf(stderr, "%s: unknown handler %s\n", argv[0], value ? value : "");
+                exit(EXIT_FAILURE);
+            }
+        } else if (match_flag(arg, "--work-ns", &value)) {
+            bench_opts.work_ns = need_int(argv[0], arg, value);
+            if (bench_opts.work_ns < 0) {
+                fprintf(stderr, "%s: --work-ns must not be negative\n", argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(arg, "--help") == 0) {
+            usage_options(argv[0]);
+            exit(EXIT_SUCCESS);
+        } else {
+            fprintf(stderr, "%s: unknown option %s\n", argv[0], arg);
+            usage_options(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    argv[out] = NULL;
+
+    // Named profile first, explicit flags on top regardless of their order
+    if (socket_profile_named(profile_name, &bench_opts.profile) < 0) {
+        fprintf(stderr, "%s: unknown socket profile %s\n", argv[0], profile_name);
+        exit(EXIT_FAILURE);
+    }
+    if (have_explicit) {
+        socket_profile_override(&bench_opts.profile, &explicit_opts);
+        bench_opts.profile.name = "custom";
+    }
+    // The multiplexed client sends with the engine's plain flags; only the
+    // blocking client runs the --send-mode hybrid sender
+    if (bench_opts.send_mode != SEND_MODE_DEFAULT && bench_opts.conns > 0) {
+        fprintf(stderr, "%s: --send-mode cannot be combined with --conns\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    // Stream mode owns the connection framing: one connection per thread,
+    // responses built from the request
+    if (bench_opts.streams > 0 && bench_opts.conns > 0) {
+        fprintf(stderr, "%s: --streams and --conns cannot be combined\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (bench_opts.streams > 0 && bench_opts.send_mode != SEND_MODE_DEFAULT) {
+        fprintf(stderr, "%s: --send-mode cannot be combined with --streams\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (bench_opts.streams > 0 && bench_opts.response != RESPONSE_ECHO) {
+        fprintf(stderr, "%s: --streams needs --response=echo\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    // Churn opens its own connections, one at a time per thread
+    if (bench_opts.churn > 0 && (bench_opts.conns > 0 || bench_opts.streams > 0)) {
+        fprintf(stderr, "%s: --churn cannot be combined with --conns or --streams\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (bench_opts.churn > 0 && bench_opts.send_mode != SEND_MODE_DEFAULT) {
+        fprintf(stderr, "%s: --send-mode cannot be combined with --churn\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    // A reuseport/prespawn handler serves one connection to completion, and
+    // SO_REUSEPORT picks its listener by address hash, not by which handler
+    // is idle: a long-lived connection could wait behind another for good
+    if (bench_opts.accept_mode != ACCEPT_THREAD && bench_opts.churn == 0) {
+        fprintf(stderr, "%s: --accept=%s needs --churn\n", argv[0],
+                accept_mode_name(bench_opts.accept_mode));
+        exit(EXIT_FAILURE);
+    }
+    // kTLS keys go on an established connection; a Fast Open connect()
+    // returns before the handshake
+    if (bench_opts.fastopen && bench_opts.ktls != KTLS_OFF) {
+        fprintf(stderr, "%s: --fastopen cannot be combined with --ktls\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    return out;
+}
+
+size_t response_size_for(size_t msg_size) {
+    return bench_opts.response_size > 0 ? bench_opts.response_size : msg_size;
+}
@@ -0,0 +1,65 @@
+#ifndef MT25034_OPTIONS_H
+#define MT25034_OPTIONS_H
+//MT25034
+
+#include "MT25034_SockProfile.h"
+
+// Optional "--name[=value]" flags shared by all clients and servers.
+// They may appear anywhere on the command line; parse_bench_options()
+// removes them so the positional arguments keep their usual meaning.
+typedef struct {
+    int busy_poll;      // non-blocking sockets, spin on recv instead of sleeping
+    int spin_us;        // max spin budget before falling back to poll()
+    int pin_cpu;        // first core to pin threads to, -1 leaves it to the scheduler
+    socket_profile_t profile;   // TCP/socket options for every connection
+    int conns;          // clients: total connections multiplexed over epoll, 0 = one per thread
+    double connect_rate;    // clients (--conns, --churn): new connections per second, 0 = as fast as possible
+    double ramp_up_s;   // clients: spread connects over this many seconds
+    int response;       // servers: RESPONSE_* from MT25034_Payload.h
+    int payload_tmpfile;    // servers: back the payload with a temp file, not a memfd
+    size_t response_size;   // response bytes, 0 = same as the request (msg_size)
+    int handler;        // servers: HANDLER_* from MT25034_Handler.h
+    long work_ns;       // servers: cost of the "cpu" handler per request
+    int stack_kb;       // servers: connection thread stack size, 0 = system default
+    int buffer_pool;    // servers: borrow message buffers per request from a shared pool
+    double idle_s;      // clients (--conns): hold connections idle this long before sending
+    int hugepages;      // HUGEPAGES_* from MT25034_MsgBuf.h for message buffers
+    int send_mode;      // ZeroCopy pair: SEND_MODE_* from MT25034_Hybrid.h
+    int fields;         // scatter/gather fields per message (both sides), 1..IOV_MAX
+    int field_dist;     // FIELD_DIST_* from MT25034_Message.h
+    int placement;      // PLACEMENT_* from MT25034_Topology.h, overrides pin_cpu
+    int interval_ms;    // time-series period, 0 = aggregate summary only
+    const char *interval_csv;   // append interval rows here instead of stdout
+    const char *run_id;         // key of this run in the interval rows
+    double relay_delay_ms;  // relay: one-way delay added in each direction
+    double relay_jitter_ms; // relay: uniform +- variation of that delay
+    double relay_rate_mbit; // relay: bandwidth of each direction, 0 = unlimited
+    double relay_reorder_pct;   // relay: percentage of chunks held back out of turn
+    int relay_queue_kb;     // relay: bytes queued per direction before reading stops
+    int ktls;           // KTLS_* from MT25034_Tls.h, same cipher on both sides
+    int udp_mode;       // UDP pair: UDP_MODE_* from MT25034_Udp.h
+    int udp_batch;      // UDP pair: datagrams per batch, 1..UDP_MAX_BATCH
+    int udp_zerocopy;   // UDP pair: MSG_ZEROCOPY sends
+    int udp_workers;    // UDP server: SO_REUSEPORT sockets/threads, 0 = one per CPU
+    int ready_fd;       // servers/relay: write "READY" here once listening, -1 = none
+    int streams;        // stream-tagged requests in flight per connection, 0 = plain ping-pong
+    int stream_order;   // STREAM_ORDER_* from MT25034_Stream.h (servers apply it)
+    int stream_workers; // servers: threads handling stream requests, 0 = one per CPU
+    double slow_pct;    // clients (--streams): percentage of requests asking for slow_ns of work
+    long slow_ns;       // extra server work of those slow requests
+    const char *engines;    // unified pair: copy engines, "NAME[,NAME...]" or "all"
+    int churn;          // clients: requests per connection before reconnecting, 0 = one connection
+    int fastopen;       // TCP Fast Open on connects (client) and listeners (server)
+    int accept_mode;    // servers: ACCEPT_* from MT25034_Churn.h
+    int acceptors;      // servers (reuseport/prespawn): handler threads per port, 0 = one per CPU
+} bench_options_t;
+
+extern bench_options_t bench_opts;
+
+// Returns the new argc; exits on an unknown flag.
+int parse_bench_options(int argc, char *argv[]);
+
+// Response size for a request of msg_size bytes (--response-size or msg_size).
+size_t response_size_for(size_t msg_size);
+
+#endif
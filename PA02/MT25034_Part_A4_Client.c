@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include "MT25034_Interval.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Transport.h"
+#include "MT25034_Udp.h"
+
+#define PORT 8083
+
+// Echoes still missing this long after their batch was sent are left for
+// later; whatever has not arrived by the end of the run is lost
+#define ECHO_TIMEOUT_MS 20
+
+typedef struct {
+    const char *host;
+    int port;
+    size_t msg_size;
+    int duration;
+    int index;
+    latency_stats_t stats;
+    udp_endpoint_t ep;
+    uint64_t next_seq;
+    uint64_t highest_seq;
+    uint64_t received;
+    uint64_t reordered;
+    int gro;
+} thread_args_t;
+
+// One echoed datagram: a sequence number below one already seen arrived
+// out of order
+static void on_echo(void *ctx, udp_dgram_t *d) {
+    thread_args_t *args = (thread_args_t *)ctx;
+    udp_header_t h;
+    if (d->len < sizeof(h)) {
+        return;
+    }
+    memcpy(&h, d->data, sizeof(h));
+    if (h.flow != (uint32_t)args->index || h.seq >= args->next_seq) {
+        return;
+    }
+    if (args->received > 0 && h.seq < args->highest_seq) {
+        args->reordered++;
+    } else {
+        args->highest_seq = h.seq;
+    }
+    args->received++;
+
+    uint64_t ns = now_ns() - h.sent_ns;
+    latency_record(&args->stats, ns);
+    args->stats.bytes += d->len;
+    interval_record(args->index, ns, d->len);
+}
+
+// Receives until `want` more echoes are in or timeout_ms has passed
+static int collect_echoes(thread_args_t *args, uint64_t want, int timeout_ms) {
+    uint64_t goal = args->received + want;
+    uint64_t deadline = now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    while (args->received < goal) {
+        uint64_t now = now_ns();
+        if (now >= deadline) {
+            break;
+        }
+        int left_ms = (int)((deadline - now + 999999ULL) / 1000000ULL);
+        if (udp_recv(&args->ep, left_ms, on_echo, args) < 0) {
+            perror("udp receive");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void *send_messages(void *arg) {
+    thread_args_t *args = (thread_args_t *)arg;
+    int sock = 0;
+    struct sockaddr_in serv_addr = {0};
+    int batch = bench_opts.udp_batch;
+
+    transport_pin_thread(args->index);
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+        perror("Socket creation error");
+        return NULL;
+    }
+
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(args->port);
+    if (inet_pton(AF_INET, args->host, &serv_addr.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        close(sock);
+        return NULL;
+    }
+
+    // A connected UDP socket only sees datagrams from the server
+    transport_prepare_socket(sock);
+    if (connect(sock, (struct sockaddr *)&serv_addr, sizeof(serv_addr)) < 0) {
+        perror("Connection Failed");
+        close(sock);
+        return NULL;
+    }
+
+    // One batch back to back, so gso mode can send it as one buffer
+    char *area = msgbuf_alloc(args->msg_size * (size_t)batch);
+    if (!area || udp_endpoint_init(&args->ep, sock, args->msg_size, 1) < 0) {
+        perror("malloc failed");
+        msgbuf_free(area);
+        udp_endpoint_free(&args->ep);
+        close(sock);
+        return NULL;
+    }
+    args->gro = args->ep.gro;
+    memset(area, 'a' + args->index % 26, args->msg_size * (size_t)batch);
+
+    udp_dgram_t dgrams[UDP_MAX_BATCH];
+    for (int i = 0; i < batch; i++) {
+        dgrams[i].data = area + (size_t)i * args->msg_size;
+        dgrams[i].len = args->msg_size;
+    }
+
+    time_t end_time = time(NULL) + args->duration;
+    while (time(NULL) < end_time) {
+        // Zero-copy sends of the last batch must be done before it is rewritten
+        udp_release(&args->ep);
+        uint64_t start = now_ns();
+        for (int i = 0; i < batch; i++) {
+            udp_header_t h = { (uint32_t)args->index, (uint32_t)args->msg_size, args->next_seq++, start };
+            memcpy(dgrams[i].data, &h, sizeof(h));
+        }
+        int sent = udp_send(&args->ep, dgrams, batch);
+        if (sent < 0) {
+            perror("udp send");
+            break;
+        }
+        if (collect_echoes(args, (uint64_t)sent, ECHO_TIMEOUT_MS) < 0) {
+            break;
+        }
+    }
+    // Stragglers from the last batches
+    collect_echoes(args, args->next_seq - args->received, ECHO_TIMEOUT_MS);
+
+    udp_release(&args->ep);
+    close(sock);
+    msgbuf_free(area);
+    udp_endpoint_free(&args->ep);
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1";
+    int port = PORT;
+    int threads = 1;
+    size_t msg_size = 128;
+    int duration = 10;
+
+    argc = parse_bench_options(argc, argv);
+    if (argc > 1) {
+        host = argv[1];
+    }
+    if (argc > 2) {
+        port = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        threads = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        msg_size = (size_t)atoi(argv[4]);
+    }
+    if (argc > 5) {
+        duration = atoi(argv[5]);
+    }
+
+    if (msg_size < sizeof(udp_header_t) || msg_size > UDP_MAX_PAYLOAD) {
+        fprintf(stderr, "UDP message size must be between %zu and %d bytes\n",
+                sizeof(udp_header_t), UDP_MAX_PAYLOAD);
+        return -1;
+    }
+    if (bench_opts.ktls != KTLS_OFF) {
+        fprintf(stderr, "kTLS is TCP-only; the UDP pair runs in plaintext\n");
+        bench_opts.ktls = KTLS_OFF;
+    }
+    if (bench_opts.streams > 0) {
+        fprintf(stderr, "--streams is TCP-only; the UDP pair keeps one request per datagram\n");
+        bench_opts.streams = 0;
+    }
+    if (bench_opts.churn > 0) {
+        fprintf(stderr, "--churn is TCP-only; UDP has no connections to set up\n");
+        bench_opts.churn = 0;
+    }
+
+    pthread_t *thread_ids = malloc(sizeof(pthread_t) * (size_t)threads);
+    thread_args_t *args = calloc((size_t)threads, sizeof(thread_args_t));
+    if (!thread_ids || !args) {
+        perror("malloc failed");
+        free(thread_ids);
+        free(args);
+        return -1;
+    }
+
+    interval_start("client", "UDP");
+    uint64_t wall_start = now_ns();
+    double cpu_start = process_cpu_seconds();
+
+    for (int i = 0; i < threads; i++) {
+        args[i].host = host;
+        args[i].port = port;
+        args[i].msg_size = msg_size;
+        args[i].duration = duration;
+        args[i].index = i;
+        latency_reset(&args[i].stats);
+        pthread_create(&thread_ids[i], NULL, send_messages, &args[i]);
+    }
+
+    for (int i = 0; i < threads; i++) {
+        pthread_join(thread_ids[i], NULL);
+    }
+    interval_stop();
+
+    latency_stats_t total;
+    latency_reset(&total);
+    uint64_t sent = 0, received = 0, reordered = 0, send_calls = 0, recv_calls = 0, gro_buffers = 0;
+    zc_counters_t zc = {0};
+    for (int i = 0; i < threads; i++) {
+        latency_merge(&total, &args[i].stats);
+        sent += args[i].next_seq;
+        received += args[i].received;
+        reordered += args[i].reordered;
+        send_calls += args[i].ep.send_calls;
+        recv_calls += args[i].ep.recv_calls;
+        gro_buffers += args[i].ep.gro_buffers;
+        zc.sends += args[i].ep.zc.sends;
+        zc.copied += args[i].ep.zc.copied;
+    }
+    char profile[160];
+    socket_profile_describe(&bench_opts.profile, profile, sizeof(profile));
+    print_client_summary("UDP", profile, &total,
+                         (double)(now_ns() - wall_start) / 1e9,
+                         process_cpu_seconds() - cpu_start);
+
+    uint64_t lost = sent > received ? sent - received : 0;
+    printf("UDP mode=%s batch=%d gro=%d zerocopy=%d sent=%llu received=%llu lost=%llu loss_pct=%.3f "
+           "reordered=%llu send_calls=%llu recv_calls=%llu gro_buffers=%llu zc_sends=%llu zc_copied=%llu\n",
+           udp_mode_name(bench_opts.udp_mode), bench_opts.udp_batch, threads > 0 ? args[0].gro : 0,
+           bench_opts.udp_zerocopy, (unsigned long long)sent, (unsigned long long)received,
+           (unsigned long long)lost, sent ? 100.0 * (double)lost / (double)sent : 0.0,
+           (unsigned long long)reordered, (unsigned long long)send_calls,
+           (unsigned long long)recv_calls, (unsigned long long)gro_buffers,
+           (unsigned long long)zc.sends, (unsigned long long)zc.copied);
+    fflush(stdout);
+
+    free(thread_ids);
+    free(args);
+    return 0;
+}
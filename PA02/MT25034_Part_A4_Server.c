@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "MT25034_Handler.h"
+#include "MT25034_Interval.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+#include "MT25034_Udp.h"
+
+#define PORT 8083
+
+typedef struct {
+    int sock;
+    int index;
+    udp_endpoint_t ep;
+    udp_dgram_t *pending;   // echoes of the current receive batch
+    int npending;
+    int capacity;
+    uint64_t served;        // when the first of them was received
+} worker_t;
+
+// Runs the handler over each payload and echoes the batch to its senders
+static void flush_echoes(worker_t *w) {
+    if (w->npending == 0) {
+        return;
+    }
+    for (int i = 0; i < w->npending; i++) {
+        udp_dgram_t *d = &w->pending[i];
+        if (d->len > sizeof(udp_header_t)) {
+            char *field = d->data + sizeof(udp_header_t);
+            size_t len = d->len - sizeof(udp_header_t);
+            run_handler(&field, &len, 1);
+        }
+    }
+    if (udp_send(&w->ep, w->pending, w->npending) < 0) {
+        perror("udp send");
+    }
+    // The receive buffers are the zero-copy send buffers
+    udp_release(&w->ep);
+    if (bench_opts.interval_ms > 0) {
+        uint64_t ns = now_ns() - w->served;
+        for (int i = 0; i < w->npending; i++) {
+            interval_record(w->index, ns, w->pending[i].len);
+        }
+    }
+    w->npending = 0;
+}
+
+static void on_request(void *ctx, udp_dgram_t *d) {
+    worker_t *w = (worker_t *)ctx;
+    if (w->npending == w->capacity) {
+        flush_echoes(w);
+    }
+    if (w->npending == 0) {
+        w->served = now_ns();
+    }
+    w->pending[w->npending++] = *d;
+}
+
+static void *udp_worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+    transport_pin_thread(w->index);
+    for (;;) {
+        int n = udp_recv(&w->ep, -1, on_request, w);
+        if (n < 0) {
+            perror("udp receive");
+            break;
+        }
+        flush_echoes(w);
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int port = PORT;
+    size_t msg_size = 128;
+
+    argc = parse_bench_options(argc, argv);
+    placement_set_role(ROLE_SERVER);
+    if (argc > 1) {
+        port = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        msg_size = (size_t)atoi(argv[2]);
+    }
+
+    if (msg_size < sizeof(udp_header_t) || msg_size > UDP_MAX_PAYLOAD) {
+        fprintf(stderr, "UDP message size must be between %zu and %d bytes\n",
+                sizeof(udp_header_t), UDP_MAX_PAYLOAD);
+        exit(EXIT_FAILURE);
+    }
+    if (bench_opts.ktls != KTLS_OFF) {
+        fprintf(stderr, "kTLS is TCP-only; the UDP pair runs in plaintext\n");
+        bench_opts.ktls = KTLS_OFF;
+    }
+    if (bench_opts.streams > 0) {
+        fprintf(stderr, "--streams is TCP-only; the UDP pair keeps one request per datagram\n");
+        bench_opts.streams = 0;
+    }
+
+    int workers = bench_opts.udp_workers;
+    if (workers <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = ncpu > 0 ? (int)ncpu : 1;
+    }
+    worker_t *w = calloc((size_t)workers, sizeof(worker_t));
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)workers);
+    if (!w || !tids) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // One socket per worker; SO_REUSEPORT spreads the clients over them
+    for (int i = 0; i < workers; i++) {
+        int sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock < 0) {
+            perror("Socket failed");
+            exit(EXIT_FAILURE);
+        }
+        int opt = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+        transport_prepare_socket(sock);
+
+        struct sockaddr_in address = {0};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = INADDR_ANY;
+        address.sin_port = htons(port);
+        if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+            perror("Bind failed");
+            exit(EXIT_FAILURE);
+        }
+
+        w[i].sock = sock;
+        w[i].index = i;
+        if (udp_endpoint_init(&w[i].ep, sock, msg_size, 0) < 0) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        // Every datagram of a full batch of GRO buffers
+        w[i].capacity = w[i].ep.batch * (int)(w[i].ep.rx_len / msg_size + 1);
+        w[i].pending = malloc(sizeof(udp_dgram_t) * (size_t)w[i].capacity);
+        if (!w[i].pending) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    printf("Server listening on port %d (UDP, %s, %d workers)\n",
+           port, udp_mode_name(bench_opts.udp_mode), workers);
+    fflush(stdout);
+    transport_signal_ready();
+    interval_start("server", "UDP");
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&tids[i], NULL, udp_worker, &w[i]) != 0) {
+            perror("pthread_create failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    return 0;
+}
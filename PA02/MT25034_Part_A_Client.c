@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MT25034_Client.h"
+#include "MT25034_Engine.h"
+#include "MT25034_Options.h"
+//MT25034
+
+#define PORT 8080
+
+// Unified client: runs each --engine back to back in this process, engine
+// i of the registry against port + i of the unified server, and prints a
+// SUMMARY per engine
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1";
+    int port = PORT;
+    int threads = 1;
+    size_t msg_size = 128;
+    int duration = 10;
+
+    argc = parse_bench_options(argc, argv);
+    if (argc > 1) {
+        host = argv[1];
+    }
+    if (argc > 2) {
+        port = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        threads = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        msg_size = (size_t)atoi(argv[4]);
+    }
+    if (argc > 5) {
+        duration = atoi(argv[5]);
+    }
+
+    const copy_engine_t *engines[ENGINE_MAX];
+    int count = engine_list_parse(bench_opts.engines, engines);
+    if (count < 0) {
+        fprintf(stderr, "%s: unknown engine in %s\n", argv[0], bench_opts.engines);
+        return -1;
+    }
+
+    int status = 0;
+    for (int i = 0; i < count; i++) {
+        int rc = run_engine_clients(engines[i], host, port + engine_index(engines[i]),
+                                    threads, msg_size, duration);
+        if (rc < 0) {
+            status = -1;
+        }
+        fflush(stdout);
+    }
+    return status;
+}
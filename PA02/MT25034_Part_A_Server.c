@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MT25034_Engine.h"
+#include "MT25034_Options.h"
+#include "MT25034_Server.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+#define PORT 8080
+
+// Unified server: serves every --engine at once, engine i of the registry
+// on port + i, so one process answers all of the unified client's runs
+int main(int argc, char *argv[]) {
+    int port = PORT;
+    size_t msg_size = 128;
+
+    argc = parse_bench_options(argc, argv);
+    placement_set_role(ROLE_SERVER);
+    if (argc > 1) {
+        port = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        msg_size = (size_t)atoi(argv[2]);
+    }
+
+    const copy_engine_t *engines[ENGINE_MAX];
+    int ports[ENGINE_MAX];
+    int count = engine_list_parse(bench_opts.engines, engines);
+    if (count < 0) {
+        fprintf(stderr, "%s: unknown engine in %s\n", argv[0], bench_opts.engines);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        ports[i] = port + engine_index(engines[i]);
+    }
+
+    run_engine_server(engines, ports, count, msg_size);
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,830 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "MT25034_Message.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+// Microbenchmarks of the message and transport primitives, one at a time,
+// on a pinned thread: layout computation, field allocation, pack/unpack,
+// iovec setup, and send_all/recv_all and sendmsg_all/recvmsg_all over
+// socketpairs and a loopback TCP pair. Each sample times a batch of calls
+// sized to dwarf the timer's own cost; after a warmup, samples more than
+// OUTLIER_MADS robust deviations from the median are dropped before the
+// summary.
+//
+// With --calibrate it instead measures the memory hierarchy: memcpy, load
+// and store bandwidth and dependent-load latency in a working set sized for
+// each cache level and for DRAM, plus a one-byte loopback round trip. These
+// feed the copy-cost model (MT25034_Part_D_CostModel.py).
+//
+// Usage: MT25034_Part_C_MicroBench [--sizes=LIST] [--samples=N] [--cpu=N]
+//                                  [--only=NAME] [--csv=FILE] [--calibrate]
+//                                  [benchmark options]
+// Benchmark options (--fields, --field-dist, --busy-poll, ...) apply as in
+// the clients and servers.
+
+#define MAX_SIZES 32
+#define SAMPLE_NS 20000         // target length of one timed batch
+#define WARMUP_NS 20000000      // untimed calls before sampling
+#define OUTLIER_MADS 5.0        // in units of 1.4826 * MAD (one sigma if normal)
+
+typedef struct {
+    size_t msg_size;
+    msg_layout_t layout;
+    Message msg;
+    char *buffer;
+    struct iovec *iov;
+    struct iovec *part;         // scratch for one chunk of iov
+    int unix_fd[2];
+    int tcp_fd[2];
+    size_t unix_chunk;          // bytes a pair can hold in flight, see pair_chunk()
+    size_t tcp_chunk;
+} bench_ctx_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(void *ctx);     // a bench_ctx_t, or a calib_ctx_t for --calibrate
+} bench_t;
+
+typedef struct {
+    int samples;
+    int rejected;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+    double stddev_ns;
+    double ci95_ns;
+    double p99_ns;
+} bench_summary_t;
+
+static double tsc_ghz;          // TSC ticks per ns, 0 = clock_gettime timing
+
+// Keeps the compiler from dropping or merging calls whose results are unused
+#define CLOBBER() __asm__ __volatile__("" ::: "memory")
+
+static inline uint64_t ticks_begin(void) {
+#ifdef HAVE_TSC
+    if (tsc_ghz > 0) {
+        _mm_lfence();
+        return __rdtsc();
+    }
+#endif
+    return now_ns();
+}
+
+static inline uint64_t ticks_end(void) {
+#ifdef HAVE_TSC
+    if (tsc_ghz > 0) {
+        unsigned aux;
+        uint64_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+    }
+#endif
+    return now_ns();
+}
+
+static double ticks_to_ns(uint64_t ticks) {
+    return tsc_ghz > 0 ? (double)ticks / tsc_ghz : (double)ticks;
+}
+
+// TSC rate against CLOCK_MONOTONIC over 50 ms; stays 0 (clock_gettime) when
+// the CPU has no invariant TSC
+static void calibrate_tsc(void) {
+#ifdef HAVE_TSC
+    unsigned eax, ebx, ecx, edx;
+    __asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000000u));
+    if (eax < 0x80000007u) {
+        return;
+    }
+    __asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0x80000007u));
+    if (!(edx & (1u << 8))) {
+        return;
+    }
+    uint64_t ns0 = now_ns();
+    uint64_t t0 = __rdtsc();
+    while (now_ns() - ns0 < 50000000ULL) {
+    }
+    uint64_t ns1 = now_ns();
+    uint64_t t1 = __rdtsc();
+    tsc_ghz = (double)(t1 - t0) / (double)(ns1 - ns0);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Primitives
+// ---------------------------------------------------------------------------
+
+static void bench_compute_field_sizes(void *ctx) {
+    bench_ctx_t *c = ctx;
+    msg_layout_t l;
+    if (compute_field_sizes(&l, c->msg_size) == 0) {
+        CLOBBER();
+        free_field_sizes(&l);
+    }
+}
+
+static void bench_allocate_message(void *ctx) {
+    bench_ctx_t *c = ctx;
+    Message m;
+    if (allocate_message(&m, &c->layout) == 0) {
+        CLOBBER();
+        free_message(&m);
+    }
+}
+
+static void bench_pack(void *ctx) {
+    bench_ctx_t *c = ctx;
+    pack_message(&c->msg, &c->layout, c->buffer);
+    CLOBBER();
+}
+
+static void bench_unpack(void *ctx) {
+    bench_ctx_t *c = ctx;
+    unpack_message(&c->msg, &c->layout, c->buffer);
+    CLOBBER();
+}
+
+static void bench_setup_iovec(void *ctx) {
+    bench_ctx_t *c = ctx;
+    setup_iovec(c->iov, &c->msg, &c->layout);
+    CLOBBER();
+}
+
+// One message into one end and out of the other on the same thread. A
+// send must not wait on the receive that follows it, so a message larger
+// than the pair can hold in flight (the kernel caps the buffers at
+// net.core.wmem_max/rmem_max) goes through in chunks that fit
+static void send_recv_all(int *fd, size_t chunk, bench_ctx_t *c) {
+    for (size_t off = 0; off < c->msg_size; off += chunk) {
+        size_t len = c->msg_size - off < chunk ? c->msg_size - off : chunk;
+        if (transport_send_all(fd[0], c->buffer + off, len) < 0 ||
+            transport_recv_all(fd[1], c->buffer + off, len) < 0) {
+            perror("send/recv failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void sendmsg_recvmsg_all(int *fd, size_t chunk, bench_ctx_t *c) {
+    struct msghdr mh = {0};
+    if (c->msg_size <= chunk) {
+        mh.msg_iov = c->iov;
+        mh.msg_iovlen = (size_t)c->layout.count;
+        if (transport_sendmsg_all(fd[0], &mh, 0) < 0 || transport_recvmsg_all(fd[1], &mh, 0) < 0) {
+            perror("sendmsg/recvmsg failed");
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
+    for (size_t off = 0; off < c->msg_size; off += chunk) {
+        // The entries from `off` on, cut after `chunk` bytes
+        int n = iov_slice(c->iov, c->layout.count, off, c->part);
+        size_t len = 0;
+        int cnt = 0;
+        while (cnt < n && len < chunk) {
+            if (c->part[cnt].iov_len > chunk - len) {
+                c->part[cnt].iov_len = chunk - len;
+            }
+            len += c->part[cnt++].iov_len;
+        }
+        mh.msg_iov = c->part;
+        mh.msg_iovlen = (size_t)cnt;
+        if (transport_sendmsg_all(fd[0], &mh, 0) < 0 || transport_recvmsg_all(fd[1], &mh, 0) < 0) {
+            perror("sendmsg/recvmsg failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void bench_send_recv_unix(void *ctx) {
+    bench_ctx_t *c = ctx;
+    send_recv_all(c->unix_fd, c->unix_chunk, c);
+}
+
+static void bench_send_recv_tcp(void *ctx) {
+    bench_ctx_t *c = ctx;
+    send_recv_all(c->tcp_fd, c->tcp_chunk, c);
+}
+
+static void bench_sendmsg_recvmsg_unix(void *ctx) {
+    bench_ctx_t *c = ctx;
+    sendmsg_recvmsg_all(c->unix_fd, c->unix_chunk, c);
+}
+
+static void bench_sendmsg_recvmsg_tcp(void *ctx) {
+    bench_ctx_t *c = ctx;
+    sendmsg_recvmsg_all(c->tcp_fd, c->tcp_chunk, c);
+}
+
+static const bench_t benches[] = {
+    { "compute_field_sizes", bench_compute_field_sizes },
+    { "allocate_message", bench_allocate_message },
+    { "pack_message", bench_pack },
+    { "unpack_message", bench_unpack },
+    { "setup_iovec", bench_setup_iovec },
+    { "send_recv_all_unix", bench_send_recv_unix },
+    { "send_recv_all_tcp", bench_send_recv_tcp },
+    { "sendmsg_recvmsg_all_unix", bench_sendmsg_recvmsg_unix },
+    { "sendmsg_recvmsg_all_tcp", bench_sendmsg_recvmsg_tcp },
+};
+#define NUM_BENCHES ((int)(sizeof(benches) / sizeof(benches[0])))
+
+// ---------------------------------------------------------------------------
+// Setup
+// ---------------------------------------------------------------------------
+
+static void size_buffers(int fd, size_t msg_size) {
+    int bytes = (int)(msg_size * 4 > 65536 ? msg_size * 4 : 65536);
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+}
+
+// Bytes one send may put into fd[0] before the matching receive on fd[1]
+// without blocking: a quarter of the smaller granted buffer, which the
+// kernel reports doubled to cover its bookkeeping. size_buffers() asks for
+// 4 x msg_size, so a message goes in one piece unless the caps cut that
+static size_t pair_chunk(const int fd[2]) {
+    int snd = 0, rcv = 0;
+    socklen_t len = sizeof(snd);
+    if (getsockopt(fd[0], SOL_SOCKET, SO_SNDBUF, &snd, &len) < 0) {
+        snd = 0;
+    }
+    len = sizeof(rcv);
+    if (getsockopt(fd[1], SOL_SOCKET, SO_RCVBUF, &rcv, &len) < 0) {
+        rcv = 0;
+    }
+    size_t chunk = (size_t)(snd < rcv ? snd : rcv) / 4;
+    return chunk > 0 ? chunk : 4096;
+}
+
+// A connected loopback TCP pair: [0] the client end, [1] the accepted end
+static int tcp_pair(int fd[2]) {
+    struct sockaddr_in addr = {0};
+    socklen_t len = sizeof(addr);
+    int lsock = socket(AF_INET, SOCK_STREAM, 0);
+    if (lsock < 0) {
+        return -1;
+    }
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(lsock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(lsock, 1) < 0 ||
+        getsockname(lsock, (struct sockaddr *)&addr, &len) < 0) {
+        close(lsock);
+        return -1;
+    }
+    fd[0] = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd[0] < 0 || connect(fd[0], (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(lsock);
+        return -1;
+    }
+    fd[1] = accept(lsock, NULL, NULL);
+    close(lsock);
+    return fd[1] < 0 ? -1 : 0;
+}
+
+static void ctx_init(bench_ctx_t *c, size_t msg_size) {
+    memset(c, 0, sizeof(*c));
+    c->msg_size = msg_size;
+    if (compute_field_sizes(&c->layout, msg_size) < 0 || allocate_message(&c->msg, &c->layout) < 0) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    fill_message_fields(&c->msg, &c->layout);
+    c->buffer = malloc(msg_size);
+    c->iov = calloc((size_t)c->layout.count, sizeof(struct iovec));
+    c->part = calloc((size_t)c->layout.count, sizeof(struct iovec));
+    if (!c->buffer || !c->iov || !c->part) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    pack_message(&c->msg, &c->layout, c->buffer);
+    setup_iovec(c->iov, &c->msg, &c->layout);
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, c->unix_fd) < 0 || tcp_pair(c->tcp_fd) < 0) {
+        perror("socket pair failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < 2; i++) {
+        size_buffers(c->unix_fd[i], msg_size);
+        size_buffers(c->tcp_fd[i], msg_size);
+        transport_setup_socket(c->tcp_fd[i]);
+    }
+    c->unix_chunk = pair_chunk(c->unix_fd);
+    c->tcp_chunk = pair_chunk(c->tcp_fd);
+}
+
+static void ctx_free(bench_ctx_t *c) {
+    for (int i = 0; i < 2; i++) {
+        close(c->unix_fd[i]);
+        close(c->tcp_fd[i]);
+    }
+    free(c->part);
+    free(c->iov);
+    free(c->buffer);
+    free_message(&c->msg);
+    free_field_sizes(&c->layout);
+}
+
+// ---------------------------------------------------------------------------
+// Measurement
+// ---------------------------------------------------------------------------
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double sorted_percentile(const double *v, int n, double pct) {
+    int i = (int)(pct / 100.0 * (n - 1) + 0.5);
+    return v[i < n ? i : n - 1];
+}
+
+// Drops samples more than OUTLIER_MADS robust deviations from the median
+// (interrupts, migrations, page faults) and summarises the rest
+static void summarise(double *v, int n, bench_summary_t *s) {
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    double median = sorted_percentile(v, n, 50.0);
+    double *dev = malloc(sizeof(double) * (size_t)n);
+    if (!dev) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++) {
+        dev[i] = fabs(v[i] - median);
+    }
+    qsort(dev, (size_t)n, sizeof(double), cmp_double);
+    double limit = OUTLIER_MADS * 1.4826 * sorted_percentile(dev, n, 50.0);
+    free(dev);
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (limit == 0.0 || fabs(v[i] - median) <= limit) {
+            v[kept++] = v[i];
+        }
+    }
+    double sum = 0.0, sq = 0.0;
+    for (int i = 0; i < kept; i++) {
+        sum += v[i];
+    }
+    s->samples = kept;
+    s->rejected = n - kept;
+    s->mean_ns = sum / kept;
+    for (int i = 0; i < kept; i++) {
+        sq += (v[i] - s->mean_ns) * (v[i] - s->mean_ns);
+    }
+    s->stddev_ns = kept > 1 ? sqrt(sq / (kept - 1)) : 0.0;
+    s->ci95_ns = kept > 1 ? 1.96 * s->stddev_ns / sqrt((double)kept) : 0.0;
+    s->min_ns = v[0];
+    s->median_ns = sorted_percentile(v, kept, 50.0);
+    s->p99_ns = sorted_percentile(v, kept, 99.0);
+}
+
+// Warms up, sizes the batch so one sample lasts about SAMPLE_NS, then takes
+// `samples` samples of ns per call
+static void measure(const bench_t *b, void *c, int samples, bench_summary_t *s) {
+    uint64_t start = now_ns();
+    while (now_ns() - start < WARMUP_NS) {
+        b->run(c);
+    }
+
+    long batch = 1;
+    for (;;) {
+        uint64_t t0 = ticks_begin();
+        for (long i = 0; i < batch; i++) {
+            b->run(c);
+        }
+        double ns = ticks_to_ns(ticks_end() - t0);
+        if (ns >= SAMPLE_NS || batch >= (1L << 20)) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    double *v = malloc(sizeof(double) * (size_t)samples);
+    if (!v) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < samples; k++) {
+        uint64_t t0 = ticks_begin();
+        for (long i = 0; i < batch; i++) {
+            b->run(c);
+        }
+        v[k] = ticks_to_ns(ticks_end() - t0) / (double)batch;
+    }
+    summarise(v, samples, s);
+    free(v);
+}
+
+// ---------------------------------------------------------------------------
+// Memory-hierarchy calibration (--calibrate)
+// ---------------------------------------------------------------------------
+
+#define CALIB_LEVELS 5          // up to three cache levels, DRAM, loopback
+#define CALIB_CHUNK (8 << 20)   // bytes one bandwidth call touches at most
+#define CALIB_HOPS 1024         // dependent loads per latency call
+#define CACHE_LINE 64
+
+// One working set: sized to sit in one cache level (or DRAM). Bandwidth
+// calls walk it CALIB_CHUNK at a time from a rotating offset, so over a
+// sample the whole set is touched and stays resident where it fits.
+typedef struct {
+    char name[16];
+    size_t cache_bytes;         // size of that cache, 0 for DRAM
+    size_t ws;                  // working set bytes
+    char *src;                  // memcpy source and destination, ws / 2 each
+    char *dst;
+    size_t offset;              // next chunk of the bandwidth calls
+    void **cursor;              // pointer chase position
+    uint64_t sink;
+    int fd[2];                  // loopback pair of the round-trip row
+} calib_ctx_t;
+
+// Data/unified cache sizes of `cpu` by level from sysfs; 0 where absent
+static void cache_sizes(int cpu, size_t size[4]) {
+    memset(size, 0, sizeof(size_t) * 4);
+    for (int i = 0; i < 16; i++) {
+        char path[128], type[32] = "";
+        int level = 0;
+        long kb = 0;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, i);
+        FILE *f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        if (fscanf(f, "%31s", type) != 1) {
+            type[0] = '\0';
+        }
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, i);
+        if ((f = fopen(path, "r"))) {
+            if (fscanf(f, "%d", &level) != 1) {
+                level = 0;
+            }
+            fclose(f);
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, i);
+        if ((f = fopen(path, "r"))) {
+            if (fscanf(f, "%ldK", &kb) != 1) {
+                kb = 0;
+            }
+            fclose(f);
+        }
+        if (strcmp(type, "Instruction") != 0 && level >= 1 && level <= 3) {
+            size[level] = (size_t)kb * 1024;
+        }
+    }
+}
+
+static size_t chunk_of(calib_ctx_t *c, size_t span) {
+    size_t n = span - c->offset < CALIB_CHUNK ? span - c->offset : CALIB_CHUNK;
+    return n;
+}
+
+static void advance(calib_ctx_t *c, size_t n, size_t span) {
+    c->offset += n;
+    if (c->offset >= span) {
+        c->offset = 0;
+    }
+}
+
+static void calib_memcpy(void *ctx) {
+    calib_ctx_t *c = ctx;
+    size_t n = chunk_of(c, c->ws / 2);
+    memcpy(c->dst + c->offset, c->src + c->offset, n);
+    CLOBBER();
+    advance(c, n, c->ws / 2);
+}
+
+static void calib_load(void *ctx) {
+    calib_ctx_t *c = ctx;
+    size_t n = chunk_of(c, c->ws);
+    const uint64_t *p = (const uint64_t *)(c->src + c->offset);
+    // Four independent sums, so the adds do not serialise the loads
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (size_t i = 0; i + 4 <= n / sizeof(uint64_t); i += 4) {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    c->sink += s0 + s1 + s2 + s3;
+    advance(c, n, c->ws);
+}
+
+static void calib_store(void *ctx) {
+    calib_ctx_t *c = ctx;
+    size_t n = chunk_of(c, c->ws);
+    memset(c->src + c->offset, (int)(c->offset & 0xff), n);
+    CLOBBER();
+    advance(c, n, c->ws);
+}
+
+static void calib_latency(void *ctx) {
+    calib_ctx_t *c = ctx;
+    void **p = c->cursor;
+    for (int i = 0; i < CALIB_HOPS; i++) {
+        p = (void **)*p;
+    }
+    c->cursor = p;
+}
+
+// One byte to an echo thread over loopback TCP and back: the fixed cost of
+// a request/response exchange without the copies
+static void calib_rtt(void *ctx) {
+    calib_ctx_t *c = ctx;
+    char b = 1;
+    if (transport_send_all(c->fd[0], &b, 1) < 0 || transport_recv_all(c->fd[0], &b, 1) < 0) {
+        perror("round trip failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void *echo_thread(void *arg) {
+    int fd = *(int *)arg;
+    // Free to run on any CPU, like a server thread
+    cpu_set_t all;
+    CPU_ZERO(&all);
+    for (int i = 0; i < CPU_SETSIZE && i < sysconf(_SC_NPROCESSORS_ONLN); i++) {
+        CPU_SET(i, &all);
+    }
+    sched_setaffinity(0, sizeof(all), &all);
+    char b;
+    while (transport_recv_all(fd, &b, 1) == 0 && transport_send_all(fd, &b, 1) == 0) {
+    }
+    return NULL;
+}
+
+// Fills the set and links its cache lines into one random cycle (Sattolo),
+// so every load of the chase misses whatever the set does not fit in
+static void calib_init(calib_ctx_t *c, const char *name, size_t cache_bytes, size_t ws) {
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->cache_bytes = cache_bytes;
+    c->ws = ws;
+    c->src = aligned_alloc(4096, ws);
+    c->dst = c->src + ws / 2;
+    if (!c->src) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    memset(c->src, 1, ws);
+
+    size_t lines = ws / CACHE_LINE;
+    size_t *order = malloc(sizeof(size_t) * lines);
+    if (!order) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < lines; i++) {
+        order[i] = i;
+    }
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = lines - 1; i > 0; i--) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        size_t j = (size_t)(x % i);
+        size_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (size_t i = 0; i < lines; i++) {
+        *(void **)(c->src + order[i] * CACHE_LINE) = c->src + order[(i + 1) % lines] * CACHE_LINE;
+    }
+    c->cursor = (void **)(c->src + order[0] * CACHE_LINE);
+    free(order);
+}
+
+// Bandwidth (GB/s, bytes per ns) of a call that moves `bytes`
+static double gbps(size_t bytes, const bench_summary_t *s) {
+    return s->median_ns > 0 ? (double)bytes / s->median_ns : 0.0;
+}
+
+static int run_calibration(int cpu, int samples, FILE *out_csv) {
+    static const bench_t bandwidth[] = {
+        { "memcpy", calib_memcpy },
+        { "load", calib_load },
+        { "store", calib_store },
+    };
+    static const bench_t latency = { "latency", calib_latency };
+    static const bench_t rtt = { "loopback_rtt", calib_rtt };
+
+    size_t cache[4];
+    cache_sizes(cpu, cache);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    // Each cache level at half its size (but past the level below), DRAM at
+    // four times the last level, at least 64 MiB and at most 1 GiB
+    const char *names[] = { "", "L1d", "L2", "L3" };
+    size_t below = 0, last = 0;
+    int nlevels = 0;
+    calib_ctx_t levels[CALIB_LEVELS];
+    for (int l = 1; l <= 3; l++) {
+        if (cache[l] == 0) {
+            continue;
+        }
+        size_t ws = cache[l] / 2 > 2 * below ? cache[l] / 2 : 2 * below;
+        calib_init(&levels[nlevels++], names[l], cache[l], ws);
+        below = cache[l];
+        last = cache[l];
+    }
+    size_t dram = 4 * last > ((size_t)64 << 20) ? 4 * last : ((size_t)64 << 20);
+    dram = dram < ((size_t)1 << 30) ? dram : ((size_t)1 << 30);
+    calib_init(&levels[nlevels++], "DRAM", 0, dram);
+
+    printf("Calibration cpu=%d online_cpus=%ld timer=%s samples=%d\n", cpu, cpus,
+           tsc_ghz > 0 ? "rdtsc" : "clock_gettime", samples);
+    printf("%-6s %10s %12s %12s %10s %10s %11s\n", "level", "cache_kb", "ws_kb", "memcpy_gbps",
+           "load_gbps", "store_gbps", "latency_ns");
+    if (out_csv) {
+        fprintf(out_csv, "Level,Cache_Bytes,Working_Set_Bytes,Memcpy_GBps,Load_GBps,Store_GBps,"
+                         "Latency_ns,Online_CPUs\n");
+    }
+
+    for (int i = 0; i < nlevels; i++) {
+        calib_ctx_t *c = &levels[i];
+        // The chase first: the bandwidth calls overwrite its links
+        bench_summary_t s;
+        measure(&latency, c, samples, &s);
+        double lat = s.median_ns / CALIB_HOPS;
+        double bw[3];
+        for (int b = 0; b < 3; b++) {
+            c->offset = 0;
+            measure(&bandwidth[b], c, samples, &s);
+            size_t moved = chunk_of(c, b == 0 ? c->ws / 2 : c->ws);
+            bw[b] = gbps(moved, &s);
+        }
+        printf("%-6s %10zu %12zu %12.2f %10.2f %10.2f %11.2f\n", c->name, c->cache_bytes / 1024,
+               c->ws / 1024, bw[0], bw[1], bw[2], lat);
+        if (out_csv) {
+            fprintf(out_csv, "%s,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%ld\n", c->name, c->cache_bytes, c->ws,
+                    bw[0], bw[1], bw[2], lat, cpus);
+        }
+        free(c->src);
+        fflush(stdout);
+    }
+
+    calib_ctx_t loop;
+    memset(&loop, 0, sizeof(loop));
+    pthread_t tid;
+    if (tcp_pair(loop.fd) < 0 || pthread_create(&tid, NULL, echo_thread, &loop.fd[1]) != 0) {
+        perror("loopback pair failed");
+        return -1;
+    }
+    transport_setup_socket(loop.fd[0]);
+    transport_setup_socket(loop.fd[1]);
+    bench_summary_t s;
+    measure(&rtt, &loop, samples, &s);
+    printf("%-6s %10s %12s %12s %10s %10s %11.2f\n", "RTT", "-", "-", "-", "-", "-", s.median_ns);
+    if (out_csv) {
+        fprintf(out_csv, "Loopback_RTT,,,,,,%.3f,%ld\n", s.median_ns, cpus);
+    }
+    close(loop.fd[0]);
+    pthread_join(tid, NULL);
+    close(loop.fd[1]);
+    return 0;
+}
+
+static int parse_sizes(const char *list, size_t *out) {
+    char *copy = strdup(list);
+    char *save = NULL;
+    int n = 0;
+    for (char *item = strtok_r(copy, ",", &save); item && n < MAX_SIZES; item = strtok_r(NULL, ",", &save)) {
+        long v = atol(item);
+        if (v <= 0) {
+            fprintf(stderr, "bad message size %s\n", item);
+            exit(EXIT_FAILURE);
+        }
+        out[n++] = (size_t)v;
+    }
+    free(copy);
+    return n;
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[MAX_SIZES];
+    int nsizes = parse_sizes("128,512,1024,4096,65536", sizes);
+    int samples = 200;
+    int cpu = -1;
+    const char *only = NULL;
+    const char *csv = NULL;
+    int calibrate = 0;
+
+    // Our own options first; the rest are benchmark options
+    int out = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--sizes=", 8) == 0) {
+            nsizes = parse_sizes(argv[i] + 8, sizes);
+        } else if (strncmp(argv[i], "--samples=", 10) == 0) {
+            samples = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--cpu=", 6) == 0) {
+            cpu = atoi(argv[i] + 6);
+        } else if (strncmp(argv[i], "--only=", 7) == 0) {
+            only = argv[i] + 7;
+        } else if (strncmp(argv[i], "--csv=", 6) == 0) {
+            csv = argv[i] + 6;
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrate = 1;
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = parse_bench_options(out, argv);
+    if (argc > 1 || samples < 10 || nsizes == 0) {
+        fprintf(stderr, "Usage: %s [--sizes=LIST] [--samples=N>=10] [--cpu=N] [--only=NAME] [--csv=FILE] "
+                        "[--calibrate] [benchmark options]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Pinned so frequency, caches and the TSC belong to one core
+    if (cpu < 0) {
+        cpu = sched_getcpu();
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+        perror("sched_setaffinity failed");
+        return EXIT_FAILURE;
+    }
+    calibrate_tsc();
+
+    FILE *out_csv = NULL;
+    if (csv) {
+        out_csv = fopen(csv, "w");
+        if (!out_csv) {
+            perror(csv);
+            return EXIT_FAILURE;
+        }
+    }
+    if (calibrate) {
+        int rc = run_calibration(cpu, samples, out_csv);
+        if (out_csv) {
+            fclose(out_csv);
+        }
+        return rc < 0 ? EXIT_FAILURE : 0;
+    }
+    if (out_csv) {
+        fprintf(out_csv, "Primitive,Message_Size,Fields,Field_Dist,Samples,Rejected,Min_ns,Median_ns,"
+                         "Mean_ns,Stddev_ns,CI95_ns,P99_ns,Median_TSC_Cycles\n");
+    }
+
+    printf("MicroBench cpu=%d timer=%s", cpu, tsc_ghz > 0 ? "rdtsc" : "clock_gettime");
+    if (tsc_ghz > 0) {
+        printf(" tsc_ghz=%.3f", tsc_ghz);
+    }
+    printf(" samples=%d fields=%d field_dist=%s\n", samples, bench_opts.fields,
+           field_dist_name(bench_opts.field_dist));
+    printf("%-26s %8s %11s %11s %9s %9s %11s %11s %8s\n", "primitive", "size", "median_ns",
+           "mean_ns", "+-ci95", "stddev", "min_ns", "p99_ns", "dropped");
+
+    for (int z = 0; z < nsizes; z++) {
+        bench_ctx_t ctx;
+        ctx_init(&ctx, sizes[z]);
+        for (int b = 0; b < NUM_BENCHES; b++) {
+            if (only && !strstr(benches[b].name, only)) {
+                continue;
+            }
+            bench_summary_t s;
+            measure(&benches[b], &ctx, samples, &s);
+            printf("%-26s %8zu %11.1f %11.1f %9.1f %9.1f %11.1f %11.1f %8d\n", benches[b].name,
+                   sizes[z], s.median_ns, s.mean_ns, s.ci95_ns, s.stddev_ns, s.min_ns, s.p99_ns, s.rejected);
+            if (out_csv) {
+                fprintf(out_csv, "%s,%zu,%d,%s,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,", benches[b].name,
+                        sizes[z], bench_opts.fields, field_dist_name(bench_opts.field_dist), s.samples,
+                        s.rejected, s.min_ns, s.median_ns, s.mean_ns, s.stddev_ns, s.ci95_ns, s.p99_ns);
+                if (tsc_ghz > 0) {
+                    fprintf(out_csv, "%.0f", s.median_ns * tsc_ghz);
+                }
+                fprintf(out_csv, "\n");
+            }
+        }
+        ctx_free(&ctx);
+        fflush(stdout);
+    }
+    if (out_csv) {
+        fclose(out_csv);
+    }
+    return 0;
+}
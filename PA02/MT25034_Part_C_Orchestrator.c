@@ -0,0 +1,1433 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#include "MT25034_Handler.h"
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+// Runs the experiment matrix natively: every cell starts its server (and the
+// relay) as children, waits for their READY on --ready-fd instead of
+// sleeping, runs the client with hardware counters attached through
+// perf_event_open, and reads the client's SUMMARY/HYBRID/UDP lines. Cells
+// run --jobs at a time, each job slot on its own CPUs and ports. Results go
+// to a CSV (the columns of the old shell loop plus Status) and to a JSON
+// file with the run metadata and everything each client reported.
+//
+// Usage: MT25034_Part_C_Orchestrator [orchestrator options] [benchmark options]
+// Benchmark options (--handler, --nodelay, --fields, ...) are passed to every
+// server and client.
+
+#ifndef MT25034_CFLAGS
+#define MT25034_CFLAGS "unknown"
+#endif
+#ifndef MT25034_GIT_REV
+#define MT25034_GIT_REV "unknown"
+#endif
+
+#define MAX_ARGS 128
+#define MAX_LIST 32
+#define MAX_FIELDS 96
+// Ports of one job slot: pair N listens on base + slot * PORT_STRIDE + N - 1,
+// its relay RELAY_PORT_OFFSET above that
+#define PORT_STRIDE 10
+#define RELAY_PORT_OFFSET 5
+// Grace period on top of --duration before a client is killed
+#define CLIENT_GRACE_S 30
+
+typedef struct {
+    const char *label;
+    int pair;                   // MT25034_Part_A<pair>_Server/Client
+    const char *server_flags;
+    const char *client_flags;
+} variant_t;
+
+// Every row the shell loop could produce, in its order
+static const variant_t variants[] = {
+    { "TwoCopy", 1, "", "" },
+    { "OneCopy", 2, "", "" },
+    { "ZeroCopy", 3, "", "" },
+    { "Sendfile", 3, "--response=sendfile", "" },
+    { "MmapZeroCopy", 3, "--response=mmap-zerocopy", "" },
+    { "ZeroCopyPairCopy", 3, "--send-mode=copy", "--send-mode=copy" },
+    { "ZeroCopyEnabled", 3, "--send-mode=zerocopy", "--send-mode=zerocopy" },
+    { "Adaptive", 3, "--send-mode=adaptive", "--send-mode=adaptive" },
+    { "UDPSingle", 4, "--udp=single", "--udp=single" },
+    { "UDPMmsg", 4, "--udp=mmsg", "--udp=mmsg" },
+    { "UDPGso", 4, "--udp=gso", "--udp=gso" },
+};
+#define NUM_VARIANTS ((int)(sizeof(variants) / sizeof(variants[0])))
+
+static const char *default_labels =
+    "TwoCopy,OneCopy,ZeroCopy,Sendfile,MmapZeroCopy,ZeroCopyEnabled,Adaptive,UDPSingle,UDPMmsg,UDPGso";
+
+// Auto-tuner trials: buffer sizes x Nagle/cork settings
+static const char *default_tune_buffers = "default,65536,262144,1048576,4194304";
+static const char *default_tune_nagle = "--nodelay=1;--nodelay=0;--nodelay=0 --cork=1";
+
+enum {
+    POLL_BLOCK,
+    POLL_BUSY,
+};
+
+static const char *poll_names[] = { "block", "busypoll" };
+
+enum {
+    CTR_CYCLES,
+    CTR_INSTRUCTIONS,
+    CTR_CACHE_MISSES,
+    CTR_DTLB_MISSES,
+    CTR_CONTEXT_SWITCHES,
+    NUM_COUNTERS,
+};
+
+static const struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} counter_defs[NUM_COUNTERS] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "dTLB-load-misses", PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+// Why a counter could not be opened (first failure), NULL while it works
+static const char *counter_error[NUM_COUNTERS];
+
+typedef struct {
+    char *argv[MAX_ARGS];
+    int argc;
+} arglist_t;
+
+typedef struct {
+    const variant_t *variant;
+    int msg_size;
+    int threads;
+    int poll_mode;
+    int placement;
+    int ktls;
+    int repeat;                 // pass over the matrix, from 1
+    int seq;                    // position in the matrix, from 1
+} cell_t;
+
+typedef struct {
+    char tag[16];
+    char key[32];
+    char value[96];
+} field_t;
+
+typedef struct {
+    const char *status;         // ok, failed or timeout
+    char error[160];
+    int slot;
+    int port;
+    double elapsed_s;           // client start to exit
+    long long counters[NUM_COUNTERS];   // client process; -1 = unavailable
+    double server_cpu_s;        // server user + system time, -1 = unknown
+    field_t fields[MAX_FIELDS]; // key=value pairs of the client's tagged lines
+    int nfields;
+    char tuned_flags[128];      // socket flags chosen by --autotune
+    char server_cmd[1024];
+    char client_cmd[1024];
+} result_t;
+
+typedef struct {
+    int index;
+    cpu_set_t cpus;
+    int first_cpu;
+    int ncpus;
+} slot_t;
+
+// Orchestrator settings; the matrix is their cross product
+static struct {
+    int sizes[MAX_LIST];
+    int nsizes;
+    int threads[MAX_LIST];
+    int nthreads;
+    int polls[MAX_LIST];
+    int npolls;
+    int placements[MAX_LIST];
+    int nplacements;
+    int ktls[MAX_LIST];
+    int nktls;
+    const variant_t *variants[MAX_LIST];
+    int nvariants;
+    int duration;
+    int repeat;
+    int jobs;
+    const char *cpus;
+    int base_port;
+    int ready_timeout_s;
+    const char *relay;          // relay flags, NULL = loopback
+    int interval_ms;
+    int server_intervals;
+    const char *interval_csv;
+    int autotune;
+    int tune_duration;
+    const char *tune_buffers[MAX_LIST];     // "default" keeps the kernel's
+    int ntune_buffers;
+    const char *tune_nagle[MAX_LIST];
+    int ntune_nagle;
+    const char *autotune_csv;
+    const char *csv;
+    const char *json;
+    const char *bin_dir;
+    arglist_t forward;          // benchmark options for both sides
+} cfg = {
+    .duration = 10,
+    .repeat = 1,
+    .jobs = 1,
+    .base_port = 9000,
+    .ready_timeout_s = 5,
+    .server_intervals = 1,
+    .interval_csv = "TimeSeries_Results.csv",
+    .tune_duration = 2,
+    .autotune_csv = "Autotune_Trials.csv",
+    .csv = "Combined_Results.csv",
+    .json = "Combined_Results.json",
+    .bin_dir = ".",
+};
+
+static cell_t *cells;
+static result_t *results;
+static int ncells;
+static int next_cell;
+static char run_stamp[32];
+static pthread_mutex_t tune_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *tune_out;
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [benchmark options]\n"
+            "  --labels=LIST          rows per cell (default %s;\n"
+            "                         also ZeroCopyPairCopy)\n"
+            "  --sizes=LIST           message sizes (default 128,512,1024,4096)\n"
+            "  --threads=LIST         client threads (default 1,2,4,8)\n"
+            "  --duration=S           seconds per run (default 10)\n"
+            "  --repeat=N             passes over the whole matrix, for run-to-run variance (default 1)\n"
+            "  --poll-modes=LIST      block and/or busypoll (default both)\n"
+            "  --placements=LIST      --placement policies, each repeats the matrix (default none)\n"
+            "  --ktls-modes=LIST      --ktls ciphers, each repeats the matrix (default off)\n"
+            "  --jobs=N               cells run at once, each on its own CPUs and ports (default 1)\n"
+            "  --cpus=LIST            CPUs shared out between the jobs, e.g. 2-7 (default: all allowed)\n"
+            "  --base-port=N          first server port (default 9000)\n"
+            "  --ready-timeout=S      seconds to wait for a server to listen (default 5)\n"
+            "  --relay=FLAGS          run TCP clients through MT25034_Part_C_Relay with FLAGS\n"
+            "  --interval-ms=N        time series every N ms (default 0 = off)\n"
+            "  --interval-csv=F       time-series file (default TimeSeries_Results.csv)\n"
+            "  --server-intervals=0|1 servers write interval rows too (default 1)\n"
+            "  --autotune             sweep buffer sizes x Nagle/cork per cell first\n"
+            "  --tune-duration=S      seconds per auto-tuner trial (default 2)\n"
+            "  --tune-buffers=LIST    buffer sizes to try (default %s)\n"
+            "  --tune-nagle=LIST      ';'-separated flag sets to try (default %s)\n"
+            "  --autotune-csv=F       auto-tuner trials (default Autotune_Trials.csv)\n"
+            "  --csv=F                results (default Combined_Results.csv)\n"
+            "  --json=F               results with run metadata (default Combined_Results.json)\n"
+            "  --bin-dir=DIR          where the server/client/relay binaries are (default .)\n"
+            "Any other --option is passed to every server and client; see a client's --help.\n",
+            prog, default_labels, default_tune_buffers, default_tune_nagle);
+}
+
+// ---------------------------------------------------------------------------
+// Argument lists
+// ---------------------------------------------------------------------------
+
+static void args_add(arglist_t *a, const char *fmt, ...) {
+    if (a->argc >= MAX_ARGS - 1) {
+        fprintf(stderr, "too many arguments\n");
+        exit(EXIT_FAILURE);
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    if (vasprintf(&a->argv[a->argc], fmt, ap) < 0) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    va_end(ap);
+    a->argv[++a->argc] = NULL;
+}
+
+// Adds each space-separated word of `words`
+static void args_split(arglist_t *a, const char *words) {
+    char *copy = strdup(words ? words : "");
+    char *save = NULL;
+    for (char *w = strtok_r(copy, " ", &save); w; w = strtok_r(NULL, " ", &save)) {
+        args_add(a, "%s", w);
+    }
+    free(copy);
+}
+
+static void args_append(arglist_t *a, const arglist_t *from) {
+    for (int i = 0; i < from->argc; i++) {
+        args_add(a, "%s", from->argv[i]);
+    }
+}
+
+static void args_free(arglist_t *a) {
+    for (int i = 0; i < a->argc; i++) {
+        free(a->argv[i]);
+    }
+    a->argc = 0;
+    a->argv[0] = NULL;
+}
+
+static void args_join(const arglist_t *a, char *out, size_t len) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; i < a->argc && used < len; i++) {
+        used += (size_t)snprintf(out + used, len - used, "%s%s", i ? " " : "", a->argv[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Option parsing
+// ---------------------------------------------------------------------------
+
+static const char *opt_value(const char *arg, const char *name) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) == 0 && arg[len] == '=') {
+        return arg + len + 1;
+    }
+    return NULL;
+}
+
+static void bad_value(const char *what, const char *value) {
+    fprintf(stderr, "unknown %s %s\n", what, value);
+    exit(EXIT_FAILURE);
+}
+
+// Splits a comma-separated list; `parse` maps each item to a value, < 0 = bad
+static int parse_list(const char *list, int *out, const char *what, int (*parse)(const char *)) {
+    char *copy = strdup(list);
+    char *save = NULL;
+    int n = 0;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        if (n == MAX_LIST) {
+            fprintf(stderr, "at most %d %s values\n", MAX_LIST, what);
+            exit(EXIT_FAILURE);
+        }
+        out[n] = parse(item);
+        if (out[n] < 0) {
+            bad_value(what, item);
+        }
+        n++;
+    }
+    free(copy);
+    if (n == 0) {
+        fprintf(stderr, "empty %s list\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+// Splits `list` at `sep` into strings that live as long as the process
+static int split_strings(const char *list, const char *sep, const char **out, const char *what) {
+    char *copy = strdup(list);
+    char *save = NULL;
+    int n = 0;
+    for (char *item = strtok_r(copy, sep, &save); item; item = strtok_r(NULL, sep, &save)) {
+        if (n == MAX_LIST) {
+            fprintf(stderr, "at most %d %s values\n", MAX_LIST, what);
+            exit(EXIT_FAILURE);
+        }
+        out[n++] = item;
+    }
+    if (n == 0) {
+        fprintf(stderr, "empty %s list\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+static int parse_positive(const char *s) {
+    int v = atoi(s);
+    return v > 0 ? v : -1;
+}
+
+static int parse_poll(const char *s) {
+    for (int i = 0; i <= POLL_BUSY; i++) {
+        if (strcmp(s, poll_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int parse_variant(const char *s) {
+    for (int i = 0; i < NUM_VARIANTS; i++) {
+        if (strcmp(s, variants[i].label) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void parse_labels(const char *list) {
+    int idx[MAX_LIST];
+    cfg.nvariants = parse_list(list, idx, "label", parse_variant);
+    for (int i = 0; i < cfg.nvariants; i++) {
+        cfg.variants[i] = &variants[idx[i]];
+    }
+}
+
+static void parse_args(int argc, char *argv[]) {
+    cfg.nsizes = parse_list("128,512,1024,4096", cfg.sizes, "size", parse_positive);
+    cfg.nthreads = parse_list("1,2,4,8", cfg.threads, "thread count", parse_positive);
+    cfg.npolls = parse_list("block,busypoll", cfg.polls, "poll mode", parse_poll);
+    cfg.nplacements = parse_list("none", cfg.placements, "placement", placement_parse);
+    cfg.nktls = parse_list("off", cfg.ktls, "kTLS cipher", ktls_parse);
+    parse_labels(default_labels);
+    cfg.ntune_buffers = split_strings(default_tune_buffers, ",", cfg.tune_buffers, "buffer size");
+    cfg.ntune_nagle = split_strings(default_tune_nagle, ";", cfg.tune_nagle, "Nagle setting");
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *v;
+        if ((v = opt_value(arg, "--labels"))) {
+            parse_labels(v);
+        } else if ((v = opt_value(arg, "--sizes"))) {
+            cfg.nsizes = parse_list(v, cfg.sizes, "size", parse_positive);
+        } else if ((v = opt_value(arg, "--threads"))) {
+            cfg.nthreads = parse_list(v, cfg.threads, "thread count", parse_positive);
+        } else if ((v = opt_value(arg, "--duration"))) {
+            cfg.duration = atoi(v);
+        } else if ((v = opt_value(arg, "--poll-modes"))) {
+            cfg.npolls = parse_list(v, cfg.polls, "poll mode", parse_poll);
+        } else if ((v = opt_value(arg, "--placements"))) {
+            cfg.nplacements = parse_list(v, cfg.placements, "placement", placement_parse);
+        } else if ((v = opt_value(arg, "--ktls-modes"))) {
+            cfg.nktls = parse_list(v, cfg.ktls, "kTLS cipher", ktls_parse);
+        } else if ((v = opt_value(arg, "--repeat"))) {
+            cfg.repeat = atoi(v);
+        } else if ((v = opt_value(arg, "--jobs"))) {
+            cfg.jobs = atoi(v);
+        } else if ((v = opt_value(arg, "--cpus"))) {
+            cfg.cpus = v;
+        } else if ((v = opt_value(arg, "--base-port"))) {
+            cfg.base_port = atoi(v);
+        } else if ((v = opt_value(arg, "--ready-timeout"))) {
+            cfg.ready_timeout_s = atoi(v);
+        } else if ((v = opt_value(arg, "--relay"))) {
+            cfg.relay = v;
+        } else if ((v = opt_value(arg, "--interval-ms"))) {
+            cfg.interval_ms = atoi(v);
+        } else if ((v = opt_value(arg, "--interval-csv"))) {
+            cfg.interval_csv = v;
+        } else if ((v = opt_value(arg, "--server-intervals"))) {
+            cfg.server_intervals = atoi(v);
+        } else if (strcmp(arg, "--autotune") == 0) {
+            cfg.autotune = 1;
+        } else if ((v = opt_value(arg, "--tune-duration"))) {
+            cfg.tune_duration = atoi(v);
+        } else if ((v = opt_value(arg, "--tune-buffers"))) {
+            cfg.ntune_buffers = split_strings(v, ",", cfg.tune_buffers, "buffer size");
+        } else if ((v = opt_value(arg, "--tune-nagle"))) {
+            cfg.ntune_nagle = split_strings(v, ";", cfg.tune_nagle, "Nagle setting");
+        } else if ((v = opt_value(arg, "--autotune-csv"))) {
+            cfg.autotune_csv = v;
+        } else if ((v = opt_value(arg, "--csv"))) {
+            cfg.csv = v;
+        } else if ((v = opt_value(arg, "--json"))) {
+            cfg.json = v;
+        } else if ((v = opt_value(arg, "--bin-dir"))) {
+            cfg.bin_dir = v;
+        } else if (strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            exit(EXIT_SUCCESS);
+        } else if (strncmp(arg, "--", 2) == 0) {
+            args_add(&cfg.forward, "%s", arg);
+        } else {
+            fprintf(stderr, "%s: unexpected argument %s\n", argv[0], arg);
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (cfg.duration <= 0 || cfg.repeat <= 0 || cfg.tune_duration <= 0 || cfg.jobs <= 0 ||
+        cfg.ready_timeout_s <= 0) {
+        fprintf(stderr, "--duration, --repeat, --tune-duration, --jobs and --ready-timeout must be positive\n");
+        exit(EXIT_FAILURE);
+    }
+    if (cfg.jobs > 1) {
+        for (int i = 0; i < cfg.nplacements; i++) {
+            if (cfg.placements[i] != PLACEMENT_NONE) {
+                fprintf(stderr, "--placements pins threads across the whole machine; use it with --jobs=1\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // The benchmark parser rejects bad forwarded options now rather than in
+    // every child, and fills bench_opts for the CSV columns
+    arglist_t check = { { NULL }, 0 };
+    args_add(&check, "%s", argv[0]);
+    args_append(&check, &cfg.forward);
+    parse_bench_options(check.argc, check.argv);
+    args_free(&check);
+}
+
+// CPUs from a list such as "0-3,8", or the ones this process may use
+static int parse_cpus(const char *list, int *out, int max) {
+    int n = 0;
+    if (!list) {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) < 0) {
+            perror("sched_getaffinity failed");
+            exit(EXIT_FAILURE);
+        }
+        for (int c = 0; c < CPU_SETSIZE && n < max; c++) {
+            if (CPU_ISSET(c, &set)) {
+                out[n++] = c;
+            }
+        }
+        return n;
+    }
+    char *copy = strdup(list);
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        int lo, hi;
+        if (sscanf(item, "%d-%d", &lo, &hi) != 2) {
+            hi = lo = atoi(item);
+        }
+        if (lo < 0 || hi < lo || hi >= CPU_SETSIZE) {
+            bad_value("CPU range", item);
+        }
+        for (int c = lo; c <= hi && n < max; c++) {
+            out[n++] = c;
+        }
+    }
+    free(copy);
+    return n;
+}
+
+// Gives job slot i an equal, disjoint share of the CPUs
+static slot_t *make_slots(void) {
+    static int cpus[CPU_SETSIZE];
+    int n = parse_cpus(cfg.cpus, cpus, CPU_SETSIZE);
+    if (n < cfg.jobs) {
+        fprintf(stderr, "--jobs=%d needs at least as many CPUs, %d available\n", cfg.jobs, n);
+        exit(EXIT_FAILURE);
+    }
+    slot_t *slots = calloc((size_t)cfg.jobs, sizeof(slot_t));
+    if (!slots) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int s = 0; s < cfg.jobs; s++) {
+        int lo = s * n / cfg.jobs;
+        int hi = (s + 1) * n / cfg.jobs;
+        slots[s].index = s;
+        slots[s].first_cpu = cpus[lo];
+        slots[s].ncpus = hi - lo;
+        CPU_ZERO(&slots[s].cpus);
+        for (int i = lo; i < hi; i++) {
+            CPU_SET(cpus[i], &slots[s].cpus);
+        }
+    }
+    return slots;
+}
+
+// ---------------------------------------------------------------------------
+// Child processes
+// ---------------------------------------------------------------------------
+
+// Forks and execs `a` on the slot's CPUs with stdout on `out_fd` (-1 =
+// /dev/null). `keep_fd` stays open across exec (every other descriptor of
+// ours is close-on-exec); with `gate_fd` >= 0 the child waits for a byte on
+// it before exec, so counters can be attached to the pid first. Children
+// die with the thread that started them.
+static pid_t spawn(const arglist_t *a, const slot_t *slot, int out_fd, int keep_fd, int gate_fd) {
+    pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    signal(SIGPIPE, SIG_DFL);
+    sched_setaffinity(0, sizeof(slot->cpus), &slot->cpus);
+    if (out_fd < 0) {
+        out_fd = open("/dev/null", O_WRONLY);
+    }
+    if (out_fd >= 0) {
+        dup2(out_fd, STDOUT_FILENO);
+    }
+    if (keep_fd >= 0) {
+        fcntl(keep_fd, F_SETFD, 0);
+    }
+    if (gate_fd >= 0) {
+        char go;
+        if (read(gate_fd, &go, 1) != 1) {
+            _exit(127);
+        }
+    }
+    execv(a->argv[0], a->argv);
+    _exit(127);
+}
+
+// Starts `a` with --ready-fd and waits until it is listening. Returns the
+// pid, or -1 with `why` filled when it exits or stays silent.
+static pid_t start_listener(arglist_t *a, const slot_t *slot, char *why, size_t len) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        snprintf(why, len, "pipe: %s", strerror(errno));
+        return -1;
+    }
+    args_add(a, "--ready-fd=%d", fds[1]);
+    pid_t pid = spawn(a, slot, -1, fds[1], -1);
+    close(fds[1]);
+    if (pid < 0) {
+        snprintf(why, len, "fork: %s", strerror(errno));
+        close(fds[0]);
+        return -1;
+    }
+
+    char buf[16] = "";
+    size_t got = 0;
+    int closed = 0;
+    uint64_t deadline = now_ns() + (uint64_t)cfg.ready_timeout_s * 1000000000ULL;
+    while (got < sizeof(buf) - 1 && !strchr(buf, '\n')) {
+        uint64_t now = now_ns();
+        struct pollfd pfd = { fds[0], POLLIN, 0 };
+        int left_ms = now < deadline ? (int)((deadline - now) / 1000000ULL) + 1 : 0;
+        if (poll(&pfd, 1, left_ms) <= 0) {
+            break;
+        }
+        ssize_t n = read(fds[0], buf + got, sizeof(buf) - 1 - got);
+        if (n <= 0) {
+            closed = 1;
+            break;
+        }
+        got += (size_t)n;
+        buf[got] = '\0';
+    }
+    close(fds[0]);
+    if (strncmp(buf, "READY", 5) == 0) {
+        return pid;
+    }
+
+    // The descriptor closes as the child exits, a moment before it can be
+    // reaped
+    int status;
+    pid_t done = 0;
+    for (int i = 0; closed && done == 0 && i < 100; i++) {
+        done = waitpid(pid, &status, WNOHANG);
+        if (done == 0) {
+            usleep(10000);
+        }
+    }
+    if (done == pid || waitpid(pid, &status, WNOHANG) == pid) {
+        snprintf(why, len, "%s exited (status %d) before listening", a->argv[0],
+                 WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+    } else {
+        snprintf(why, len, "%s not listening after %d s", a->argv[0], cfg.ready_timeout_s);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+    return -1;
+}
+
+// Terminates a listener; returns its CPU seconds
+static double stop_listener(pid_t pid) {
+    struct rusage ru;
+    int status;
+    if (pid <= 0) {
+        return -1.0;
+    }
+    kill(pid, SIGTERM);
+    if (wait4(pid, &status, 0, &ru) != pid) {
+        return -1.0;
+    }
+    return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1e6 +
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6;
+}
+
+// ---------------------------------------------------------------------------
+// Counters
+// ---------------------------------------------------------------------------
+
+// One counter per event (not a group, so an unsupported event does not take
+// the others down), following the pid and the threads it creates, enabled
+// by its exec
+static void counters_open(pid_t pid, int fds[NUM_COUNTERS]) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counter_defs[i].type;
+        attr.config = counter_defs[i].config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.enable_on_exec = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds[i] = (int)syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fds[i] < 0) {
+            const char *err = strerror(errno);
+            const char *none = NULL;
+            if (__atomic_compare_exchange_n(&counter_error[i], &none, err, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                fprintf(stderr, "[WARN] counter %s unavailable (%s); its column stays empty\n",
+                        counter_defs[i].name, err);
+            }
+        }
+    }
+}
+
+// Reads and closes the counters, scaled up when the kernel multiplexed them
+static void counters_close(int fds[NUM_COUNTERS], long long out[NUM_COUNTERS]) {
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        uint64_t v[3];      // value, time enabled, time running
+        out[i] = -1;
+        if (fds[i] < 0) {
+            continue;
+        }
+        if (read(fds[i], v, sizeof(v)) == (ssize_t)sizeof(v)) {
+            out[i] = v[2] > 0 ? (long long)((double)v[0] * (double)v[1] / (double)v[2]) : 0;
+        }
+        close(fds[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Client output
+// ---------------------------------------------------------------------------
+
+// Keeps the key=value words of lines starting with an upper-case tag
+// (SUMMARY, HYBRID, UDP, STREAMS, ...); INTERVAL rows belong in the time
+// series and the per-stream STREAM lines would repeat the same keys
+static void parse_output(char *text, result_t *r) {
+    char *save = NULL;
+    for (char *line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        char tag[16];
+        int used = 0;
+        if (sscanf(line, "%15[A-Z] %n", tag, &used) != 1 || used == 0 || line[used - 1] != ' ' ||
+            strcmp(tag, "INTERVAL") == 0 || strcmp(tag, "STREAM") == 0) {
+            continue;
+        }
+        char *wsave = NULL;
+        for (char *w = strtok_r(line + used, " ", &wsave); w; w = strtok_r(NULL, " ", &wsave)) {
+            char *eq = strchr(w, '=');
+            if (!eq || r->nfields == MAX_FIELDS) {
+                continue;
+            }
+            field_t *f = &r->fields[r->nfields++];
+            snprintf(f->tag, sizeof(f->tag), "%s", tag);
+            snprintf(f->key, sizeof(f->key), "%.*s", (int)(eq - w), w);
+            snprintf(f->value, sizeof(f->value), "%s", eq + 1);
+        }
+    }
+}
+
+static const char *field(const result_t *r, const char *tag, const char *key) {
+    for (int i = 0; i < r->nfields; i++) {
+        if (strcmp(r->fields[i].tag, tag) == 0 && strcmp(r->fields[i].key, key) == 0) {
+            return r->fields[i].value;
+        }
+    }
+    return NULL;
+}
+
+// Runs the client to completion with counters attached and collects its
+// output. Fails the result on a non-zero exit, a timeout or no SUMMARY.
+static void run_client(const arglist_t *a, const slot_t *slot, int duration, result_t *r) {
+    int out[2], gate[2];
+    if (pipe2(out, O_CLOEXEC) < 0 || pipe2(gate, O_CLOEXEC) < 0) {
+        r->status = "failed";
+        snprintf(r->error, sizeof(r->error), "pipe: %s", strerror(errno));
+        return;
+    }
+    pid_t pid = spawn(a, slot, out[1], -1, gate[0]);
+    close(out[1]);
+    close(gate[0]);
+    if (pid < 0) {
+        r->status = "failed";
+        snprintf(r->error, sizeof(r->error), "fork: %s", strerror(errno));
+        close(out[0]);
+        close(gate[1]);
+        return;
+    }
+
+    int ctr[NUM_COUNTERS];
+    counters_open(pid, ctr);
+    uint64_t start = now_ns();
+    if (write(gate[1], "g", 1) != 1) {
+        kill(pid, SIGKILL);
+    }
+    close(gate[1]);
+
+    size_t cap = 4096, len = 0;
+    char *text = malloc(cap);
+    if (!text) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t deadline = start + (uint64_t)(duration + CLIENT_GRACE_S) * 1000000000ULL;
+    int timed_out = 0;
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= deadline) {
+            timed_out = 1;
+            kill(pid, SIGKILL);
+            break;
+        }
+        struct pollfd pfd = { out[0], POLLIN, 0 };
+        if (poll(&pfd, 1, (int)((deadline - now) / 1000000ULL) + 1) < 0 && errno != EINTR) {
+            break;
+        }
+        if (len + 1024 > cap) {
+            cap *= 2;
+            text = realloc(text, cap);
+            if (!text) {
+                perror("malloc failed");
+                exit(EXIT_FAILURE);
+            }
+        }
+        ssize_t n = read(out[0], text + len, cap - len - 1);
+        if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN)) {
+            break;
+        }
+        if (n > 0) {
+            len += (size_t)n;
+        }
+    }
+    close(out[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    r->elapsed_s = (double)(now_ns() - start) / 1e9;
+    counters_close(ctr, r->counters);
+    text[len] = '\0';
+    parse_output(text, r);
+    free(text);
+
+    if (timed_out) {
+        r->status = "timeout";
+        snprintf(r->error, sizeof(r->error), "client still running %d s after the run", CLIENT_GRACE_S);
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        r->status = "failed";
+        snprintf(r->error, sizeof(r->error), "client exited with status %d",
+                 WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+    } else if (!field(r, "SUMMARY", "throughput_gbps")) {
+        r->status = "failed";
+        snprintf(r->error, sizeof(r->error), "client printed no SUMMARY line");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Cells
+// ---------------------------------------------------------------------------
+
+static int cell_port(const cell_t *c, const slot_t *slot) {
+    return cfg.base_port + slot->index * PORT_STRIDE + c->variant->pair - 1;
+}
+
+static int cell_relayed(const cell_t *c) {
+    return cfg.relay && c->variant->pair != 4;
+}
+
+// Server and client command lines of a cell; `socket_flags` goes after the
+// forwarded options so it wins
+static void build_commands(const cell_t *c, const slot_t *slot, const char *socket_flags,
+                           int duration, const char *run_id, arglist_t *server, arglist_t *client) {
+    int port = cell_port(c, slot);
+    args_add(server, "%s/MT25034_Part_A%d_Server", cfg.bin_dir, c->variant->pair);
+    args_add(server, "%d", port);
+    args_add(server, "%d", c->msg_size);
+    args_add(client, "%s/MT25034_Part_A%d_Client", cfg.bin_dir, c->variant->pair);
+    args_add(client, "127.0.0.1");
+    args_add(client, "%d", cell_relayed(c) ? port + RELAY_PORT_OFFSET : port);
+    args_add(client, "%d", c->threads);
+    args_add(client, "%d", c->msg_size);
+    args_add(client, "%d", duration);
+
+    arglist_t *sides[2] = { server, client };
+    for (int i = 0; i < 2; i++) {
+        args_append(sides[i], &cfg.forward);
+        args_split(sides[i], socket_flags);
+        args_add(sides[i], "--placement=%s", placement_name(c->placement));
+        args_add(sides[i], "--ktls=%s", ktls_name(c->ktls));
+        if (c->poll_mode == POLL_BUSY) {
+            args_add(sides[i], "--busy-poll");
+            // A single job owns the machine: server threads from its first
+            // CPU, client threads from the middle one. --pin counts over all
+            // CPUs, so parallel jobs just stay inside their own sets.
+            if (cfg.jobs == 1) {
+                args_add(sides[i], "--pin=%d", slot->first_cpu + (i ? slot->ncpus / 2 : 0));
+            }
+        }
+        if (run_id && cfg.interval_ms > 0 && (i == 1 || cfg.server_intervals)) {
+            args_add(sides[i], "--interval-ms=%d", cfg.interval_ms);
+            args_add(sides[i], "--interval-csv=%s", cfg.interval_csv);
+            args_add(sides[i], "--run-id=%s", run_id);
+        }
+    }
+    args_split(server, c->variant->server_flags);
+    args_split(client, c->variant->client_flags);
+}
+
+// One run of a cell: server, relay, client, teardown
+static void run_once(const cell_t *c, const slot_t *slot, const char *socket_flags,
+                     int duration, const char *run_id, result_t *r) {
+    arglist_t server = { { NULL }, 0 }, client = { { NULL }, 0 }, relay = { { NULL }, 0 };
+    pid_t relay_pid = 0;
+
+    r->status = "ok";
+    r->error[0] = '\0';
+    r->slot = slot->index;
+    r->port = cell_port(c, slot);
+    r->elapsed_s = 0.0;
+    r->server_cpu_s = -1.0;
+    r->nfields = 0;
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        r->counters[i] = -1;
+    }
+
+    build_commands(c, slot, socket_flags, duration, run_id, &server, &client);
+    args_join(&server, r->server_cmd, sizeof(r->server_cmd));
+    args_join(&client, r->client_cmd, sizeof(r->client_cmd));
+
+    pid_t server_pid = start_listener(&server, slot, r->error, sizeof(r->error));
+    if (server_pid < 0) {
+        r->status = "failed";
+        goto out;
+    }
+    if (cell_relayed(c)) {
+        args_add(&relay, "%s/MT25034_Part_C_Relay", cfg.bin_dir);
+        args_add(&relay, "%d", r->port + RELAY_PORT_OFFSET);
+        args_add(&relay, "127.0.0.1");
+        args_add(&relay, "%d", r->port);
+        args_split(&relay, cfg.relay);
+        relay_pid = start_listener(&relay, slot, r->error, sizeof(r->error));
+        if (relay_pid < 0) {
+            r->status = "failed";
+            stop_listener(server_pid);
+            goto out;
+        }
+    }
+
+    run_client(&client, slot, duration, r);
+
+    if (relay_pid > 0) {
+        stop_listener(relay_pid);
+    }
+    // A server that died under the client fails the run even if the client
+    // managed to print a summary
+    int status;
+    if (waitpid(server_pid, &status, WNOHANG) == server_pid) {
+        r->status = "failed";
+        snprintf(r->error, sizeof(r->error), "server exited during the run (status %d)",
+                 WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+    } else {
+        r->server_cpu_s = stop_listener(server_pid);
+    }
+
+out:
+    args_free(&server);
+    args_free(&client);
+    args_free(&relay);
+}
+
+// Short trials of every tuner setting; returns the flags of the highest
+// throughput (lower p99 breaks ties)
+static void autotune_cell(const cell_t *c, const slot_t *slot, char *best, size_t len) {
+    double best_gbps = -1.0, best_p99 = 0.0;
+    result_t *trial = malloc(sizeof(result_t));
+    if (!trial) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    best[0] = '\0';
+    for (int b = 0; b < cfg.ntune_buffers; b++) {
+        for (int n = 0; n < cfg.ntune_nagle; n++) {
+            const char *buffer = cfg.tune_buffers[b];
+            char flags[128];
+            if (strcmp(buffer, "default") != 0) {
+                snprintf(flags, sizeof(flags), "%s --sndbuf=%s --rcvbuf=%s",
+                         cfg.tune_nagle[n], buffer, buffer);
+            } else {
+                snprintf(flags, sizeof(flags), "%s", cfg.tune_nagle[n]);
+            }
+            memset(trial, 0, sizeof(*trial));
+            run_once(c, slot, flags, cfg.tune_duration, NULL, trial);
+            const char *g = field(trial, "SUMMARY", "throughput_gbps");
+            const char *p = field(trial, "SUMMARY", "p99_us");
+            double gbps = strcmp(trial->status, "ok") == 0 && g ? atof(g) : 0.0;
+            double p99 = strcmp(trial->status, "ok") == 0 && p ? atof(p) : 0.0;
+
+            pthread_mutex_lock(&tune_lock);
+            fprintf(tune_out, "%s,%d,%d,%s,%s,%.6f,%.3f\n", c->variant->label, c->msg_size,
+                    c->threads, poll_names[c->poll_mode], flags, gbps, p99);
+            fflush(tune_out);
+            pthread_mutex_unlock(&tune_lock);
+            printf("[TUNE] %s | %s -> %.6f Gbps, p99 %.3f us%s%s\n", c->variant->label, flags, gbps, p99,
+                   trial->error[0] ? " | " : "", trial->error);
+
+            if (gbps > best_gbps || (gbps == best_gbps && p99 < best_p99)) {
+                best_gbps = gbps;
+                best_p99 = p99;
+                snprintf(best, len, "%s", flags);
+            }
+        }
+    }
+    free(trial);
+    printf("[TUNE] %s | MSG_SIZE=%d | THREADS=%d | best: %s\n", c->variant->label, c->msg_size,
+           c->threads, best);
+}
+
+static void describe_link(const cell_t *c, char *out, size_t len) {
+    if (!cell_relayed(c)) {
+        snprintf(out, len, "loopback");
+        return;
+    }
+    // "--delay-ms=5 --rate-mbit=1000" -> "relay:delay-ms=5;rate-mbit=1000"
+    size_t used = (size_t)snprintf(out, len, "relay:");
+    for (const char *p = cfg.relay; *p && used + 1 < len; p++) {
+        if (p[0] == '-' && p[1] == '-') {
+            p++;
+        } else if (*p == ' ') {
+            if (used > 6 && out[used - 1] != ';') {
+                out[used++] = ';';
+            }
+        } else {
+            out[used++] = *p;
+        }
+    }
+    out[used] = '\0';
+}
+
+static void *job_slot(void *arg) {
+    slot_t *slot = (slot_t *)arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&next_cell, 1, __ATOMIC_RELAXED);
+        if (i >= ncells) {
+            break;
+        }
+        const cell_t *c = &cells[i];
+        result_t *r = &results[i];
+        char run_id[48];
+        snprintf(run_id, sizeof(run_id), "%s-%d", run_stamp, c->seq);
+
+        if (cfg.autotune) {
+            autotune_cell(c, slot, r->tuned_flags, sizeof(r->tuned_flags));
+        }
+        printf("[RUN] %s | MSG_SIZE=%d | THREADS=%d | MODE=%s | PLACEMENT=%s | KTLS=%s | JOB=%d\n",
+               c->variant->label, c->msg_size, c->threads, poll_names[c->poll_mode],
+               placement_name(c->placement), ktls_name(c->ktls), slot->index);
+        run_once(c, slot, r->tuned_flags, cfg.duration, run_id, r);
+        if (strcmp(r->status, "ok") == 0) {
+            const char *g = field(r, "SUMMARY", "throughput_gbps");
+            const char *p = field(r, "SUMMARY", "p99_us");
+            printf("[DONE] %s | MSG_SIZE=%d | THREADS=%d | MODE=%s -> %s Gbps, p99 %s us\n",
+                   c->variant->label, c->msg_size, c->threads, poll_names[c->poll_mode], g, p ? p : "?");
+        } else {
+            printf("[FAIL] %s | MSG_SIZE=%d | THREADS=%d | MODE=%s -> %s: %s\n",
+                   c->variant->label, c->msg_size, c->threads, poll_names[c->poll_mode],
+                   r->status, r->error);
+        }
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+// Writes `v` or leaves the cell empty when it is unknown
+static void csv_count(FILE *f, long long v) {
+    if (v >= 0) {
+        fprintf(f, "%lld", v);
+    }
+    fputc(',', f);
+}
+
+static void csv_field(FILE *f, const result_t *r, const char *tag, const char *key, const char *fallback) {
+    const char *v = field(r, tag, key);
+    fprintf(f, "%s,", v ? v : (fallback ? fallback : ""));
+}
+
+static int write_csv(void) {
+    FILE *f = fopen(cfg.csv, "w");
+    if (!f) {
+        perror(cfg.csv);
+        return -1;
+    }
+    fprintf(f, "Label,Message_Size,Threads,Duration_s,Time_Elapsed_s,Bytes_Sent,Throughput_Gbps,"
+               "Latency_us,Cycles,Instructions,Cache_Misses,DTLB_Load_Misses,Context_Switches,"
+               "Poll_Mode,P50_Latency_us,P99_Latency_us,Client_CPU_Pct,Server_CPU_Pct,Socket_Profile,"
+               "Response_Size,Handler,Hugepages,ZC_Threshold,Copy_Sends,ZC_Sends,Fields,Field_Dist,"
+               "Placement,KTLS,Link,UDP_Sent,UDP_Lost,UDP_Reordered,Build,Repeat,Run_ID,Status\n");
+    for (int i = 0; i < ncells; i++) {
+        const cell_t *c = &cells[i];
+        const result_t *r = &results[i];
+        int ok = strcmp(r->status, "ok") == 0;
+        char link[128];
+        describe_link(c, link, sizeof(link));
+
+        // Time_Elapsed_s, Bytes_Sent, Throughput_Gbps and Latency_us keep
+        // the shell loop's definitions so old and new rows compare
+        long long bytes = (long long)c->msg_size * c->threads * cfg.duration;
+        fprintf(f, "%s,%d,%d,%d,", c->variant->label, c->msg_size, c->threads, cfg.duration);
+        if (ok) {
+            fprintf(f, "%.6f,%lld,%.6f,%.3f,", r->elapsed_s, bytes,
+                    (double)bytes * 8.0 / (r->elapsed_s * 1e9),
+                    r->elapsed_s * 1e6 / (double)(c->threads * cfg.duration));
+        } else {
+            fprintf(f, ",%lld,,,", bytes);
+        }
+        for (int k = 0; k < NUM_COUNTERS; k++) {
+            csv_count(f, ok ? r->counters[k] : -1);
+        }
+        fprintf(f, "%s,", poll_names[c->poll_mode]);
+        csv_field(f, r, "SUMMARY", "p50_us", NULL);
+        csv_field(f, r, "SUMMARY", "p99_us", NULL);
+        csv_field(f, r, "SUMMARY", "cpu_pct", NULL);
+        if (ok && r->server_cpu_s >= 0) {
+            fprintf(f, "%.1f,", 100.0 * r->server_cpu_s / cfg.duration);
+        } else {
+            fputc(',', f);
+        }
+        csv_field(f, r, "SUMMARY", "profile", "unknown");
+        fprintf(f, "%zu,%s,", bench_opts.response_size ? bench_opts.response_size : (size_t)c->msg_size,
+                handler_name(bench_opts.handler));
+        csv_field(f, r, "SUMMARY", "hugepages", hugepage_mode_name(bench_opts.hugepages));
+        csv_field(f, r, "HYBRID", "threshold", NULL);
+        csv_field(f, r, "HYBRID", "copy_sends", NULL);
+        csv_field(f, r, "HYBRID", "zc_sends", NULL);
+        fprintf(f, "%d,%s,", bench_opts.fields, field_dist_name(bench_opts.field_dist));
+        csv_field(f, r, "SUMMARY", "placement", placement_name(c->placement));
+        csv_field(f, r, "SUMMARY", "ktls", ktls_name(c->ktls));
+        fprintf(f, "%s,", link);
+        csv_field(f, r, "UDP", "sent", NULL);
+        csv_field(f, r, "UDP", "lost", NULL);
+        csv_field(f, r, "UDP", "reordered", NULL);
+        csv_field(f, r, "SUMMARY", "build", MT25034_BUILD_VARIANT);
+        fprintf(f, "%d,%s-%d,%s\n", c->repeat, run_stamp, c->seq, r->status);
+    }
+    return fclose(f);
+}
+
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; s && *s; s++) {
+        unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            fprintf(f, "\\%c", ch);
+        } else if (ch < 0x20) {
+            fprintf(f, "\\u%04x", ch);
+        } else {
+            fputc(ch, f);
+        }
+    }
+    fputc('"', f);
+}
+
+// Numbers stay numbers, everything else becomes a string
+static void json_value(FILE *f, const char *s) {
+    char *end = NULL;
+    strtod(s, &end);
+    if (*s && end && *end == '\0' && strspn(s, "0123456789.-+eE") == strlen(s)) {
+        fputs(s, f);
+    } else {
+        json_string(f, s);
+    }
+}
+
+// First line of `cmd`'s output, or "unknown"
+static void command_line(const char *cmd, char *out, size_t len) {
+    snprintf(out, len, "unknown");
+    FILE *p = popen(cmd, "r");
+    if (!p) {
+        return;
+    }
+    if (fgets(out, (int)len, p)) {
+        out[strcspn(out, "\n")] = '\0';
+    }
+    if (pclose(p) != 0 || out[0] == '\0') {
+        snprintf(out, len, "unknown");
+    }
+}
+
+static void cpu_model(char *out, size_t len) {
+    char line[256];
+    snprintf(out, len, "unknown");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) {
+        return;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if (colon && strncmp(line, "model name", 10) == 0) {
+            colon += 1 + strspn(colon + 1, " \t");
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(out, len, "%s", colon);
+            break;
+        }
+    }
+    fclose(f);
+}
+
+static void iso_time(time_t t, char *out, size_t len) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(out, len, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+static int write_json(int argc, char *argv[], time_t started, time_t finished, const slot_t *slots) {
+    FILE *f = fopen(cfg.json, "w");
+    if (!f) {
+        perror(cfg.json);
+        return -1;
+    }
+    struct utsname u;
+    char buf[256], host[256] = "unknown";
+    uname(&u);
+    gethostname(host, sizeof(host) - 1);
+
+    fprintf(f, "{\n  \"run_stamp\": ");
+    json_string(f, run_stamp);
+    iso_time(started, buf, sizeof(buf));
+    fprintf(f, ",\n  \"started\": ");
+    json_string(f, buf);
+    iso_time(finished, buf, sizeof(buf));
+    fprintf(f, ",\n  \"finished\": ");
+    json_string(f, buf);
+
+    fprintf(f, ",\n  \"host\": {\n    \"hostname\": ");
+    json_string(f, host);
+    snprintf(buf, sizeof(buf), "%s %s %s", u.sysname, u.release, u.version);
+    fprintf(f, ",\n    \"kernel\": ");
+    json_string(f, buf);
+    fprintf(f, ",\n    \"machine\": ");
+    json_string(f, u.machine);
+    cpu_model(buf, sizeof(buf));
+    fprintf(f, ",\n    \"cpu_model\": ");
+    json_string(f, buf);
+    fprintf(f, ",\n    \"online_cpus\": %ld", sysconf(_SC_NPROCESSORS_ONLN));
+    command_line("cat /proc/sys/kernel/perf_event_paranoid 2>/dev/null", buf, sizeof(buf));
+    fprintf(f, ",\n    \"perf_event_paranoid\": ");
+    json_value(f, buf);
+    fprintf(f, "\n  },\n  \"build\": {\n    \"variant\": ");
+    json_string(f, MT25034_BUILD_VARIANT);
+    fprintf(f, ",\n    \"compiler\": ");
+    json_string(f, "gcc " __VERSION__);
+    fprintf(f, ",\n    \"cflags\": ");
+    json_string(f, MT25034_CFLAGS);
+    fprintf(f, ",\n    \"git_revision\": ");
+    json_string(f, MT25034_GIT_REV);
+    command_line("git describe --always --dirty 2>/dev/null", buf, sizeof(buf));
+    fprintf(f, ",\n    \"tree_revision\": ");
+    json_string(f, buf);
+
+    fprintf(f, "\n  },\n  \"command\": [");
+    for (int i = 0; i < argc; i++) {
+        fprintf(f, "%s", i ? ", " : "");
+        json_string(f, argv[i]);
+    }
+    fprintf(f, "],\n  \"duration_s\": %d,\n  \"repeat\": %d,\n  \"jobs\": [", cfg.duration, cfg.repeat);
+    for (int s = 0; s < cfg.jobs; s++) {
+        fprintf(f, "%s\n    {\"job\": %d, \"ports_from\": %d, \"cpus\": [", s ? "," : "", s,
+                cfg.base_port + s * PORT_STRIDE);
+        int first = 1;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &slots[s].cpus)) {
+                fprintf(f, "%s%d", first ? "" : ", ", c);
+                first = 0;
+            }
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "\n  ],\n  \"counters\": {");
+    for (int k = 0; k < NUM_COUNTERS; k++) {
+        fprintf(f, "%s\n    ", k ? "," : "");
+        json_string(f, counter_defs[k].name);
+        fprintf(f, ": ");
+        json_string(f, counter_error[k] ? counter_error[k] : "ok");
+    }
+
+    fprintf(f, "\n  },\n  \"runs\": [");
+    for (int i = 0; i < ncells; i++) {
+        const cell_t *c = &cells[i];
+        const result_t *r = &results[i];
+        char link[128];
+        describe_link(c, link, sizeof(link));
+        snprintf(buf, sizeof(buf), "%s-%d", run_stamp, c->seq);
+        fprintf(f, "%s\n    {\n      \"run_id\": ", i ? "," : "");
+        json_string(f, buf);
+        fprintf(f, ", \"label\": ");
+        json_string(f, c->variant->label);
+        fprintf(f, ", \"message_size\": %d, \"threads\": %d, \"poll_mode\": ", c->msg_size, c->threads);
+        json_string(f, poll_names[c->poll_mode]);
+        fprintf(f, ",\n      \"placement\": ");
+        json_string(f, placement_name(c->placement));
+        fprintf(f, ", \"ktls\": ");
+        json_string(f, ktls_name(c->ktls));
+        fprintf(f, ", \"link\": ");
+        json_string(f, link);
+        fprintf(f, ", \"repeat\": %d, \"job\": %d, \"port\": %d,\n      \"status\": ", c->repeat, r->slot,
+                r->port);
+        json_string(f, r->status);
+        fprintf(f, ", \"error\": ");
+        json_string(f, r->error);
+        fprintf(f, ", \"elapsed_s\": %.6f, \"server_cpu_s\": ", r->elapsed_s);
+        if (r->server_cpu_s >= 0) {
+            fprintf(f, "%.3f", r->server_cpu_s);
+        } else {
+            fprintf(f, "null");
+        }
+        fprintf(f, ",\n      \"counters\": {");
+        for (int k = 0; k < NUM_COUNTERS; k++) {
+            fprintf(f, "%s", k ? ", " : "");
+            json_string(f, counter_defs[k].name);
+            if (r->counters[k] >= 0) {
+                fprintf(f, ": %lld", r->counters[k]);
+            } else {
+                fprintf(f, ": null");
+            }
+        }
+        fprintf(f, "},\n      \"tuned_flags\": ");
+        json_string(f, r->tuned_flags);
+        fprintf(f, ",\n      \"server\": ");
+        json_string(f, r->server_cmd);
+        fprintf(f, ",\n      \"client\": ");
+        json_string(f, r->client_cmd);
+        fprintf(f, ",\n      \"output\": {");
+        // Fields arrive grouped by line, so a tag change opens a new object
+        for (int k = 0; k < r->nfields; k++) {
+            const field_t *fl = &r->fields[k];
+            if (k == 0 || strcmp(fl->tag, r->fields[k - 1].tag) != 0) {
+                fprintf(f, "%s\n        ", k ? "}," : "");
+                json_string(f, fl->tag);
+                fprintf(f, ": {");
+            } else {
+                fprintf(f, ", ");
+            }
+            json_string(f, fl->key);
+            fprintf(f, ": ");
+            json_value(f, fl->value);
+        }
+        fprintf(f, "%s}\n    }", r->nfields ? "}\n      " : "");
+    }
+    fprintf(f, "\n  ]\n}\n");
+    return fclose(f);
+}
+
+// ---------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    // A client that dies before reading its gate must not take us with it
+    signal(SIGPIPE, SIG_IGN);
+    parse_args(argc, argv);
+    slot_t *slots = make_slots();
+
+    time_t started = time(NULL);
+    struct tm tm;
+    localtime_r(&started, &tm);
+    strftime(run_stamp, sizeof(run_stamp), "%Y%m%d%H%M%S", &tm);
+
+    // Same nesting as the shell loop: placement, kTLS, poll mode, size,
+    // threads, then the labels. Repeats are whole passes, so slow drift on
+    // the host spreads over every cell instead of landing on one
+    ncells = cfg.repeat * cfg.nplacements * cfg.nktls * cfg.npolls * cfg.nsizes * cfg.nthreads *
+             cfg.nvariants;
+    cells = calloc((size_t)ncells, sizeof(cell_t));
+    results = calloc((size_t)ncells, sizeof(result_t));
+    if (!cells || !results) {
+        perror("malloc failed");
+        return EXIT_FAILURE;
+    }
+    int n = 0;
+    for (int r = 0; r < cfg.repeat; r++)
+        for (int p = 0; p < cfg.nplacements; p++)
+            for (int k = 0; k < cfg.nktls; k++)
+                for (int m = 0; m < cfg.npolls; m++)
+                    for (int s = 0; s < cfg.nsizes; s++)
+                        for (int t = 0; t < cfg.nthreads; t++)
+                            for (int v = 0; v < cfg.nvariants; v++) {
+                                cell_t *c = &cells[n];
+                                c->variant = cfg.variants[v];
+                                c->msg_size = cfg.sizes[s];
+                                c->threads = cfg.threads[t];
+                                c->poll_mode = cfg.polls[m];
+                                c->placement = cfg.placements[p];
+                                c->ktls = cfg.ktls[k];
+                                c->repeat = r + 1;
+                                c->seq = ++n;
+                            }
+
+    if (cfg.interval_ms > 0) {
+        unlink(cfg.interval_csv);
+    }
+    if (cfg.autotune) {
+        tune_out = fopen(cfg.autotune_csv, "w");
+        if (!tune_out) {
+            perror(cfg.autotune_csv);
+            return EXIT_FAILURE;
+        }
+        fprintf(tune_out, "Label,Message_Size,Threads,Poll_Mode,Flags,Throughput_Gbps,P99_Latency_us\n");
+    }
+
+    printf("[PLAN] %d runs of %d s in %d job(s), results in %s and %s\n",
+           ncells, cfg.duration, cfg.jobs, cfg.csv, cfg.json);
+    fflush(stdout);
+
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)cfg.jobs);
+    if (!tids) {
+        perror("malloc failed");
+        return EXIT_FAILURE;
+    }
+    for (int s = 0; s < cfg.jobs; s++) {
+        if (pthread_create(&tids[s], NULL, job_slot, &slots[s]) != 0) {
+            perror("pthread_create failed");
+            return EXIT_FAILURE;
+        }
+    }
+    for (int s = 0; s < cfg.jobs; s++) {
+        pthread_join(tids[s], NULL);
+    }
+    if (tune_out) {
+        fclose(tune_out);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < ncells; i++) {
+        failed += strcmp(results[i].status, "ok") != 0;
+    }
+    int rc = write_csv() | write_json(argc, argv, started, time(NULL), slots);
+    printf("\n[%s] %d of %d runs succeeded; results in %s and %s\n",
+           failed ? "FAILED" : "SUCCESS", ncells - failed, ncells, cfg.csv, cfg.json);
+    if (cfg.interval_ms > 0) {
+        printf("[INFO] Interval time series written to %s\n", cfg.interval_csv);
+    }
+
+    free(tids);
+    free(cells);
+    free(results);
+    free(slots);
+    return failed || rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,409 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "MT25034_ConnMem.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+// User-space WAN emulator: sits between a client and a server and forwards
+// both directions of every connection through a shaped queue that adds
+// one-way delay, jitter, a bandwidth limit and reordering stalls
+// (--delay-ms, --jitter-ms, --rate-mbit, --reorder-pct).
+//
+// Usage: MT25034_Part_C_Relay <listen_port> <server_host> <server_port> [options]
+
+// Largest piece read from a socket at once; the unit of shaping
+#define RELAY_CHUNK (16 * 1024)
+
+typedef struct chunk {
+    struct chunk *next;
+    uint64_t release_ns;    // when the writer may forward it
+    size_t len;
+    char data[];
+} chunk_t;
+
+// One direction of a connection: a reader thread queues chunks with their
+// release time, a writer thread forwards them once it has come
+typedef struct {
+    const char *name;
+    int from;
+    int to;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    chunk_t *head;
+    chunk_t *tail;
+    size_t queued;
+    size_t peak;
+    int eof;                // reader is done, nothing more will be queued
+    int dead;               // writer failed, reader should stop
+    uint64_t link_free_ns;  // when the emulated link finishes the last chunk
+    unsigned seed;
+    uint64_t bytes;
+    uint64_t chunks;
+    uint64_t reordered;
+} relay_dir_t;
+
+typedef struct {
+    int index;
+    int refs;               // reader and writer threads still running
+    relay_dir_t dir[2];     // [0] client -> server, [1] server -> client
+} relay_conn_t;
+
+typedef struct {
+    relay_conn_t *conn;
+    relay_dir_t *dir;
+} relay_arg_t;
+
+static uint64_t ms_to_ns(double ms) {
+    return ms > 0 ? (uint64_t)(ms * 1e6) : 0;
+}
+
+static void deadline_ts(uint64_t ns, struct timespec *ts) {
+    ts->tv_sec = (time_t)(ns / 1000000000ULL);
+    ts->tv_nsec = (long)(ns % 1000000000ULL);
+}
+
+// Release time of `len` bytes that arrived at `now`: serialisation on the
+// rate-limited link, then the one-way delay with uniform +-jitter. A
+// "reordered" chunk is held one extra delay (at least 1 ms). Bytes still
+// leave in order, as TCP delivers them, so everything behind it waits too:
+// the head-of-line stall a reordered segment causes on a real path.
+static uint64_t release_time(relay_dir_t *d, size_t len, uint64_t now) {
+    if (d->link_free_ns < now) {
+        d->link_free_ns = now;
+    }
+    if (bench_opts.relay_rate_mbit > 0) {
+        d->link_free_ns += (uint64_t)((double)len * 8.0 * 1e3 / bench_opts.relay_rate_mbit);
+    }
+
+    int64_t delay = (int64_t)ms_to_ns(bench_opts.relay_delay_ms);
+    uint64_t jitter = ms_to_ns(bench_opts.relay_jitter_ms);
+    if (jitter > 0) {
+        double u = (double)rand_r(&d->seed) / RAND_MAX;
+        delay += (int64_t)((2.0 * u - 1.0) * (double)jitter);
+    }
+    if (bench_opts.relay_reorder_pct > 0 &&
+        (double)rand_r(&d->seed) / RAND_MAX * 100.0 < bench_opts.relay_reorder_pct) {
+        uint64_t hold = ms_to_ns(bench_opts.relay_delay_ms);
+        delay += (int64_t)(hold > 1000000ULL ? hold : 1000000ULL);
+        d->reordered++;
+    }
+    return d->link_free_ns + (uint64_t)(delay > 0 ? delay : 0);
+}
+
+static void conn_release(relay_conn_t *c) {
+    if (__atomic_sub_fetch(&c->refs, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        relay_dir_t *d = &c->dir[i];
+        printf("RELAY conn=%d dir=%s bytes=%llu chunks=%llu reordered=%llu peak_queue_kb=%zu\n",
+               c->index, d->name, (unsigned long long)d->bytes,
+               (unsigned long long)d->chunks, (unsigned long long)d->reordered, d->peak / 1024);
+        while (d->head) {
+            chunk_t *next = d->head->next;
+            free(d->head);
+            d->head = next;
+        }
+        pthread_mutex_destroy(&d->lock);
+        pthread_cond_destroy(&d->cond);
+    }
+    fflush(stdout);
+    close(c->dir[0].from);
+    close(c->dir[0].to);
+    free(c);
+}
+
+static void *relay_reader(void *arg) {
+    relay_arg_t *ra = (relay_arg_t *)arg;
+    relay_conn_t *c = ra->conn;
+    relay_dir_t *d = ra->dir;
+    free(ra);
+    size_t limit = (size_t)bench_opts.relay_queue_kb * 1024;
+
+    for (;;) {
+        // Stop reading while the queue is full so the sender's window closes
+        pthread_mutex_lock(&d->lock);
+        while (!d->dead && d->queued >= limit) {
+            pthread_cond_wait(&d->cond, &d->lock);
+        }
+        int dead = d->dead;
+        pthread_mutex_unlock(&d->lock);
+        if (dead) {
+            break;
+        }
+
+        chunk_t *ch = malloc(sizeof(chunk_t) + RELAY_CHUNK);
+        if (!ch) {
+            perror("malloc failed");
+            break;
+        }
+        ssize_t n = transport_recv(d->from, ch->data, RELAY_CHUNK, 0);
+        if (n < 0 && errno == EINTR) {
+            free(ch);
+            continue;
+        }
+        if (n <= 0) {
+            free(ch);
+            break;
+        }
+        ch->len = (size_t)n;
+        ch->next = NULL;
+
+        pthread_mutex_lock(&d->lock);
+        ch->release_ns = release_time(d, ch->len, now_ns());
+        if (d->tail) {
+            d->tail->next = ch;
+        } else {
+            d->head = ch;
+        }
+        d->tail = ch;
+        d->queued += ch->len;
+        if (d->queued > d->peak) {
+            d->peak = d->queued;
+        }
+        pthread_cond_broadcast(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+    }
+
+    pthread_mutex_lock(&d->lock);
+    d->eof = 1;
+    pthread_cond_broadcast(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    conn_release(c);
+    return NULL;
+}
+
+static int send_chunk(int sock, const chunk_t *ch) {
+    size_t sent = 0;
+    while (sent < ch->len) {
+        ssize_t n = transport_send(sock, ch->data + sent, ch->len - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+static void *relay_writer(void *arg) {
+    relay_arg_t *ra = (relay_arg_t *)arg;
+    relay_conn_t *c = ra->conn;
+    relay_dir_t *d = ra->dir;
+    free(ra);
+
+    pthread_mutex_lock(&d->lock);
+    for (;;) {
+        while (!d->head && !d->eof) {
+            pthread_cond_wait(&d->cond, &d->lock);
+        }
+        if (!d->head) {
+            break;
+        }
+        chunk_t *ch = d->head;
+        uint64_t now = now_ns();
+        if (now < ch->release_ns) {
+            struct timespec ts;
+            deadline_ts(ch->release_ns, &ts);
+            pthread_cond_timedwait(&d->cond, &d->lock, &ts);
+            continue;
+        }
+        d->head = ch->next;
+        if (!d->head) {
+            d->tail = NULL;
+        }
+        pthread_mutex_unlock(&d->lock);
+
+        int rc = send_chunk(d->to, ch);
+
+        pthread_mutex_lock(&d->lock);
+        d->queued -= ch->len;
+        d->bytes += ch->len;
+        d->chunks++;
+        pthread_cond_broadcast(&d->cond);
+        free(ch);
+        if (rc < 0) {
+            // Receiver gone: unblock the reader and let it see EOF
+            d->dead = 1;
+            shutdown(d->from, SHUT_RD);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+
+    // Pass the end of stream on once everything queued has been forwarded
+    shutdown(d->to, SHUT_WR);
+    conn_release(c);
+    return NULL;
+}
+
+static int dir_init(relay_dir_t *d, const char *name, int from, int to, unsigned seed) {
+    memset(d, 0, sizeof(*d));
+    d->name = name;
+    d->from = from;
+    d->to = to;
+    d->seed = seed;
+    pthread_mutex_init(&d->lock, NULL);
+    // Release deadlines are CLOCK_MONOTONIC, like now_ns()
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    int rc = pthread_cond_init(&d->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return rc == 0 ? 0 : -1;
+}
+
+static int spawn_half(void *(*fn)(void *), relay_conn_t *c, relay_dir_t *d) {
+    relay_arg_t *ra = malloc(sizeof(relay_arg_t));
+    if (!ra) {
+        return -1;
+    }
+    ra->conn = c;
+    ra->dir = d;
+    if (conn_thread_spawn(fn, ra) < 0) {
+        free(ra);
+        return -1;
+    }
+    return 0;
+}
+
+// A link forwards bytes as soon as they are due: without TCP_NODELAY the
+// tail of a chunk would wait for the peer's delayed ACK
+static void setup_relay_socket(int sock) {
+    transport_setup_socket(sock);
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static int connect_upstream(const struct sockaddr_in *upstream) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    transport_prepare_socket(sock);
+    if (connect(sock, (const struct sockaddr *)upstream, sizeof(*upstream)) < 0) {
+        close(sock);
+        return -1;
+    }
+    setup_relay_socket(sock);
+    return sock;
+}
+
+int main(int argc, char *argv[]) {
+    argc = parse_bench_options(argc, argv);
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s <listen_port> <server_host> <server_port> [options]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    int port = atoi(argv[1]);
+
+    struct sockaddr_in upstream = {0};
+    upstream.sin_family = AF_INET;
+    upstream.sin_port = htons(atoi(argv[3]));
+    if (inet_pton(AF_INET, argv[2], &upstream.sin_addr) <= 0) {
+        perror("Invalid address/ Address not supported");
+        exit(EXIT_FAILURE);
+    }
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("Socket failed");
+        exit(EXIT_FAILURE);
+    }
+    int opt = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    transport_prepare_socket(listen_fd);
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        exit(EXIT_FAILURE);
+    }
+    if (listen(listen_fd, SOMAXCONN) < 0) {
+        perror("Listen failed");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("Relay listening on port %d -> %s:%s (delay %.3f ms, jitter %.3f ms, rate %.1f Mbit/s, reorder %.2f%%)\n",
+           port, argv[2], argv[3], bench_opts.relay_delay_ms, bench_opts.relay_jitter_ms,
+           bench_opts.relay_rate_mbit, bench_opts.relay_reorder_pct);
+    fflush(stdout);
+    transport_signal_ready();
+
+    int next_index = 0;
+    while (1) {
+        int client = accept(listen_fd, NULL, NULL);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            perror("Accept failed");
+            exit(EXIT_FAILURE);
+        }
+        int server = connect_upstream(&upstream);
+        if (server < 0) {
+            perror("Connection to server failed");
+            close(client);
+            continue;
+        }
+        setup_relay_socket(client);
+
+        relay_conn_t *c = calloc(1, sizeof(relay_conn_t));
+        if (!c || dir_init(&c->dir[0], "up", client, server, 25034u + (unsigned)next_index * 2) < 0 ||
+            dir_init(&c->dir[1], "down", server, client, 25035u + (unsigned)next_index * 2) < 0) {
+            perror("relay setup failed");
+            close(client);
+            close(server);
+            free(c);
+            continue;
+        }
+        c->index = next_index++;
+        c->refs = 4;
+
+        // A half that fails to start counts as finished. Its partner may
+        // already wait on the condition variable, which shutdown() does not
+        // wake: mark the missing reader done (eof) or the missing writer
+        // failed (dead) so the partner drops out too
+        int failed = 0;
+        for (int i = 0; i < 2; i++) {
+            relay_dir_t *d = &c->dir[i];
+            int no_writer = spawn_half(relay_writer, c, d) < 0;
+            int no_reader = spawn_half(relay_reader, c, d) < 0;
+            if (no_writer || no_reader) {
+                pthread_mutex_lock(&d->lock);
+                d->dead |= no_writer;
+                d->eof |= no_reader;
+                pthread_cond_broadcast(&d->cond);
+                pthread_mutex_unlock(&d->lock);
+            }
+            failed += no_writer + no_reader;
+        }
+        if (failed) {
+            perror("pthread_create failed");
+            shutdown(client, SHUT_RDWR);
+            shutdown(server, SHUT_RDWR);
+            for (int i = 0; i < failed; i++) {
+                conn_release(c);
+            }
+        }
+    }
+    return 0;
+}
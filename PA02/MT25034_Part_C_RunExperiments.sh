@@ -12,149 +12,264 @@ MESSAGE_SIZES=(128 512 1024 4096)
 THREAD_COUNTS=(1 2 4 8)
 DURATION=10
 
-PORT_TWO_COPY=9000
-PORT_ONE_COPY=9001
-PORT_ZERO_COPY=9002
-
-# Executables
-A1_SERVER="./MT25034_Part_A1_Server"
-A1_CLIENT="./MT25034_Part_A1_Client"
-
-A2_SERVER="./MT25034_Part_A2_Server"
-A2_CLIENT="./MT25034_Part_A2_Client"
-
-A3_SERVER="./MT25034_Part_A3_Server"
-A3_CLIENT="./MT25034_Part_A3_Client"
-
-# -------------------------------
-# Cleanup function
-# -------------------------------
-cleanup() {
-    echo "[CLEANUP] Killing leftover servers..."
-    pkill -f MT25034_Part_A1_Server 2>/dev/null || true
-    pkill -f MT25034_Part_A2_Server 2>/dev/null || true
-    pkill -f MT25034_Part_A3_Server 2>/dev/null || true
-    sleep 1
-}
-
-trap cleanup EXIT
+# Socket wait modes: "block" sleeps in the kernel, "busypoll" spins on
+# non-blocking sockets with pinned threads (server from the first CPU,
+# client from the middle one).
+POLL_MODES=(block busypoll)
+SPIN_US=50
+
+# Cells run JOBS at a time by MT25034_Part_C_Orchestrator, each job on an
+# equal share of CPUS (empty = every CPU we may use) and its own ports from
+# BASE_PORT. More than one job needs PLACEMENTS=(none).
+JOBS=1
+CPUS=""
+BASE_PORT=9000
+
+# Makefile build variant: release (-O2), native (-march=native), lto, or pgo
+# (instrumented build trained on a short run of every pair, then rebuilt
+# with the profile). Recorded in the Build column.
+BUILD_VARIANT=release
+
+# Socket options passed to both server and client (see --help). With
+# AUTOTUNE=1 every cell first sweeps buffer sizes x Nagle/cork settings in
+# short trials and then runs with the best one; all trials are kept in
+# AUTOTUNE_CSV and the chosen profile lands in the Socket_Profile column.
+SOCKET_FLAGS="--profile=default"
+AUTOTUNE=0
+TUNE_DURATION=2
+TUNE_BUFFERS=(default 65536 262144 1048576 4194304)
+TUNE_NAGLE=("--nodelay=1" "--nodelay=0" "--nodelay=0 --cork=1")
+AUTOTUNE_CSV="Autotune_Trials.csv"
+
+# Page-cache response paths, run against the A3 (ZeroCopy) pair in every
+# cell: the server answers with sendfile() or MSG_ZEROCOPY from an mmapped
+# memfd instead of echoing from user buffers. Empty to skip.
+PAGE_CACHE_RESPONSES=(sendfile mmap-zerocopy)
+
+# ZeroCopy-pair send paths (--send-mode on client and server), each run as an
+# extra row per cell: "zerocopy" really enables SO_ZEROCOPY, "adaptive"
+# picks copy or zero-copy per message size at runtime. Empty to skip.
+SEND_MODES=(zerocopy adaptive)
+
+# UDP pair (MT25034_Part_A4_*), one extra row per mode and cell: single
+# (a system call per datagram), mmsg (sendmmsg/recvmmsg) and gso
+# (UDP_SEGMENT/UDP_GRO). UDP_BATCH datagrams are in flight per thread;
+# UDP_ZEROCOPY=1 adds MSG_ZEROCOPY. Loss and reordering come from sequence
+# numbers (UDP_Sent/UDP_Lost/UDP_Reordered columns). Empty to skip.
+UDP_MODES=(single mmsg gso)
+UDP_BATCH=16
+UDP_ZEROCOPY=0
+
+# Server workload: per-request handler (echo, checksum, transform, cpu),
+# cost of the cpu handler, and response size (empty = same as request).
+HANDLER=echo
+WORK_NS=1000
+RESPONSE_SIZE=""
+
+# Message buffer backing on both sides: off, thp or hugetlb (hugetlb needs
+# pages reserved in /proc/sys/vm/nr_hugepages, else it falls back to thp)
+HUGEPAGES=off
+
+# Message layout on both sides: number of scatter/gather fields (1..IOV_MAX;
+# 1 is a single flat buffer, 64 or 1024 stress the iovec path) and how the
+# bytes are split between them (even, geometric, random)
+FIELDS=8
+FIELD_DIST=even
+
+# Where client and server threads run relative to each other (--placement,
+# from the sysfs topology): none (scheduler), same-core, smt-sibling,
+# same-llc, cross-llc, cross-node. Each entry repeats the whole matrix;
+# message buffers are then allocated on the thread's NUMA node. Policies the
+# machine cannot provide fall back to a closer one, and the Placement column
+# records what was used.
+PLACEMENTS=(none)
+
+# Time series: every INTERVAL_MS the client (and the server with
+# SERVER_INTERVALS=1) appends a row with that interval's messages, bytes,
+# latency percentiles and context switches to TIMESERIES_CSV. Rows carry the
+# Run_ID of their Combined_Results.csv row. 0 disables it.
+INTERVAL_MS=1000
+SERVER_INTERVALS=1
+TIMESERIES_CSV="TimeSeries_Results.csv"
+
+# Kernel TLS (--ktls) with static pre-shared keys on both ends: off,
+# aes-128-gcm, aes-256-gcm or chacha20-poly1305. Each entry repeats the whole
+# matrix. Without the tls module the programs fall back to plaintext, and the
+# KTLS column then says off.
+KTLS_MODES=(off)
+
+# WAN-like runs: with RELAY=1 every TCP client (autotune trials included)
+# connects through MT25034_Part_C_Relay on the server port + 5, which adds the delay, jitter, bandwidth limit and reordering in RELAY_FLAGS
+# to both directions. The Link column records the shaping ("loopback"
+# without the relay).
+RELAY=0
+RELAY_FLAGS="--delay-ms=5 --jitter-ms=0.5 --rate-mbit=1000"
+
+# Connection setup: with CHURN=N every TCP client thread sends N requests per
+# connection, then closes it and opens a new one, at CONNECT_RATE connections
+# per second in total (0 = as fast as it can). FASTOPEN=1 sends the first
+# request in the SYN (TCP Fast Open; net.ipv4.tcp_fastopen is set to 3).
+# ACCEPT_MODE is how the servers take connections in churn runs: thread (a
+# new thread per connection), reuseport or prespawn (ACCEPTORS threads per
+# port, 0 = one per CPU; each serves one connection at a time, so long-lived
+# runs always use thread). The CHURN_* values land in the JSON and the results store.
+CHURN=0
+CONNECT_RATE=0
+FASTOPEN=0
+ACCEPT_MODE=thread
+ACCEPTORS=0
+
+# Results: the CSV keeps the columns of earlier runs (plus Status), the JSON
+# adds the run metadata (kernel, CPU, build flags, git revision) and every
+# value the clients reported
+COMBINED_CSV="Combined_Results.csv"
+COMBINED_JSON="Combined_Results.json"
+
+# Every run is appended, with its metadata, to the SQLite RESULTS_STORE
+# (MT25034_Part_D_Results.py), where the plot scripts read it. RUN_TAG names
+# the run (select it as tag:NAME). REPEATS passes over the matrix give each
+# cell the samples a comparison needs. With BASELINE set (a run id, tag:NAME
+# or latest~N), the run is compared with it afterwards and the script exits
+# non-zero on a significant regression of any metric in COMPARE_METRICS.
+REPEATS=1
+RESULTS_STORE="Results_Store.db"
+RUN_TAG=""
+BASELINE=""
+COMPARE_METRICS="throughput,p99"
+
+# With COST_MODEL=1 the run is checked against the copy-cost model
+# (MT25034_Part_D_CostModel.py): predicted latency of each copy path from
+# CALIBRATION_CSV (made by `make calibrate` when missing) against the
+# measured one. It only reports; it does not change the exit status.
+COST_MODEL=0
+CALIBRATION_CSV="Calibration.csv"
 
 # -------------------------------
-# Initial cleanup
+# Cleanup of servers left by an interrupted older run
 # -------------------------------
-cleanup
+echo "[CLEANUP] Killing leftover servers..."
+pkill -f MT25034_Part_A1_Server 2>/dev/null || true
+pkill -f MT25034_Part_A2_Server 2>/dev/null || true
+pkill -f MT25034_Part_A3_Server 2>/dev/null || true
+pkill -f MT25034_Part_A4_Server 2>/dev/null || true
+pkill -f MT25034_Part_C_Relay 2>/dev/null || true
 
 # -------------------------------
 # Compile
 # -------------------------------
-echo "[BUILD] Compiling all implementations..."
+echo "[BUILD] Compiling all implementations ($BUILD_VARIANT)..."
 
-gcc -pthread -O2 -o MT25034_Part_A1_Server MT25034_Part_A1_Server.c
-gcc -pthread -O2 -o MT25034_Part_A1_Client MT25034_Part_A1_Client.c
-
-gcc -pthread -O2 -o MT25034_Part_A2_Server MT25034_Part_A2_Server.c
-gcc -pthread -O2 -o MT25034_Part_A2_Client MT25034_Part_A2_Client.c
-
-gcc -pthread -O2 -o MT25034_Part_A3_Server MT25034_Part_A3_Server.c
-gcc -pthread -O2 -o MT25034_Part_A3_Client MT25034_Part_A3_Client.c
+make "$BUILD_VARIANT" > /dev/null
 
 echo "[BUILD] Compilation complete."
 
 # -------------------------------
-# Initialize combined CSV file
-# -------------------------------
-COMBINED_CSV="Combined_Results.csv"
-echo "Label,Message_Size,Threads,Duration_s,Time_Elapsed_s,Bytes_Sent,Throughput_Gbps,Latency_us,Cycles,Instructions,Cache_Misses,Context_Switches" > "$COMBINED_CSV"
-
-# -------------------------------
-# Parse perf output and append to CSV
-# -------------------------------
-append_to_csv() {
-    LABEL=$1
-    MSG_SIZE=$2
-    THREADS=$3
-    PERF_FILE=$4
-    DURATION_S=$5
-
-    # Extract metrics from perf output
-    CYCLES=$(awk '/cycles/{print $1; exit}' "$PERF_FILE" | tr -d ',' || true)
-    INSTRUCTIONS=$(awk '/instructions/{print $1; exit}' "$PERF_FILE" | tr -d ',' || true)
-    CACHE_MISSES=$(awk '/cache-misses/{print $1; exit}' "$PERF_FILE" | tr -d ',' || true)
-    CONTEXT_SWITCHES=$(awk '/context-switches/{print $1; exit}' "$PERF_FILE" | tr -d ',' || true)
-    TIME_ELAPSED=$(awk '/seconds time elapsed/{print $1; exit}' "$PERF_FILE" | tr -d ',' || true)
-
-    CYCLES=${CYCLES:-0}
-    INSTRUCTIONS=${INSTRUCTIONS:-0}
-    CACHE_MISSES=${CACHE_MISSES:-0}
-    CONTEXT_SWITCHES=${CONTEXT_SWITCHES:-0}
-    TIME_ELAPSED=${TIME_ELAPSED:-0}
-
-    BYTES_SENT=$((MSG_SIZE * THREADS * DURATION_S))
-    THROUGHPUT_GBPS=$(awk -v bytes="$BYTES_SENT" -v t="$TIME_ELAPSED" 'BEGIN{if (t>0) printf "%.6f", (bytes*8)/(t*1e9); else printf "0"}')
-    LATENCY_US=$(awk -v t="$TIME_ELAPSED" -v thr="$THREADS" -v dur="$DURATION_S" 'BEGIN{if (t>0 && thr>0 && dur>0) printf "%.3f", (t*1e6)/(thr*dur); else printf "0"}')
-
-    # Append to combined CSV
-    echo "$LABEL,$MSG_SIZE,$THREADS,$DURATION_S,$TIME_ELAPSED,$BYTES_SENT,$THROUGHPUT_GBPS,$LATENCY_US,$CYCLES,$INSTRUCTIONS,$CACHE_MISSES,$CONTEXT_SWITCHES" >> "$COMBINED_CSV"
-}
-
-# -------------------------------
-# Run one experiment
+# Run the matrix
 # -------------------------------
 echo -1 | sudo tee /proc/sys/kernel/perf_event_paranoid 2>/dev/null || true
 echo 0 | sudo tee /proc/sys/kernel/kptr_restrict 2>/dev/null || true
-run_experiment() {
-    SERVER=$1
-    CLIENT=$2
-    PORT=$3
-    LABEL=$4
-    MSG_SIZE=$5
-    THREADS=$6
 
-    echo
-    echo "[RUN] $LABEL | MSG_SIZE=$MSG_SIZE | THREADS=$THREADS"
-
-    # Start server
-    $SERVER $PORT $MSG_SIZE &
-    SERVER_PID=$!
-    sleep 1
-
-    # Run client with perf (use a temp file and delete it after parsing)
-    PERF_FILE=$(mktemp)
-    perf stat \
-        -e cycles,instructions,cache-misses,context-switches \
-        -o "$PERF_FILE" \
-        $CLIENT 127.0.0.1 $PORT $THREADS $MSG_SIZE $DURATION
-
-    # Stop server safely
-    if kill -0 "$SERVER_PID" 2>/dev/null; then
-        kill "$SERVER_PID"
-        wait "$SERVER_PID" 2>/dev/null || true
-    fi
+join() {
+    local IFS=,
+    echo "$*"
+}
 
-    # Append results to combined CSV
-    append_to_csv "$LABEL" "$MSG_SIZE" "$THREADS" "$PERF_FILE" "$DURATION"
-    rm -f "$PERF_FILE"
+# Rows per cell, in the order they always had
+LABELS=(TwoCopy OneCopy ZeroCopy)
+for RESPONSE in "${PAGE_CACHE_RESPONSES[@]}"; do
+    case "$RESPONSE" in
+        sendfile) LABELS+=(Sendfile) ;;
+        mmap-zerocopy) LABELS+=(MmapZeroCopy) ;;
+    esac
+done
+for SEND_MODE in "${SEND_MODES[@]}"; do
+    case "$SEND_MODE" in
+        copy) LABELS+=(ZeroCopyPairCopy) ;;
+        zerocopy) LABELS+=(ZeroCopyEnabled) ;;
+        adaptive) LABELS+=(Adaptive) ;;
+    esac
+done
+for UDP_MODE in "${UDP_MODES[@]}"; do
+    case "$UDP_MODE" in
+        single) LABELS+=(UDPSingle) ;;
+        mmsg) LABELS+=(UDPMmsg) ;;
+        gso) LABELS+=(UDPGso) ;;
+    esac
+done
 
-    echo "[DONE] $LABEL | MSG_SIZE=$MSG_SIZE | THREADS=$THREADS"
-}
+ARGS=(
+    --labels="$(join "${LABELS[@]}")"
+    --sizes="$(join "${MESSAGE_SIZES[@]}")"
+    --threads="$(join "${THREAD_COUNTS[@]}")"
+    --duration=$DURATION
+    --repeat=$REPEATS
+    --poll-modes="$(join "${POLL_MODES[@]}")"
+    --placements="$(join "${PLACEMENTS[@]}")"
+    --ktls-modes="$(join "${KTLS_MODES[@]}")"
+    --jobs=$JOBS
+    --base-port=$BASE_PORT
+    --csv=$COMBINED_CSV
+    --json=$COMBINED_JSON
+    --interval-ms=$INTERVAL_MS
+    --interval-csv=$TIMESERIES_CSV
+    --server-intervals=$SERVER_INTERVALS
+)
+if [ -n "$CPUS" ]; then
+    ARGS+=(--cpus="$CPUS")
+fi
+if [ "$RELAY" = "1" ]; then
+    ARGS+=(--relay="$RELAY_FLAGS")
+fi
+if [ "$AUTOTUNE" = "1" ]; then
+    ARGS+=(--autotune --tune-duration=$TUNE_DURATION --autotune-csv=$AUTOTUNE_CSV)
+    ARGS+=(--tune-buffers="$(join "${TUNE_BUFFERS[@]}")")
+    ARGS+=(--tune-nagle="$(IFS=';'; echo "${TUNE_NAGLE[*]}")")
+fi
+
+# Options for every server and client
+read -ra BENCH_FLAGS <<< "$SOCKET_FLAGS"
+BENCH_FLAGS+=(--spin-us=$SPIN_US --handler=$HANDLER --work-ns=$WORK_NS --hugepages=$HUGEPAGES)
+BENCH_FLAGS+=(--fields=$FIELDS --field-dist=$FIELD_DIST --batch=$UDP_BATCH)
+if [ -n "$RESPONSE_SIZE" ]; then
+    BENCH_FLAGS+=(--response-size=$RESPONSE_SIZE)
+fi
+if [ "$UDP_ZEROCOPY" = "1" ]; then
+    BENCH_FLAGS+=(--udp-zerocopy)
+fi
+if [ "$CHURN" -gt 0 ]; then
+    BENCH_FLAGS+=(--churn=$CHURN --connect-rate=$CONNECT_RATE)
+    BENCH_FLAGS+=(--accept=$ACCEPT_MODE --acceptors=$ACCEPTORS)
+fi
+if [ "$FASTOPEN" = "1" ]; then
+    echo 3 | sudo tee /proc/sys/net/ipv4/tcp_fastopen > /dev/null 2>&1 || true
+    BENCH_FLAGS+=(--fastopen)
+fi
+
+# Exits non-zero when any run failed; failed rows keep their metric columns
+# empty and say failed or timeout in Status
+STATUS=0
+./MT25034_Part_C_Orchestrator "${ARGS[@]}" "${BENCH_FLAGS[@]}" || STATUS=$?
 
 # -------------------------------
-# Main experiment loop
+# Store, and compare with the baseline
 # -------------------------------
-for MSG_SIZE in "${MESSAGE_SIZES[@]}"; do
-    for THREADS in "${THREAD_COUNTS[@]}"; do
-
-        run_experiment "$A1_SERVER" "$A1_CLIENT" \
-            "$PORT_TWO_COPY" "TwoCopy" "$MSG_SIZE" "$THREADS"
-
-        run_experiment "$A2_SERVER" "$A2_CLIENT" \
-            "$PORT_ONE_COPY" "OneCopy" "$MSG_SIZE" "$THREADS"
-
-        run_experiment "$A3_SERVER" "$A3_CLIENT" \
-            "$PORT_ZERO_COPY" "ZeroCopy" "$MSG_SIZE" "$THREADS"
-
-    done
-done
-
-echo
-echo "[SUCCESS] All PA02 experiments completed."
+if [ -f "$COMBINED_CSV" ]; then
+    python3 MT25034_Part_D_Results.py --store="$RESULTS_STORE" add \
+        --csv="$COMBINED_CSV" --json="$COMBINED_JSON" --tag="$RUN_TAG" || STATUS=1
+fi
+if [ -n "$BASELINE" ]; then
+    echo
+    echo "[COMPARE] $BASELINE -> this run"
+    python3 MT25034_Part_D_Results.py --store="$RESULTS_STORE" compare \
+        "$BASELINE" latest --metrics="$COMPARE_METRICS" || STATUS=$?
+fi
+if [ "$COST_MODEL" = 1 ] && [ -f "$COMBINED_CSV" ]; then
+    echo
+    echo "[MODEL] Copy-cost model vs this run"
+    if [ ! -f "$CALIBRATION_CSV" ]; then
+        ./MT25034_Part_C_MicroBench --calibrate --csv="$CALIBRATION_CSV" > /dev/null
+    fi
+    python3 MT25034_Part_D_CostModel.py --store="$RESULTS_STORE" --run=latest \
+        --calibration="$CALIBRATION_CSV" || true
+fi
+exit $STATUS
@@ -0,0 +1,148 @@
+#!/bin/bash
+# ==========================================================
+# MT25034 - PA02 Connection Scaling Script
+# Multiplexed clients (--conns) from 10 to 100k connections,
+# server memory per idle and active connection
+# ==========================================================
+
+set -euo pipefail
+
+# -------------------------------
+# Configuration
+# -------------------------------
+CONN_COUNTS=(10 100 1000 10000 100000)
+MSG_SIZE=512
+CLIENT_THREADS=4
+DURATION=10
+# Connects per second while ramping up (0 = as fast as possible)
+CONNECT_RATE=20000
+# Seconds the connections stay idle after the ramp, before traffic starts
+IDLE_S=6
+
+# Server memory modes: "default" is a full pthread stack and per-connection
+# buffers; "lean" uses small stacks and borrows buffers from a shared pool
+MEMORY_MODES=(default lean)
+LEAN_FLAGS="--stack-kb=64 --buffer-pool"
+
+PORT_TWO_COPY=9000
+PORT_ONE_COPY=9001
+PORT_ZERO_COPY=9002
+
+SCALING_CSV="Scaling_Results.csv"
+
+# Makefile build variant (release, native, lto or pgo), recorded per row
+BUILD_VARIANT=release
+
+# -------------------------------
+# Cleanup function
+# -------------------------------
+cleanup() {
+    echo "[CLEANUP] Killing leftover servers..."
+    pkill -f MT25034_Part_A1_Server 2>/dev/null || true
+    pkill -f MT25034_Part_A2_Server 2>/dev/null || true
+    pkill -f MT25034_Part_A3_Server 2>/dev/null || true
+    sleep 1
+}
+
+trap cleanup EXIT
+cleanup
+
+# Every connection costs a descriptor on both ends
+ulimit -n "$(ulimit -Hn)" 2>/dev/null || true
+echo "[INFO] Open file limit: $(ulimit -n)"
+
+echo "[BUILD] Compiling all implementations ($BUILD_VARIANT)..."
+make "$BUILD_VARIANT" > /dev/null
+echo "[BUILD] Compilation complete."
+
+echo "Label,Memory_Mode,Message_Size,Client_Threads,Connections,Established,Failed,Dropped,Ramp_s,Throughput_Gbps,P50_Latency_us,P99_Latency_us,P999_Latency_us,Server_Threads,Server_RSS_Base_kB,Server_RSS_Idle_kB,Server_RSS_Active_kB,Bytes_Per_Idle_Connection,Bytes_Per_Active_Connection,Client_RSS_kB,Build" > "$SCALING_CSV"
+
+status_field() {
+    awk -v key="$2:" '$1 == key {print $2}' "/proc/$1/status" 2>/dev/null || true
+}
+
+line_field() {
+    echo "$1" | tr ' ' '\n' | awk -F= -v key="$2" '$1 == key {print substr($0, length(key) + 2)}'
+}
+
+# Server RSS growth over the connection-less baseline, per connection
+per_conn() {
+    awk -v r="$1" -v b="$2" -v n="$3" 'BEGIN{if (n > 0) printf "%.0f", (r - b) * 1024 / n; else print 0}'
+}
+
+# -------------------------------
+# Run one scaling point
+# -------------------------------
+run_scaling() {
+    SERVER=$1
+    CLIENT=$2
+    PORT=$3
+    LABEL=$4
+    CONNS=$5
+    MODE=$6
+
+    MEM_FLAGS=()
+    if [ "$MODE" = "lean" ]; then
+        read -ra MEM_FLAGS <<< "$LEAN_FLAGS"
+    fi
+
+    echo
+    echo "[RUN] $LABEL | MEMORY=$MODE | CONNECTIONS=$CONNS"
+
+    $SERVER $PORT $MSG_SIZE "${MEM_FLAGS[@]}" > /dev/null &
+    SERVER_PID=$!
+    sleep 1
+    RSS_BASE=$(status_field "$SERVER_PID" VmRSS)
+
+    OUT_FILE=$(mktemp)
+    $CLIENT 127.0.0.1 $PORT $CLIENT_THREADS $MSG_SIZE $DURATION \
+        --conns=$CONNS --connect-rate=$CONNECT_RATE --idle-s=$IDLE_S > "$OUT_FILE" &
+    CLIENT_PID=$!
+
+    # Sample the server in the middle of the idle hold, then halfway
+    # through the steady phase
+    RAMP_EST=$(awk -v c="$CONNS" -v r="$CONNECT_RATE" 'BEGIN{if (r > 0) printf "%d", c / r + 1; else print 1}')
+    sleep $((RAMP_EST + IDLE_S / 2))
+    RSS_IDLE=$(status_field "$SERVER_PID" VmRSS)
+    sleep $((IDLE_S - IDLE_S / 2 + DURATION / 2))
+    RSS_ACTIVE=$(status_field "$SERVER_PID" VmRSS)
+    SERVER_THREADS=$(status_field "$SERVER_PID" Threads)
+    wait "$CLIENT_PID" || true
+
+    if kill -0 "$SERVER_PID" 2>/dev/null; then
+        kill "$SERVER_PID"
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+
+    SUMMARY=$(grep '^SUMMARY' "$OUT_FILE" || true)
+    MUX=$(grep '^MUX' "$OUT_FILE" || true)
+    rm -f "$OUT_FILE"
+
+    ESTABLISHED=$(line_field "$MUX" established)
+    ESTABLISHED=${ESTABLISHED:-0}
+    RSS_BASE=${RSS_BASE:-0}
+    RSS_IDLE=${RSS_IDLE:-0}
+    RSS_ACTIVE=${RSS_ACTIVE:-0}
+    BYTES_PER_IDLE=$(per_conn "$RSS_IDLE" "$RSS_BASE" "$ESTABLISHED")
+    BYTES_PER_ACTIVE=$(per_conn "$RSS_ACTIVE" "$RSS_BASE" "$ESTABLISHED")
+
+    echo "$LABEL,$MODE,$MSG_SIZE,$CLIENT_THREADS,$CONNS,$ESTABLISHED,$(line_field "$MUX" failed),$(line_field "$MUX" dropped),$(line_field "$MUX" ramp_s),$(line_field "$SUMMARY" throughput_gbps),$(line_field "$SUMMARY" p50_us),$(line_field "$SUMMARY" p99_us),$(line_field "$SUMMARY" p999_us),${SERVER_THREADS:-0},$RSS_BASE,$RSS_IDLE,$RSS_ACTIVE,$BYTES_PER_IDLE,$BYTES_PER_ACTIVE,$(line_field "$MUX" client_rss_kb),$(line_field "$SUMMARY" build)" >> "$SCALING_CSV"
+
+    echo "[DONE] $LABEL | MEMORY=$MODE | CONNECTIONS=$CONNS | established=$ESTABLISHED | idle ${BYTES_PER_IDLE} B/conn | active ${BYTES_PER_ACTIVE} B/conn"
+    # Let TIME_WAIT sockets from this point drain before the next one
+    sleep 2
+}
+
+# -------------------------------
+# Main loop
+# -------------------------------
+for MODE in "${MEMORY_MODES[@]}"; do
+    for CONNS in "${CONN_COUNTS[@]}"; do
+        run_scaling ./MT25034_Part_A1_Server ./MT25034_Part_A1_Client "$PORT_TWO_COPY" "TwoCopy" "$CONNS" "$MODE"
+        run_scaling ./MT25034_Part_A2_Server ./MT25034_Part_A2_Client "$PORT_ONE_COPY" "OneCopy" "$CONNS" "$MODE"
+        run_scaling ./MT25034_Part_A3_Server ./MT25034_Part_A3_Client "$PORT_ZERO_COPY" "ZeroCopy" "$CONNS" "$MODE"
+    done
+done
+
+echo
+echo "[SUCCESS] Scaling results written to $SCALING_CSV"
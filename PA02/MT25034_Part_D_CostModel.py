@@ -0,0 +1,172 @@
+"""Copy-cost model: predicted latency of each copy path from the machine's
+calibration, next to what the results store measured.
+
+	python3 MT25034_Part_D_CostModel.py [--calibration=Calibration.csv]
+	    [--store=F] [--run=SEL] [--poll-mode=M] [--tolerance=X] [--margin=PCT] [--csv=F]
+
+The calibration comes from `make calibrate` (MT25034_Part_C_MicroBench
+--calibrate): memcpy bandwidth per cache level and the loopback round trip.
+A round trip is predicted as that round trip plus every byte copy the path
+makes, at the bandwidth of the first level its buffers fit in. Cells whose
+measured latency is more than --tolerance times off the prediction, and
+pairs of paths measured in the opposite order to their predicted cost by
+more than --margin percent, are flagged.
+"""
+import argparse
+import csv
+import sys
+
+from MT25034_Part_D_Results import (CELL_COLUMNS, DEFAULT_STORE, cell_key, describe_cell,
+                                    load_plot_rows, median, metric_value, number)
+
+# Byte copies per round trip, (request, response). User-space packing counts
+# like a kernel copy; the default echo handler modifies nothing, so the
+# servers send their response straight from the received buffer.
+COPIES = {
+	"TwoCopy": (4, 2),          # pack, send, recv, unpack / send, recv
+	"OneCopy": (2, 2),          # sendmsg, recvmsg / sendmsg, recvmsg
+	"ZeroCopy": (2, 2),         # MSG_ZEROCOPY without SO_ZEROCOPY copies
+	"ZeroCopyPairCopy": (2, 2),
+	"ZeroCopyEnabled": (1, 1),  # only the receives copy
+	"Sendfile": (2, 1),         # page cache to socket without a copy
+	"MmapZeroCopy": (2, 1),
+}
+
+# A zero-copy send to a local socket is copied when it is delivered
+LOOPBACK_COPIES = {
+	"ZeroCopyEnabled": (2, 2),
+	"MmapZeroCopy": (2, 2),
+}
+
+
+def load_calibration(path):
+	try:
+		with open(path, newline="", encoding="utf-8") as f:
+			rows = list(csv.DictReader(f))
+	except OSError as e:
+		sys.exit(f"{path}: {e.strerror} (run `make calibrate` first)")
+	levels, rtt_ns, cpus = [], None, 1
+	for row in rows:
+		if row["Level"] == "Loopback_RTT":
+			rtt_ns = number(row["Latency_ns"])
+		else:
+			# DRAM has no cache size: it holds whatever the caches do not
+			size = number(row["Cache_Bytes"]) or float("inf")
+			levels.append((row["Level"], size, number(row["Memcpy_GBps"])))
+		cpus = int(number(row.get("Online_CPUs")) or cpus)
+	if not levels or rtt_ns is None:
+		sys.exit(f"{path}: not a calibration file (no levels or no loopback round trip)")
+	return sorted(levels, key=lambda level: level[1]), rtt_ns, cpus
+
+
+def predict(row, calibration):
+	"""(copies, bytes copied, level, predicted µs) of a row, None without a model."""
+	levels, rtt_ns, cpus = calibration
+	label = row.get("Label")
+	if label not in COPIES:
+		return None
+	size = number(row.get("Message_Size"))
+	threads = number(row.get("Threads")) or 1
+	resp = number(row.get("Response_Size")) or size
+	if size is None:
+		return None
+	loopback = (row.get("Link") or "loopback") == "loopback"
+	req_copies, resp_copies = (LOOPBACK_COPIES if loopback else {}).get(label, COPIES[label])
+	copied = req_copies * size + resp_copies * resp
+
+	# Both ends hold a request and a response buffer per connection
+	working_set = (size + resp) * 2 * threads
+	name, _, gbps = next(level for level in levels if level[1] >= working_set or level == levels[-1])
+	copy_ns = copied / gbps if gbps else 0.0
+	# Threads beyond the CPUs queue for them
+	share = max(1.0, threads / cpus)
+	return (req_copies, resp_copies), copied, name, (rtt_ns + copy_ns) * share / 1000.0
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Copy-cost model against measured latency")
+	parser.add_argument("--calibration", default="Calibration.csv",
+	                    help="output of make calibrate (default %(default)s)")
+	parser.add_argument("--store", default=DEFAULT_STORE, help="results store (default %(default)s)")
+	parser.add_argument("--run", default="latest", help="runs to check (default %(default)s)")
+	parser.add_argument("--poll-mode", default="block", help="poll mode to check (default %(default)s)")
+	parser.add_argument("--tolerance", type=float, default=3.0,
+	                    help="measured/predicted ratio beyond which a cell is off-model (default %(default)s)")
+	parser.add_argument("--margin", type=float, default=10.0,
+	                    help="percent a cheaper path may be slower before it is an inversion "
+	                         "(default %(default)s)")
+	parser.add_argument("--csv", help="also write the table to this CSV")
+	args = parser.parse_args()
+	if args.tolerance <= 1.0 or args.margin < 0.0:
+		parser.error("--tolerance must be above 1 and --margin not negative")
+
+	calibration = load_calibration(args.calibration)
+	rows, caption = load_plot_rows(args)
+
+	# Median measured latency per cell, with the prediction of its label
+	measured, model = {}, {}
+	for row in rows:
+		v = metric_value(row, "latency")
+		p = predict(row, calibration)
+		if v is None or p is None:
+			continue
+		key = cell_key(row)
+		measured.setdefault(key, []).append(v)
+		model[key] = p
+	if not model:
+		sys.exit("no rows with a modelled label and a latency")
+
+	label_at = CELL_COLUMNS.index("Label")
+	results = []
+	for key in sorted(model, key=lambda k: (k[:label_at] + k[label_at + 1:], k[label_at])):
+		copies, copied, level, predicted = model[key]
+		value = median(measured[key])
+		ratio = value / predicted if predicted else float("inf")
+		flag = "off-model" if ratio > args.tolerance or ratio < 1.0 / args.tolerance else ""
+		results.append({"key": key, "copies": copies, "copied": copied, "level": level,
+		                "predicted": predicted, "measured": value, "ratio": ratio, "flag": flag})
+
+	# Inversions: in one cell, a path predicted no dearer than another but
+	# measured slower than it by more than the margin
+	by_cell = {}
+	for r in results:
+		by_cell.setdefault(r["key"][:label_at] + r["key"][label_at + 1:], []).append(r)
+	inversions = []
+	for cell in by_cell.values():
+		for a in cell:
+			for b in cell:
+				if (a is not b and a["predicted"] <= b["predicted"] and
+				    a["measured"] > b["measured"] * (1.0 + args.margin / 100.0)):
+					inversions.append((a, b))
+					a["flag"] = (a["flag"] + " " if a["flag"] else "") + f"slower-than-{b['key'][label_at]}"
+
+	print(caption)
+	levels, rtt_ns, cpus = calibration
+	print(f"Calibration {args.calibration}: loopback RTT {rtt_ns / 1000.0:.2f} us, {cpus} CPU(s), memcpy "
+	      + ", ".join(f"{name} {gbps:.1f} GB/s" for name, _, gbps in levels))
+	print(f"{'Cell':<44} {'Copies':>6} {'Copied_B':>9} {'Level':>5} {'Pred_us':>9} {'Meas_us':>9} "
+	      f"{'Ratio':>6}  Flag")
+	for r in results:
+		print(f"{describe_cell(r['key']):<44} {r['copies'][0]}+{r['copies'][1]:<4} {r['copied']:>9.0f} "
+		      f"{r['level']:>5} {r['predicted']:>9.2f} {r['measured']:>9.2f} {r['ratio']:>6.2f}  {r['flag']}")
+	for a, b in inversions:
+		print(f"INVERSION {describe_cell(a['key'])}: {a['measured']:.2f} us vs "
+		      f"{b['key'][label_at]} {b['measured']:.2f} us, predicted {a['predicted']:.2f} <= "
+		      f"{b['predicted']:.2f} us")
+	off = sum(1 for r in results if r["flag"].startswith("off-model"))
+	print(f"{len(results)} cell(s) modelled, {off} off-model beyond {args.tolerance:g}x, "
+	      f"{len(inversions)} inversion(s) beyond {args.margin:g}%")
+
+	if args.csv:
+		with open(args.csv, "w", newline="", encoding="utf-8") as f:
+			writer = csv.writer(f)
+			writer.writerow(CELL_COLUMNS + ["Request_Copies", "Response_Copies", "Bytes_Copied",
+			                                "Cache_Level", "Predicted_us", "Measured_us", "Ratio", "Flag"])
+			for r in results:
+				writer.writerow(list(r["key"]) + [r["copies"][0], r["copies"][1], f"{r['copied']:.0f}",
+				                                  r["level"], f"{r['predicted']:.3f}",
+				                                  f"{r['measured']:.3f}", f"{r['ratio']:.3f}", r["flag"]])
+
+
+if __name__ == "__main__":
+	main()
@@ -1,51 +1,11 @@
-import os
-import platform
 import matplotlib.pyplot as plt
 
-# Hardcoded data from Combined_Results.csv for all thread counts
-THREAD_COUNTS = [1, 2, 4, 8]
-MESSAGE_SIZES = [128, 512, 1024, 4096]
-CACHE_MISSES_BY_LABEL_THREAD = {
-	"TwoCopy": {
-		1: [107219.0, 106700.0, 97806.0, 102821.0],
-		2: [346419.0, 217883.0, 229812.0, 141078.0],
-		4: [238685.0, 269616.0, 289266.0, 385535.0],
-		8: [286539.0, 208377.0, 250563.0, 238552.0],
-	},
-	"OneCopy": {
-		1: [115070.0, 115127.0, 77705.0, 106093.0],
-		2: [148972.0, 232640.0, 167781.0, 147285.0],
-		4: [205132.0, 255603.0, 252697.0, 322010.0],
-		8: [212370.0, 223984.0, 200958.0, 201646.0],
-	},
-	"ZeroCopy": {
-		1: [141916.0, 109552.0, 98646.0, 100333.0],
-		2: [150452.0, 209518.0, 178890.0, 164661.0],
-		4: [255476.0, 227507.0, 240896.0, 314653.0],
-		8: [243738.0, 245050.0, 213396.0, 217562.0],
-	},
-}
-
+from MT25034_Part_D_Results import distinct, label_style, load_plot_rows, plot_arguments, series
 
-def system_info():
-	cpu_model = "Unknown CPU"
-	try:
-		with open("/proc/cpuinfo", "r", encoding="utf-8") as f:
-			for line in f:
-				if "model name" in line:
-					cpu_model = line.strip().split(":", 1)[1].strip()
-					break
-	except OSError:
-		pass
-	return f"System: {platform.platform()} | CPU: {cpu_model} | Cores: {os.cpu_count()}"
+# Data from the results store (latest run unless --run says otherwise)
+args = plot_arguments("Cache Misses vs Message Size, one plot per thread count")
+rows, caption = load_plot_rows(args)
 
-
-labels = ["TwoCopy", "OneCopy", "ZeroCopy"]
-style = {
-	"TwoCopy": {"color": "#1f77b4", "marker": "o"},
-	"OneCopy": {"color": "#2ca02c", "marker": "s"},
-	"ZeroCopy": {"color": "#d62728", "marker": "^"},
-}
 thread_linestyle = {
 	1: "-",
 	2: "--",
@@ -53,19 +13,21 @@ thread_linestyle = {
 	8: ":",
 }
 
-plt.figure(figsize=(10, 6))
-for threads in THREAD_COUNTS:
+for threads in distinct(rows, "Threads"):
+	lines = series(rows, "cache_misses", "Message_Size", {"Threads": threads})
+	if not lines:
+		print(f"No cache misses data for {threads} thread(s) (no hardware counters in this run?)")
+		continue
 	plt.figure(figsize=(10, 6))
-	for label in labels:
-		message_sizes = MESSAGE_SIZES
-		cache_misses = CACHE_MISSES_BY_LABEL_THREAD[label][threads]
+	for index, (label, (message_sizes, cache_misses)) in enumerate(lines.items()):
+		style = label_style(label, index)
 		plt.plot(
 			message_sizes,
 			cache_misses,
 			label=f"{label}",
-			color=style[label]["color"],
-			marker=style[label]["marker"],
-			linestyle=thread_linestyle[threads],
+			color=style["color"],
+			marker=style["marker"],
+			linestyle=thread_linestyle.get(threads, "-"),
 			linewidth=2.0,
 			markersize=6,
 			alpha=0.95,
@@ -78,7 +40,7 @@ for threads in THREAD_COUNTS:
 	plt.xscale("log")
 	plt.grid(True, which="both", linestyle="--", linewidth=0.5, alpha=0.6)
 	plt.legend(loc="best", frameon=True, fontsize=9)
-	plt.figtext(0.5, 0.01, system_info(), ha="center", fontsize=8)
+	plt.figtext(0.5, 0.01, caption, ha="center", fontsize=8)
 	plt.tight_layout(rect=[0, 0.03, 1, 1])
 	plt.savefig(f"Cache_Misses_vs_Message_Size_T{threads}.png")
-	plt.close()
\ No newline at end of file
+	plt.close()
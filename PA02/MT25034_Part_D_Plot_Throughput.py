@@ -1,51 +1,11 @@
-import os
-import platform
 import matplotlib.pyplot as plt
 
-# Hardcoded data from Combined_Results.csv for all thread counts
-THREAD_COUNTS = [1, 2, 4, 8]
-MESSAGE_SIZES = [128, 512, 1024, 4096]
-THROUGHPUT_GBPS_BY_LABEL_THREAD = {
-	"TwoCopy": {
-		1: [0.000001, 0.000004, 0.000008, 0.000033],
-		2: [0.000002, 0.000008, 0.000016, 0.000066],
-		4: [0.000004, 0.000016, 0.000033, 0.000131],
-		8: [0.000007, 0.000033, 0.000060, 0.000239],
-	},
-	"OneCopy": {
-		1: [0.000001, 0.000004, 0.000008, 0.000033],
-		2: [0.000002, 0.000008, 0.000016, 0.000066],
-		4: [0.000004, 0.000016, 0.000033, 0.000131],
-		8: [0.000008, 0.000033, 0.000060, 0.000239],
-	},
-	"ZeroCopy": {
-		1: [0.000001, 0.000004, 0.000008, 0.000033],
-		2: [0.000002, 0.000008, 0.000016, 0.000066],
-		4: [0.000004, 0.000016, 0.000033, 0.000131],
-		8: [0.000008, 0.000030, 0.000060, 0.000239],
-	},
-}
-
+from MT25034_Part_D_Results import distinct, label_style, load_plot_rows, plot_arguments, series
 
-def system_info():
-	cpu_model = "Unknown CPU"
-	try:
-		with open("/proc/cpuinfo", "r", encoding="utf-8") as f:
-			for line in f:
-				if "model name" in line:
-					cpu_model = line.strip().split(":", 1)[1].strip()
-					break
-	except OSError:
-		pass
-	return f"System: {platform.platform()} | CPU: {cpu_model} | Cores: {os.cpu_count()}"
+# Data from the results store (latest run unless --run says otherwise)
+args = plot_arguments("Throughput vs Message Size, one plot per thread count")
+rows, caption = load_plot_rows(args)
 
-
-labels = ["TwoCopy", "OneCopy", "ZeroCopy"]
-style = {
-	"TwoCopy": {"color": "#1f77b4", "marker": "o"},
-	"OneCopy": {"color": "#2ca02c", "marker": "s"},
-	"ZeroCopy": {"color": "#d62728", "marker": "^"},
-}
 thread_linestyle = {
 	1: "-",
 	2: "--",
@@ -53,18 +13,21 @@ thread_linestyle = {
 	8: ":",
 }
 
-for threads in THREAD_COUNTS:
+for threads in distinct(rows, "Threads"):
+	lines = series(rows, "throughput", "Message_Size", {"Threads": threads})
+	if not lines:
+		print(f"No throughput data for {threads} thread(s)")
+		continue
 	plt.figure(figsize=(10, 6))
-	for label in labels:
-		message_sizes = MESSAGE_SIZES
-		throughput = THROUGHPUT_GBPS_BY_LABEL_THREAD[label][threads]
+	for index, (label, (message_sizes, throughput)) in enumerate(lines.items()):
+		style = label_style(label, index)
 		plt.plot(
 			message_sizes,
 			throughput,
 			label=f"{label}",
-			color=style[label]["color"],
-			marker=style[label]["marker"],
-			linestyle=thread_linestyle[threads],
+			color=style["color"],
+			marker=style["marker"],
+			linestyle=thread_linestyle.get(threads, "-"),
 			linewidth=2.0,
 			markersize=6,
 			alpha=0.95,
@@ -77,7 +40,7 @@ for threads in THREAD_COUNTS:
 	plt.xscale("log")
 	plt.grid(True, which="both", linestyle="--", linewidth=0.5, alpha=0.6)
 	plt.legend(loc="best", frameon=True, fontsize=9)
-	plt.figtext(0.5, 0.01, system_info(), ha="center", fontsize=8)
+	plt.figtext(0.5, 0.01, caption, ha="center", fontsize=8)
 	plt.tight_layout(rect=[0, 0.03, 1, 1])
 	plt.savefig(f"Throughput_vs_Message_Size_T{threads}.png")
-	plt.close()
\ No newline at end of file
+	plt.close()
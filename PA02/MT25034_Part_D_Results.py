@@ -0,0 +1,473 @@
+"""Results store: every experiment run with its metadata, in one SQLite file.
+
+	python3 MT25034_Part_D_Results.py add [--csv=F] [--json=F] [--tag=NAME]
+	python3 MT25034_Part_D_Results.py list
+	python3 MT25034_Part_D_Results.py compare BASELINE CANDIDATE [--metrics=LIST]
+
+Runs are selected by run id (the orchestrator's run stamp), "latest",
+"latest~N" (N runs before the latest), "tag:NAME" (every run with that tag),
+or a comma-separated list of those; selected runs are pooled.
+
+compare exits 1 when a metric of any cell got significantly worse, 0
+otherwise, and 2 when no cell has enough samples to test.
+"""
+import argparse
+import csv
+import json
+import math
+import os
+import platform
+import sqlite3
+import sys
+import time
+
+DEFAULT_STORE = "Results_Store.db"
+
+# Columns naming a cell of the matrix. Build and Repeat are left out, so
+# build variants and repeats of one cell pool and compare with each other.
+CELL_COLUMNS = [
+	"Label", "Message_Size", "Threads", "Duration_s", "Poll_Mode", "Socket_Profile",
+	"Response_Size", "Handler", "Hugepages", "Fields", "Field_Dist", "Placement", "KTLS", "Link",
+]
+
+# Comparable metrics: the columns to read, first one present wins (or None
+# for a derived value), and whether more is better. SUMMARY_* columns are
+# what the client measured, from the JSON; the CSV's Throughput_Gbps and
+# Latency_us keep the shell loop's nominal definitions and are the fallback
+# for runs stored without their JSON.
+METRICS = {
+	"throughput": (("SUMMARY_throughput_gbps", "Throughput_Gbps"), True),
+	"latency": (("SUMMARY_avg_us", "Latency_us"), False),
+	"p50": (("P50_Latency_us",), False),
+	"p99": (("P99_Latency_us",), False),
+	"p999": (("SUMMARY_p999_us",), False),
+	"cache_misses": (("Cache_Misses",), False),
+	"cycles_per_byte": (None, False),
+	"context_switches": (("Context_Switches",), False),
+	"client_cpu": (("Client_CPU_Pct",), False),
+	"server_cpu": (("Server_CPU_Pct",), False),
+}
+DEFAULT_METRICS = "throughput,p99"
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS runs (
+	run_id TEXT PRIMARY KEY,
+	added TEXT,
+	tag TEXT,
+	started TEXT,
+	hostname TEXT,
+	kernel TEXT,
+	cpu_model TEXT,
+	online_cpus INTEGER,
+	compiler TEXT,
+	cflags TEXT,
+	variant TEXT,
+	git_revision TEXT,
+	tree_revision TEXT,
+	command TEXT,
+	metadata TEXT
+);
+CREATE TABLE IF NOT EXISTS results (
+	store_run_id TEXT NOT NULL REFERENCES runs(run_id),
+	store_row INTEGER NOT NULL
+);
+CREATE INDEX IF NOT EXISTS results_run ON results(store_run_id);
+"""
+
+
+def open_store(path, create=False):
+	if not create and not os.path.exists(path):
+		sys.exit(f"{path}: no results store yet (run the experiments, or add a CSV)")
+	db = sqlite3.connect(path)
+	db.row_factory = sqlite3.Row
+	db.executescript(SCHEMA)
+	return db
+
+
+def result_columns(db):
+	# SQLite column names ignore case
+	return [r["name"].lower() for r in db.execute("PRAGMA table_info(results)")]
+
+
+def number(value):
+	"""Float of a CSV cell, None when it is empty or not a number."""
+	try:
+		v = float(value)
+	except (TypeError, ValueError):
+		return None
+	return v if math.isfinite(v) else None
+
+
+def metric_value(row, metric):
+	columns, _ = METRICS[metric]
+	if columns is None:
+		# Per byte the client actually moved when the JSON is there
+		cycles = number(row.get("Cycles"))
+		nbytes = number(row.get("SUMMARY_bytes")) or number(row.get("Bytes_Sent"))
+		return cycles / nbytes if cycles is not None and nbytes else None
+	for column in columns:
+		v = number(row.get(column))
+		if v is not None:
+			return v
+	return None
+
+
+def median(values):
+	values = sorted(values)
+	n = len(values)
+	if n == 0:
+		return None
+	return values[n // 2] if n % 2 else (values[n // 2 - 1] + values[n // 2]) / 2.0
+
+
+# ---------------------------------------------------------------------------
+# add / list
+# ---------------------------------------------------------------------------
+
+def add_run(db, csv_path, json_path, tag):
+	with open(csv_path, newline="", encoding="utf-8") as f:
+		reader = csv.DictReader(f)
+		header = reader.fieldnames or []
+		rows = list(reader)
+	if not rows:
+		sys.exit(f"{csv_path}: no result rows")
+
+	meta = {}
+	if json_path and os.path.exists(json_path):
+		with open(json_path, encoding="utf-8") as f:
+			meta = json.load(f)
+	run_id = meta.get("run_stamp")
+	if not run_id and rows[0].get("Run_ID"):
+		run_id = rows[0]["Run_ID"].rsplit("-", 1)[0]
+	if not run_id:
+		# Results from before the orchestrator: the CSV's time stands in
+		run_id = time.strftime("%Y%m%d%H%M%S", time.localtime(os.path.getmtime(csv_path)))
+	if db.execute("SELECT 1 FROM runs WHERE run_id = ?", (run_id,)).fetchone():
+		sys.exit(f"run {run_id} is already in the store")
+
+	# Every value the client reported, as TAG_key columns next to its CSV row
+	outputs = {r.get("run_id"): r.get("output", {}) for r in meta.get("runs", [])}
+	for row in rows:
+		for line, fields in outputs.get(row.get("Run_ID"), {}).items():
+			for key, value in fields.items():
+				row[f"{line}_{key}"] = value
+	header = list(dict.fromkeys(header + [k for row in rows for k in row]))
+
+	host = meta.get("host", {})
+	build = meta.get("build", {})
+	summary = {k: v for k, v in meta.items() if k != "runs"}
+	variant = build.get("variant") or (rows[0].get("Build") or None)
+	db.execute(
+		"INSERT INTO runs VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+		(run_id, time.strftime("%Y-%m-%dT%H:%M:%S"), tag or None, meta.get("started"),
+		 host.get("hostname", platform.node()), host.get("kernel"), host.get("cpu_model"),
+		 host.get("online_cpus", os.cpu_count()), build.get("compiler"), build.get("cflags"),
+		 variant, build.get("git_revision"), build.get("tree_revision"),
+		 " ".join(meta.get("command", [])) or None, json.dumps(summary)))
+
+	# Results take whatever columns the CSV has; new ones are added as they come
+	have = set(result_columns(db))
+	for column in header:
+		if column.lower() not in have:
+			db.execute(f'ALTER TABLE results ADD COLUMN "{column}"')
+			have.add(column.lower())
+	columns = ", ".join(f'"{c}"' for c in header)
+	marks = ", ".join("?" for _ in header)
+	db.executemany(
+		f"INSERT INTO results (store_run_id, store_row, {columns}) VALUES (?, ?, {marks})",
+		[(run_id, i, *(row.get(c) for c in header)) for i, row in enumerate(rows)])
+	db.commit()
+	return run_id, len(rows)
+
+
+def list_runs(db):
+	runs = db.execute(
+		"SELECT r.run_id, r.tag, r.variant, r.git_revision, r.hostname, COUNT(x.store_row) AS rows "
+		"FROM runs r LEFT JOIN results x ON x.store_run_id = r.run_id "
+		"GROUP BY r.run_id ORDER BY r.run_id").fetchall()
+	print(f"{'Run':<16} {'Tag':<12} {'Build':<8} {'Revision':<16} {'Host':<16} Rows")
+	for r in runs:
+		print(f"{r['run_id']:<16} {r['tag'] or '-':<12} {r['variant'] or '-':<8} "
+		      f"{r['git_revision'] or '-':<16} {r['hostname'] or '-':<16} {r['rows']}")
+
+
+# ---------------------------------------------------------------------------
+# Selecting and loading runs
+# ---------------------------------------------------------------------------
+
+def select_runs(db, selector):
+	ordered = [r["run_id"] for r in db.execute("SELECT run_id FROM runs ORDER BY run_id")]
+	chosen = []
+	for part in selector.split(","):
+		part = part.strip()
+		if part == "latest" or part.startswith("latest~"):
+			back = int(part[7:] or 0) if part != "latest" else 0
+			if back >= len(ordered):
+				sys.exit(f"{part}: the store has {len(ordered)} run(s)")
+			chosen.append(ordered[-1 - back])
+		elif part.startswith("tag:"):
+			tagged = [r["run_id"] for r in db.execute(
+				"SELECT run_id FROM runs WHERE tag = ? ORDER BY run_id", (part[4:],))]
+			if not tagged:
+				sys.exit(f"{part}: no runs with that tag")
+			chosen.extend(tagged)
+		elif part in ordered:
+			chosen.append(part)
+		else:
+			sys.exit(f"{part}: no such run in the store")
+	return list(dict.fromkeys(chosen))
+
+
+def load_rows(db, run_ids):
+	"""Successful result rows of the runs, as dicts."""
+	marks = ", ".join("?" for _ in run_ids)
+	rows = db.execute(
+		f"SELECT * FROM results WHERE store_run_id IN ({marks}) ORDER BY store_run_id, store_row",
+		run_ids).fetchall()
+	out = []
+	for r in rows:
+		row = dict(r)
+		# CSVs from before the Status column only hold finished runs
+		if row.get("Status") in (None, "", "ok"):
+			out.append(row)
+	return out
+
+
+def cell_key(row):
+	return tuple(row.get(c) or "" for c in CELL_COLUMNS)
+
+
+def describe_cell(key):
+	fields = dict(zip(CELL_COLUMNS, key))
+	text = f"{fields['Label']} size={fields['Message_Size']} threads={fields['Threads']}"
+	for column in ("Poll_Mode", "Placement", "KTLS", "Link", "Handler"):
+		if fields[column] and fields[column] not in ("block", "none", "off", "loopback", "echo"):
+			text += f" {column.lower()}={fields[column]}"
+	return text
+
+
+# ---------------------------------------------------------------------------
+# Regression detection
+# ---------------------------------------------------------------------------
+
+def betacf(a, b, x):
+	"""Continued fraction of the incomplete beta function (Lentz)."""
+	tiny = 1e-300
+	qab, qap, qam = a + b, a + 1.0, a - 1.0
+	c, d = 1.0, 1.0 - qab * x / qap
+	d = 1.0 / (d if abs(d) > tiny else tiny)
+	h = d
+	for m in range(1, 300):
+		m2 = 2 * m
+		aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+		d = 1.0 + aa * d
+		d = 1.0 / (d if abs(d) > tiny else tiny)
+		c = 1.0 + aa / c
+		c = c if abs(c) > tiny else tiny
+		h *= d * c
+		aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+		d = 1.0 + aa * d
+		d = 1.0 / (d if abs(d) > tiny else tiny)
+		c = 1.0 + aa / c
+		c = c if abs(c) > tiny else tiny
+		delta = d * c
+		h *= delta
+		if abs(delta - 1.0) < 1e-12:
+			break
+	return h
+
+
+def betai(a, b, x):
+	"""Regularized incomplete beta function I_x(a, b)."""
+	if x <= 0.0:
+		return 0.0
+	if x >= 1.0:
+		return 1.0
+	front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) +
+	                 a * math.log(x) + b * math.log(1.0 - x))
+	if x < (a + 1.0) / (a + b + 2.0):
+		return front * betacf(a, b, x) / a
+	return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def welch_test(base, cand):
+	"""Two-sided p-value of Welch's t-test that the two means differ."""
+	n1, n2 = len(base), len(cand)
+	m1, m2 = sum(base) / n1, sum(cand) / n2
+	v1 = sum((x - m1) ** 2 for x in base) / (n1 - 1)
+	v2 = sum((x - m2) ** 2 for x in cand) / (n2 - 1)
+	se2 = v1 / n1 + v2 / n2
+	if se2 == 0.0:
+		# Both sides constant: a difference is as certain as it gets
+		return 1.0 if m1 == m2 else 0.0
+	t = (m2 - m1) / math.sqrt(se2)
+	df = se2 ** 2 / ((v1 / n1) ** 2 / (n1 - 1) + (v2 / n2) ** 2 / (n2 - 1))
+	return betai(df / 2.0, 0.5, df / (df + t * t))
+
+
+def compare(db, baseline, candidate, metrics, alpha, min_change_pct, show_all):
+	base_ids = select_runs(db, baseline)
+	cand_ids = select_runs(db, candidate)
+	if set(base_ids) & set(cand_ids):
+		sys.exit("baseline and candidate share runs")
+
+	samples = {}
+	for side, ids in ((0, base_ids), (1, cand_ids)):
+		for row in load_rows(db, ids):
+			for metric in metrics:
+				v = metric_value(row, metric)
+				if v is not None:
+					samples.setdefault((cell_key(row), metric), ([], []))[side].append(v)
+
+	tests, untested = [], 0
+	for (key, metric), (base, cand) in samples.items():
+		if len(base) < 2 or len(cand) < 2:
+			untested += bool(base and cand)
+			continue
+		mb, mc = sum(base) / len(base), sum(cand) / len(cand)
+		change = 100.0 * (mc - mb) / abs(mb) if mb else (0.0 if mc == mb else math.inf)
+		tests.append({"key": key, "metric": metric, "n": (len(base), len(cand)),
+		              "base": mb, "cand": mc, "change": change, "p": welch_test(base, cand)})
+
+	print(f"Baseline:  {', '.join(base_ids)}")
+	print(f"Candidate: {', '.join(cand_ids)}")
+	if not tests:
+		print("No cell has 2 or more samples on both sides; run with --repeat=N "
+		      "(REPEATS in the experiment script) or pool runs")
+		return 2
+
+	# Benjamini-Hochberg within each metric: a large matrix would otherwise
+	# turn noise into regressions, while a slowdown across many cells still
+	# shows even with few samples each
+	for metric in metrics:
+		family = sorted((t for t in tests if t["metric"] == metric), key=lambda t: t["p"])
+		m = len(family)
+		cutoff = 0
+		for i, t in enumerate(family):
+			if t["p"] <= alpha * (i + 1) / m:
+				cutoff = i + 1
+		for i, t in enumerate(family):
+			higher_better = METRICS[metric][1]
+			worse = t["change"] < 0 if higher_better else t["change"] > 0
+			if i < cutoff and abs(t["change"]) >= min_change_pct:
+				t["verdict"] = "REGRESSION" if worse else "improvement"
+			else:
+				t["verdict"] = "same"
+
+	regressions = [t for t in tests if t["verdict"] == "REGRESSION"]
+	shown = tests if show_all else [t for t in tests if t["verdict"] != "same"]
+	for t in sorted(shown, key=lambda t: (t["verdict"] != "REGRESSION", t["key"], t["metric"])):
+		print(f"{t['verdict']:<11} {describe_cell(t['key'])} {t['metric']}: "
+		      f"{t['base']:.6g} -> {t['cand']:.6g} ({t['change']:+.1f}%, p={t['p']:.2g}, "
+		      f"n={t['n'][0]}/{t['n'][1]})")
+	print(f"{len(tests)} cell metric(s) tested, {untested} with a single sample skipped, "
+	      f"{len(regressions)} regression(s) at alpha={alpha} and >= {min_change_pct}% change")
+	return 1 if regressions else 0
+
+
+# ---------------------------------------------------------------------------
+# Plot helpers (MT25034_Part_D_Plot_*.py)
+# ---------------------------------------------------------------------------
+
+def plot_arguments(description):
+	parser = argparse.ArgumentParser(description=description)
+	parser.add_argument("--store", default=DEFAULT_STORE, help="results store (default %(default)s)")
+	parser.add_argument("--run", default="latest", help="runs to plot (default %(default)s)")
+	parser.add_argument("--poll-mode", default="block", help="poll mode to plot (default %(default)s)")
+	return parser.parse_args()
+
+
+def load_plot_rows(args):
+	"""Rows of the selected runs and poll mode, and a caption describing them."""
+	db = open_store(args.store)
+	run_ids = select_runs(db, args.run)
+	rows = [r for r in load_rows(db, run_ids) if (r.get("Poll_Mode") or "block") == args.poll_mode]
+	run = db.execute("SELECT * FROM runs WHERE run_id = ?", (run_ids[-1],)).fetchone()
+	caption = (f"Run {', '.join(run_ids)} | Build: {run['variant'] or 'unknown'} | "
+	           f"CPU: {run['cpu_model'] or 'unknown'} | Cores: {run['online_cpus'] or '?'} | "
+	           f"{run['kernel'] or run['hostname'] or ''}")
+	db.close()
+	if not rows:
+		sys.exit(f"no successful {args.poll_mode} rows in run(s) {', '.join(run_ids)}")
+	return rows, caption
+
+
+def series(rows, metric, x_column, fixed):
+	"""{label: ([x...], [median metric...])} over rows matching fixed columns."""
+	points = {}
+	for row in rows:
+		if any(str(row.get(k)) != str(v) for k, v in fixed.items()):
+			continue
+		v = metric_value(row, metric)
+		x = number(row.get(x_column))
+		if v is None or x is None:
+			continue
+		points.setdefault(row["Label"], {}).setdefault(x, []).append(v)
+	return {label: (sorted(by_x), [median(by_x[x]) for x in sorted(by_x)])
+	        for label, by_x in points.items()}
+
+
+def distinct(rows, column):
+	return sorted({int(number(r.get(column))) for r in rows if number(r.get(column)) is not None})
+
+
+STYLE = {
+	"TwoCopy": {"color": "#1f77b4", "marker": "o"},
+	"OneCopy": {"color": "#2ca02c", "marker": "s"},
+	"ZeroCopy": {"color": "#d62728", "marker": "^"},
+}
+EXTRA_COLORS = ["#9467bd", "#8c564b", "#e377c2", "#7f7f7f", "#bcbd22", "#17becf", "#ff7f0e"]
+EXTRA_MARKERS = ["D", "v", "P", "X", "<", ">", "*"]
+
+
+def label_style(label, index):
+	if label in STYLE:
+		return STYLE[label]
+	return {"color": EXTRA_COLORS[index % len(EXTRA_COLORS)],
+	        "marker": EXTRA_MARKERS[index % len(EXTRA_MARKERS)]}
+
+
+# ---------------------------------------------------------------------------
+
+def main():
+	parser = argparse.ArgumentParser(description="Experiment results store")
+	parser.add_argument("--store", default=DEFAULT_STORE, help="results store (default %(default)s)")
+	sub = parser.add_subparsers(dest="command", required=True)
+
+	p = sub.add_parser("add", help="append a run")
+	p.add_argument("--csv", default="Combined_Results.csv")
+	p.add_argument("--json", default="Combined_Results.json")
+	p.add_argument("--tag", default="", help="name to select the run by (tag:NAME)")
+
+	sub.add_parser("list", help="runs in the store")
+
+	p = sub.add_parser("compare", help="significant changes from BASELINE to CANDIDATE")
+	p.add_argument("baseline")
+	p.add_argument("candidate")
+	p.add_argument("--metrics", default=DEFAULT_METRICS,
+	               help=f"comma-separated, from {', '.join(METRICS)} (default %(default)s)")
+	p.add_argument("--alpha", type=float, default=0.05,
+	               help="false discovery rate per metric (default %(default)s)")
+	p.add_argument("--min-change", type=float, default=2.0,
+	               help="smallest change in percent worth flagging (default %(default)s)")
+	p.add_argument("--all", action="store_true", help="also show cells that did not change")
+
+	args = parser.parse_args()
+	if args.command == "add":
+		db = open_store(args.store, create=True)
+		run_id, n = add_run(db, args.csv, args.json, args.tag)
+		print(f"[STORE] Run {run_id}: {n} rows added to {args.store}")
+		return 0
+	db = open_store(args.store)
+	if args.command == "list":
+		list_runs(db)
+		return 0
+	metrics = [m.strip() for m in args.metrics.split(",") if m.strip()]
+	for metric in metrics:
+		if metric not in METRICS:
+			sys.exit(f"unknown metric {metric} ({', '.join(METRICS)})")
+	return compare(db, args.baseline, args.candidate, metrics, args.alpha, args.min_change, args.all)
+
+
+if __name__ == "__main__":
+	sys.exit(main())
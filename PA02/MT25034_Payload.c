@@ -0,0 +1,229 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/errqueue.h>
+
+#include "MT25034_Message.h"
+#include "MT25034_Options.h"
+#include "MT25034_Payload.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+static const char *response_names[] = { "echo", "sendfile", "mmap-zerocopy" };
+
+const char *response_mode_name(int mode) {
+    if (mode < 0 || mode > RESPONSE_MMAP_ZEROCOPY) {
+        return "unknown";
+    }
+    return response_names[mode];
+}
+
+int response_mode_parse(const char *name) {
+    for (int i = 0; i <= RESPONSE_MMAP_ZEROCOPY; i++) {
+        if (strcmp(response_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int open_tmpfile(void) {
+    const char *dir = getenv("TMPDIR");
+    char path[256];
+    snprintf(path, sizeof(path), "%s/MT25034_payload_XXXXXX", dir ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    return fd;
+}
+
+int payload_open(payload_t *p, size_t len) {
+    p->fd = -1;
+    p->map = NULL;
+    p->len = len;
+
+    if (!bench_opts.payload_tmpfile) {
+        p->fd = memfd_create("MT25034_payload", 0);
+    }
+    if (p->fd < 0) {
+        p->fd = open_tmpfile();
+    }
+    if (p->fd < 0) {
+        return -1;
+    }
+    if (ftruncate(p->fd, (off_t)len) < 0) {
+        goto fail;
+    }
+
+    // Same per-field pattern the clients send, laid out contiguously
+    p->map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (p->map == MAP_FAILED) {
+        p->map = NULL;
+        goto fail;
+    }
+    msg_layout_t layout;
+    if (compute_field_sizes(&layout, len) < 0) {
+        goto fail;
+    }
+    size_t off = 0;
+    for (int i = 0; i < layout.count; i++) {
+        memset(p->map + off, 'A' + i % 26, layout.sizes[i]);
+        off += layout.sizes[i];
+    }
+    free_field_sizes(&layout);
+    return 0;
+
+fail:
+    payload_close(p);
+    return -1;
+}
+
+void payload_close(payload_t *p) {
+    if (p->map) {
+        munmap(p->map, p->len);
+        p->map = NULL;
+    }
+    if (p->fd >= 0) {
+        close(p->fd);
+        p->fd = -1;
+    }
+}
+
+void payload_prepare_socket(int sock, zc_counters_t *zc) {
+    memset(zc, 0, sizeof(*zc));
+    if (bench_opts.response != RESPONSE_MMAP_ZEROCOPY) {
+        return;
+    }
+    if (ktls_active(sock)) {
+        static int warned;
+        if (!__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED)) {
+            fprintf(stderr, "mmap-zerocopy: MSG_ZEROCOPY is not supported on kTLS sockets, sending with copies\n");
+        }
+        return;
+    }
+    // Without SO_ZEROCOPY the kernel silently ignores MSG_ZEROCOPY
+    int one = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+        zc->enabled = 1;
+    } else {
+        perror("setsockopt SO_ZEROCOPY (falling back to copying sends)");
+    }
+}
+
+void zerocopy_reap(int sock, zc_counters_t *zc, int wait) {
+    if (!zc->enabled) {
+        return;
+    }
+    int idle_polls = 0;
+    while (zc->completions < zc->sends) {
+        char control[128];
+        struct msghdr msg = {0};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!wait || (errno != EAGAIN && errno != EWOULDBLOCK) || idle_polls >= 10) {
+                return;
+            }
+            // Error-queue readiness is reported as POLLERR
+            struct pollfd pfd = { .fd = sock, .events = 0 };
+            if (poll(&pfd, 1, 100) == 0) {
+                idle_polls++;
+            }
+            continue;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err *serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            uint64_t n = (uint64_t)(serr->ee_data - serr->ee_info) + 1;
+            zc->completions += n;
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                zc->copied += n;
+            }
+        }
+    }
+}
+
+void payload_finish_socket(int sock, zc_counters_t *zc) {
+    if (!zc->enabled) {
+        return;
+    }
+    zerocopy_reap(sock, zc, 1);
+    // On loopback the kernel copies anyway; "copied" shows how often
+    printf("ZEROCOPY sends=%llu completions=%llu copied=%llu\n",
+           (unsigned long long)zc->sends,
+           (unsigned long long)zc->completions,
+           (unsigned long long)zc->copied);
+    fflush(stdout);
+}
+
+static int respond_sendfile(int sock, const payload_t *p) {
+    off_t off = 0;
+    while ((size_t)off < p->len) {
+        ssize_t n = transport_sendfile(sock, p->fd, &off, p->len - (size_t)off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int respond_mmap_zerocopy(int sock, const payload_t *p, zc_counters_t *zc) {
+    int flags = zc->enabled ? MSG_ZEROCOPY : 0;
+    size_t sent = 0;
+    while (sent < p->len) {
+        ssize_t n = transport_send(sock, p->map + sent, p->len - sent, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Too many pinned pages outstanding: wait for completions and retry
+            if (errno == ENOBUFS && zc->enabled) {
+                zerocopy_reap(sock, zc, 1);
+                continue;
+            }
+            return -1;
+        }
+        if (zc->enabled) {
+            zc->sends++;
+        }
+        sent += (size_t)n;
+    }
+    // The mapping never changes, so completions only need reaping, not waiting
+    zerocopy_reap(sock, zc, 0);
+    return 0;
+}
+
+int payload_respond(int sock, const payload_t *p, zc_counters_t *zc) {
+    if (bench_opts.response == RESPONSE_SENDFILE) {
+        return respond_sendfile(sock, p);
+    }
+    return respond_mmap_zerocopy(sock, p, zc);
+}
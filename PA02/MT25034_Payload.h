@@ -0,0 +1,51 @@
+#ifndef MT25034_PAYLOAD_H
+#define MT25034_PAYLOAD_H
+//MT25034
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Server response strategies (--response). "echo" sends the request back
+// from the user buffers as before; the other two serve a fixed payload held
+// in a memfd (or an unlinked temp file with --payload-tmpfile) straight from
+// the page cache.
+enum {
+    RESPONSE_ECHO,
+    RESPONSE_SENDFILE,          // sendfile() from the payload file
+    RESPONSE_MMAP_ZEROCOPY,     // sendmsg(MSG_ZEROCOPY) of the mmapped payload
+};
+
+typedef struct {
+    int fd;
+    char *map;
+    size_t len;
+} payload_t;
+
+// Per-connection MSG_ZEROCOPY bookkeeping for RESPONSE_MMAP_ZEROCOPY.
+typedef struct {
+    int enabled;            // SO_ZEROCOPY accepted by the socket
+    uint64_t sends;
+    uint64_t completions;
+    uint64_t copied;        // completions the kernel served by copying
+} zc_counters_t;
+
+int payload_open(payload_t *p, size_t len);
+void payload_close(payload_t *p);
+
+const char *response_mode_name(int mode);
+int response_mode_parse(const char *name);
+
+// Per-connection setup (SO_ZEROCOPY for the mmap mode).
+void payload_prepare_socket(int sock, zc_counters_t *zc);
+
+// Sends the whole payload with the configured response mode; -1 on error.
+int payload_respond(int sock, const payload_t *p, zc_counters_t *zc);
+
+// Drains zero-copy completions; waits for all outstanding ones when `wait`.
+void zerocopy_reap(int sock, zc_counters_t *zc, int wait);
+
+// Waits for outstanding completions before close and prints a ZEROCOPY line
+// (sends, completions, copied) for connections that used MSG_ZEROCOPY.
+void payload_finish_socket(int sock, zc_counters_t *zc);
+
+#endif
@@ -0,0 +1,511 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "MT25034_Churn.h"
+#include "MT25034_ConnMem.h"
+#include "MT25034_Handler.h"
+#include "MT25034_Hybrid.h"
+#include "MT25034_Interval.h"
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Payload.h"
+#include "MT25034_Server.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Stream.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+typedef struct {
+    const copy_engine_t *engine;
+    int sock;
+    int index;
+    size_t msg_size;
+} client_args_t;
+
+// Response payload for --response=sendfile/mmap-zerocopy, shared by all connections
+static payload_t payload;
+
+// --buffer-pool: request buffers are borrowed per request (the largest block
+// any served engine needs); asymmetric responses come from one read-only
+// message shared by all connections
+static buf_pool_t msg_pool;
+static Message shared_resp;
+
+// Field layout of requests and responses, the same for every connection
+static msg_layout_t layout, resp_layout;
+
+size_t serve_packed_block(size_t msg_size) {
+    // Receive buffer + fields, plus the packed response when asymmetric
+    size_t resp_size = response_size_for(msg_size);
+    return 2 * msg_size + (resp_size != msg_size ? resp_size : 0);
+}
+
+void serve_packed(const copy_engine_t *e, int sock, int index, size_t msg_size) {
+    (void)e;
+    size_t resp_size = response_size_for(msg_size);
+    zc_counters_t zc;
+    payload_prepare_socket(sock, &zc);
+
+    // Asymmetric responses are packed from their own message fields
+    Message msg = {0}, resp = {0};
+    int asymmetric = resp_size != msg_size;
+    int pooled = bench_opts.buffer_pool;
+    int timed = bench_opts.interval_ms > 0;
+    char *block = NULL, *buffer = NULL, *resp_buffer = NULL;
+    if (pooled) {
+        resp = shared_resp;
+    } else {
+        buffer = msgbuf_alloc(msg_size);
+        resp_buffer = asymmetric ? msgbuf_alloc(resp_size) : buffer;
+        if (allocate_message(&msg, &layout) < 0 || !buffer || !resp_buffer ||
+            (asymmetric && allocate_message(&resp, &resp_layout) < 0)) {
+            perror("malloc failed");
+            free_message(&msg);
+            if (asymmetric) {
+                free_message(&resp);
+                msgbuf_free(resp_buffer);
+            }
+            msgbuf_free(buffer);
+            return;
+        }
+        if (asymmetric) {
+            fill_message_fields(&resp, &resp_layout);
+        }
+    }
+
+    while (1) {
+        if (pooled) {
+            // Idle connections hold no message buffer
+            if (conn_wait_request(sock) < 0) {
+                break;
+            }
+            block = buf_pool_get(&msg_pool);
+            if (!block || bind_message(&msg, &layout, block + msg_size) < 0) {
+                perror("malloc failed");
+                break;
+            }
+            buffer = block;
+            resp_buffer = asymmetric ? block + 2 * msg_size : buffer;
+        }
+        if (transport_recv_all(sock, buffer, msg_size) < 0) {
+            break;
+        }
+        // Service time: request fully received to response sent
+        uint64_t served = timed ? now_ns() : 0;
+
+        unpack_message(&msg, &layout, buffer);
+        int modified = run_handler(msg.fields, layout.sizes, layout.count);
+
+        int rc;
+        if (bench_opts.response != RESPONSE_ECHO) {
+            rc = payload_respond(sock, &payload, &zc);
+        } else {
+            if (asymmetric) {
+                pack_message(&resp, &resp_layout, resp_buffer);
+            } else if (modified) {
+                pack_message(&msg, &layout, buffer);
+            }
+            rc = transport_send_all(sock, resp_buffer, resp_size);
+        }
+        if (pooled) {
+            buf_pool_put(&msg_pool, block);
+            block = NULL;
+        }
+        if (rc < 0) {
+            break;
+        }
+        if (timed) {
+            interval_record(index, now_ns() - served, msg_size);
+        }
+    }
+
+    if (pooled) {
+        buf_pool_put(&msg_pool, block);
+    } else {
+        if (asymmetric) {
+            free_message(&resp);
+            msgbuf_free(resp_buffer);
+        }
+        msgbuf_free(buffer);
+    }
+    free_message(&msg);
+
+    payload_finish_socket(sock, &zc);
+}
+
+size_t serve_scatter_block(size_t msg_size) {
+    return msg_size;
+}
+
+void serve_scatter(const copy_engine_t *e, int sock, int index, size_t msg_size) {
+    size_t resp_size = response_size_for(msg_size);
+    zc_counters_t zc;
+    payload_prepare_socket(sock, &zc);
+    hybrid_sender_t sender;
+    if (e->hybrid) {
+        hybrid_init(&sender, sock, 0);
+    }
+
+    // Asymmetric responses are gathered from their own message fields
+    Message msg = {0}, resp = {0};
+    int asymmetric = resp_size != msg_size;
+    int pooled = bench_opts.buffer_pool;
+    int timed = bench_opts.interval_ms > 0;
+    char *block = NULL;
+    struct iovec *iov = malloc(sizeof(struct iovec) * (size_t)layout.count);
+    struct iovec *resp_iov = malloc(sizeof(struct iovec) * (size_t)resp_layout.count);
+    if (pooled) {
+        resp = shared_resp;
+    }
+    if (!iov || !resp_iov ||
+        (!pooled && (allocate_message(&msg, &layout) < 0 ||
+                     (asymmetric && allocate_message(&resp, &resp_layout) < 0)))) {
+        perror("malloc failed");
+        free_message(&msg);
+        if (asymmetric && !pooled) {
+            free_message(&resp);
+        }
+        free(iov);
+        free(resp_iov);
+        return;
+    }
+    if (asymmetric && !pooled) {
+        fill_message_fields(&resp, &resp_layout);
+    }
+
+    struct msghdr msg_hdr = {0};
+    if (!pooled) {
+        setup_iovec(iov, &msg, &layout);
+    }
+    msg_hdr.msg_iov = iov;
+    msg_hdr.msg_iovlen = (size_t)layout.count;
+
+    struct msghdr resp_hdr = msg_hdr;
+    if (asymmetric) {
+        setup_iovec(resp_iov, &resp, &resp_layout);
+        resp_hdr.msg_iov = resp_iov;
+        resp_hdr.msg_iovlen = (size_t)resp_layout.count;
+    }
+
+    while (1) {
+        if (pooled) {
+            // Idle connections hold no message buffer
+            if (conn_wait_request(sock) < 0) {
+                break;
+            }
+            block = buf_pool_get(&msg_pool);
+            if (!block || bind_message(&msg, &layout, block) < 0) {
+                perror("malloc failed");
+                break;
+            }
+            setup_iovec(iov, &msg, &layout);
+        }
+        if (transport_recvmsg_all(sock, &msg_hdr, 0) < 0) {
+            break;
+        }
+        // Service time: request fully received to response sent
+        uint64_t served = timed ? now_ns() : 0;
+        run_handler(msg.fields, layout.sizes, layout.count);
+
+        int rc;
+        if (bench_opts.response != RESPONSE_ECHO) {
+            rc = payload_respond(sock, &payload, &zc);
+        } else if (e->hybrid) {
+            rc = hybrid_send(&sender, sock, &resp_hdr);
+            // Zero-copy pages must be released before the fields are reused
+            hybrid_release(&sender, sock);
+        } else {
+            rc = transport_sendmsg_all(sock, &resp_hdr, 0);
+        }
+        if (pooled) {
+            buf_pool_put(&msg_pool, block);
+            block = NULL;
+        }
+        if (rc < 0) {
+            break;
+        }
+        if (timed) {
+            interval_record(index, now_ns() - served, msg_size);
+        }
+    }
+
+    if (pooled) {
+        buf_pool_put(&msg_pool, block);
+    } else if (asymmetric) {
+        free_message(&resp);
+    }
+    free_message(&msg);
+    free(iov);
+    free(resp_iov);
+
+    if (e->hybrid) {
+        hybrid_print(&sender);
+    }
+    payload_finish_socket(sock, &zc);
+}
+
+// Sets up an accepted connection, serves it until the client closes it
+static void serve_connection(const copy_engine_t *engine, int sock, int index, size_t msg_size) {
+    transport_setup_socket(sock);
+    ktls_setup_socket(sock, ROLE_SERVER);
+    if (bench_opts.streams > 0) {
+        stream_serve(sock, msg_size);
+    } else {
+        engine->serve(engine, sock, index, msg_size);
+    }
+    close(sock);
+}
+
+static void *handle_client(void *arg) {
+    client_args_t *cargs = (client_args_t *)arg;
+    const copy_engine_t *engine = cargs->engine;
+    int sock = cargs->sock;
+    size_t msg_size = cargs->msg_size;
+    int index = cargs->index;
+    transport_pin_thread(index);
+    free(cargs);
+    serve_connection(engine, sock, index, msg_size);
+    return NULL;
+}
+
+// Pause after an accept() error other than an aborted handshake, e.g. when
+// the process is out of descriptors, before the listener is tried again
+#define ACCEPT_BACKOFF_US 10000
+
+// accept() that survives what a connection storm makes routine: signals and
+// handshakes aborted before they were taken are skipped, other errors
+// (EMFILE, ENFILE, ...) are logged and followed by a short pause. Returns
+// the new socket, or -1 when the caller should just try again.
+static int accept_connection(int fd) {
+    int sock = accept(fd, NULL, NULL);
+    if (sock >= 0) {
+        return sock;
+    }
+    if (errno != EINTR && errno != ECONNABORTED) {
+        perror("Accept failed");
+        usleep(ACCEPT_BACKOFF_US);
+    }
+    return -1;
+}
+
+typedef struct {
+    const copy_engine_t *engine;
+    int listen_fd;
+    int index;
+    size_t msg_size;
+} acceptor_args_t;
+
+// --accept=reuseport/prespawn: a thread started up front that accepts on
+// its listener and serves each connection itself, one at a time, so no
+// thread is created per connection
+static void *acceptor_thread(void *arg) {
+    acceptor_args_t *a = (acceptor_args_t *)arg;
+    transport_pin_thread(a->index);
+    while (1) {
+        int sock = accept_connection(a->listen_fd);
+        if (sock >= 0) {
+            serve_connection(a->engine, sock, a->index, a->msg_size);
+        }
+    }
+    return NULL;
+}
+
+static int listen_on(int port, int reuseport) {
+    struct sockaddr_in address = {0};
+    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("Socket failed");
+        return -1;
+    }
+
+    int opt = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("SO_REUSEPORT failed");
+        close(server_fd);
+        return -1;
+    }
+    transport_prepare_socket(server_fd);
+    churn_prepare_listener(server_fd);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        close(server_fd);
+        return -1;
+    }
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        perror("Listen failed");
+        close(server_fd);
+        return -1;
+    }
+    return server_fd;
+}
+
+// Starts --acceptors threads per engine: with reuseport each on its own
+// SO_REUSEPORT listener (the kernel spreads connections between them), with
+// prespawn all on the engine's one listener. Only returns on a setup error
+// or when no thread could be started (-1).
+static int run_acceptors(const copy_engine_t *const *engines, const int *ports,
+                         const struct pollfd *fds, int count, size_t msg_size, const char *label) {
+    int per_port = bench_opts.acceptors > 0 ? bench_opts.acceptors : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int total = per_port * count;
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)total);
+    acceptor_args_t *args = calloc((size_t)total, sizeof(acceptor_args_t));
+    if (!tids || !args) {
+        perror("malloc failed");
+        free(tids);
+        free(args);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < per_port; k++) {
+            acceptor_args_t *a = &args[i * per_port + k];
+            a->engine = engines[i];
+            a->index = i * per_port + k;
+            a->msg_size = msg_size;
+            a->listen_fd = fds[i].fd;
+            if (k > 0 && bench_opts.accept_mode == ACCEPT_REUSEPORT) {
+                a->listen_fd = listen_on(ports[i], 1);
+                if (a->listen_fd < 0) {
+                    for (int j = 0; j < i * per_port + k; j++) {
+                        if (args[j].listen_fd != fds[j / per_port].fd) {
+                            close(args[j].listen_fd);
+                        }
+                    }
+                    free(tids);
+                    free(args);
+                    return -1;
+                }
+            }
+        }
+    }
+    printf("Server accept=%s acceptors=%d per port\n", accept_mode_name(bench_opts.accept_mode), per_port);
+    fflush(stdout);
+    transport_signal_ready();
+    interval_start("server", label);
+
+    int started = 0;
+    for (int i = 0; i < total; i++) {
+        if (pthread_create(&tids[started], NULL, acceptor_thread, &args[i]) != 0) {
+            perror("pthread_create failed");
+            continue;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+    free(args);
+    return -1;
+}
+
+int run_engine_server(const copy_engine_t *const *engines, const int *ports, int count,
+                      size_t msg_size) {
+    if (count < 1 || count > ENGINE_MAX) {
+        fprintf(stderr, "run_engine_server: 1 to %d engines\n", ENGINE_MAX);
+        return -1;
+    }
+    if (bench_opts.response != RESPONSE_ECHO && payload_open(&payload, response_size_for(msg_size)) < 0) {
+        perror("payload setup failed");
+        return -1;
+    }
+
+    size_t resp_size = response_size_for(msg_size);
+    if (compute_field_sizes(&layout, msg_size) < 0 || compute_field_sizes(&resp_layout, resp_size) < 0) {
+        perror("malloc failed");
+        return -1;
+    }
+    if (bench_opts.buffer_pool) {
+        size_t block = 0;
+        for (int i = 0; i < count; i++) {
+            size_t b = engines[i]->pool_block(msg_size);
+            block = b > block ? b : block;
+        }
+        buf_pool_init(&msg_pool, block);
+        if (resp_size != msg_size) {
+            if (allocate_message(&shared_resp, &resp_layout) < 0) {
+                perror("malloc failed");
+                return -1;
+            }
+            fill_message_fields(&shared_resp, &resp_layout);
+        }
+    }
+
+    // One listening socket per engine; the interval label names them all
+    struct pollfd fds[ENGINE_MAX];
+    static char label[ENGINE_MAX * 16];
+    label[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        fds[i].fd = listen_on(ports[i], bench_opts.accept_mode == ACCEPT_REUSEPORT);
+        fds[i].events = POLLIN;
+        if (fds[i].fd < 0) {
+            return -1;
+        }
+        if (count > 1) {
+            printf("Server listening on port %d (%s)\n", ports[i], engines[i]->name);
+        } else {
+            printf("Server listening on port %d\n", ports[i]);
+        }
+        snprintf(label + strlen(label), sizeof(label) - strlen(label), "%s%s",
+                 i ? "+" : "", engines[i]->label);
+    }
+    if (bench_opts.accept_mode != ACCEPT_THREAD) {
+        return run_acceptors(engines, ports, fds, count, msg_size, label);
+    }
+    fflush(stdout);
+    transport_signal_ready();
+    interval_start("server", label);
+
+    int next_index = 0;
+    while (1) {
+        if (count > 1 && poll(fds, (nfds_t)count, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll failed");
+            return -1;
+        }
+        for (int i = 0; i < count; i++) {
+            if (count > 1 && !(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            int new_socket = accept_connection(fds[i].fd);
+            if (new_socket < 0) {
+                continue;
+            }
+
+            client_args_t *cargs = malloc(sizeof(client_args_t));
+            if (!cargs) {
+                perror("malloc failed");
+                close(new_socket);
+                continue;
+            }
+            cargs->engine = engines[i];
+            cargs->sock = new_socket;
+            cargs->index = next_index++;
+            cargs->msg_size = msg_size;
+            if (conn_thread_spawn(handle_client, cargs) < 0) {
+                perror("pthread_create failed");
+                close(new_socket);
+                free(cargs);
+            }
+        }
+    }
+    return 0;
+}
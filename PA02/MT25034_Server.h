@@ -0,0 +1,24 @@
+#ifndef MT25034_SERVER_H
+#define MT25034_SERVER_H
+//MT25034
+
+#include <stddef.h>
+
+#include "MT25034_Engine.h"
+
+// Server side of the copy engines: one accept loop for any set of engines,
+// each listening on its own port, with a connection thread per client (or
+// the fixed handler threads of --accept=reuseport/prespawn).
+// Engine i of `engines` listens on ports[i]; the request layout, response
+// payload and --buffer-pool are set up once and shared by all of them.
+// Only returns on a setup error (-1).
+int run_engine_server(const copy_engine_t *const *engines, const int *ports, int count,
+                      size_t msg_size);
+
+// Serve functions and --buffer-pool block sizes of the built-in engines
+void serve_packed(const copy_engine_t *e, int sock, int index, size_t msg_size);
+size_t serve_packed_block(size_t msg_size);
+void serve_scatter(const copy_engine_t *e, int sock, int index, size_t msg_size);
+size_t serve_scatter_block(size_t msg_size);
+
+#endif
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "MT25034_SockProfile.h"
+//MT25034
+
+static const socket_profile_t named_profiles[] = {
+    { "default",    -1, -1, -1, -1,      -1,      -1 },
+    { "latency",     1,  1,  0, -1,      -1,      16384 },
+    { "throughput",  0, -1,  0, 4194304, 4194304, -1 },
+    { "balanced",    1, -1,  0, 1048576, 1048576, 131072 },
+};
+
+int socket_profile_named(const char *name, socket_profile_t *out) {
+    for (size_t i = 0; i < sizeof(named_profiles) / sizeof(named_profiles[0]); i++) {
+        if (strcmp(named_profiles[i].name, name) == 0) {
+            *out = named_profiles[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void socket_profile_override(socket_profile_t *dst, const socket_profile_t *src) {
+    if (src->nodelay >= 0) dst->nodelay = src->nodelay;
+    if (src->quickack >= 0) dst->quickack = src->quickack;
+    if (src->cork >= 0) dst->cork = src->cork;
+    if (src->sndbuf >= 0) dst->sndbuf = src->sndbuf;
+    if (src->rcvbuf >= 0) dst->rcvbuf = src->rcvbuf;
+    if (src->notsent_lowat >= 0) dst->notsent_lowat = src->notsent_lowat;
+}
+
+static void set_int_opt(int sock, int level, int opt, int value, const char *what) {
+    if (setsockopt(sock, level, opt, &value, sizeof(value)) < 0) {
+        perror(what);
+    }
+}
+
+void socket_profile_apply_pre_connect(int sock, const socket_profile_t *p) {
+    if (p->sndbuf >= 0) {
+        set_int_opt(sock, SOL_SOCKET, SO_SNDBUF, p->sndbuf, "setsockopt SO_SNDBUF");
+    }
+    if (p->rcvbuf >= 0) {
+        set_int_opt(sock, SOL_SOCKET, SO_RCVBUF, p->rcvbuf, "setsockopt SO_RCVBUF");
+    }
+}
+
+void socket_profile_apply(int sock, const socket_profile_t *p) {
+    if (p->nodelay >= 0) {
+        set_int_opt(sock, IPPROTO_TCP, TCP_NODELAY, p->nodelay, "setsockopt TCP_NODELAY");
+    }
+    if (p->quickack >= 0) {
+        set_int_opt(sock, IPPROTO_TCP, TCP_QUICKACK, p->quickack, "setsockopt TCP_QUICKACK");
+    }
+    if (p->notsent_lowat >= 0) {
+        set_int_opt(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, p->notsent_lowat,
+                    "setsockopt TCP_NOTSENT_LOWAT");
+    }
+}
+
+void socket_profile_describe(const socket_profile_t *p, char *buf, size_t len) {
+    snprintf(buf, len, "%s:nodelay=%d;quickack=%d;cork=%d;sndbuf=%d;rcvbuf=%d;notsent_lowat=%d",
+             p->name ? p->name : "custom",
+             p->nodelay, p->quickack, p->cork, p->sndbuf, p->rcvbuf, p->notsent_lowat);
+}
@@ -0,0 +1,34 @@
+#ifndef MT25034_SOCKPROFILE_H
+#define MT25034_SOCKPROFILE_H
+//MT25034
+
+#include <stddef.h>
+
+// A set of TCP/socket options applied to every connection. Any field left
+// at -1 keeps the kernel default, so "default" reproduces the old behaviour.
+typedef struct {
+    const char *name;
+    int nodelay;        // TCP_NODELAY
+    int quickack;       // TCP_QUICKACK, re-armed after every receive
+    int cork;           // TCP_CORK held for the duration of each send call
+    int sndbuf;         // SO_SNDBUF in bytes
+    int rcvbuf;         // SO_RCVBUF in bytes
+    int notsent_lowat;  // TCP_NOTSENT_LOWAT in bytes
+} socket_profile_t;
+
+// Fills *out with a named profile ("default", "latency", "throughput",
+// "balanced"); returns -1 for an unknown name.
+int socket_profile_named(const char *name, socket_profile_t *out);
+
+// Copies every field of *src that is not -1 over *dst.
+void socket_profile_override(socket_profile_t *dst, const socket_profile_t *src);
+
+// Buffer sizes must be set before listen()/connect() so the window scale
+// is negotiated with them; accepted sockets inherit them from the listener.
+void socket_profile_apply_pre_connect(int sock, const socket_profile_t *p);
+void socket_profile_apply(int sock, const socket_profile_t *p);
+
+// "name:nodelay=1;sndbuf=65536;..." (CSV-safe, no commas).
+void socket_profile_describe(const socket_profile_t *p, char *buf, size_t len);
+
+#endif
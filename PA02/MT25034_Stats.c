@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int latency_bucket(uint64_t ns) {
+    if (ns < (1ULL << LAT_SUB_BITS)) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - LAT_SUB_BITS;
+    int sub = (int)((ns >> shift) & ((1ULL << LAT_SUB_BITS) - 1));
+    return ((shift + 1) << LAT_SUB_BITS) + sub;
+}
+
+// Upper edge of a bucket, so reported percentiles never understate latency.
+static uint64_t bucket_upper(int idx) {
+    if (idx < (1 << LAT_SUB_BITS)) {
+        return (uint64_t)idx;
+    }
+    int shift = (idx >> LAT_SUB_BITS) - 1;
+    uint64_t sub = (uint64_t)(idx & ((1 << LAT_SUB_BITS) - 1));
+    return (((1ULL << LAT_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+void latency_reset(latency_stats_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+void latency_record(latency_stats_t *s, uint64_t ns) {
+    s->count++;
+    s->total_ns += ns;
+    if (ns > s->max_ns) {
+        s->max_ns = ns;
+    }
+    s->buckets[latency_bucket(ns)]++;
+}
+
+void latency_merge(latency_stats_t *dst, const latency_stats_t *src) {
+    dst->count += src->count;
+    dst->bytes += src->bytes;
+    dst->total_ns += src->total_ns;
+    if (src->max_ns > dst->max_ns) {
+        dst->max_ns = src->max_ns;
+    }
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+}
+
+double latency_percentile_us(const latency_stats_t *s, double pct) {
+    if (s->count == 0) {
+        return 0.0;
+    }
+    uint64_t rank = (uint64_t)((pct / 100.0) * (double)s->count);
+    if (rank >= s->count) {
+        rank = s->count - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += s->buckets[i];
+        if (seen > rank) {
+            uint64_t upper = bucket_upper(i);
+            return (double)(upper < s->max_ns ? upper : s->max_ns) / 1000.0;
+        }
+    }
+    return (double)s->max_ns / 1000.0;
+}
+
+double process_cpu_seconds(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) < 0) {
+        return 0.0;
+    }
+    return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+double thread_cpu_seconds(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+        return 0.0;
+    }
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+long process_rss_kb(void) {
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) {
+        return -1;
+    }
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "VmRSS: %ld kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+void print_client_summary(const char *label, const char *profile,
+                          const latency_stats_t *s, double wall_s, double cpu_s) {
+    double avg_us = s->count ? (double)s->total_ns / (double)s->count / 1000.0 : 0.0;
+    double gbps = wall_s > 0 ? (double)s->bytes * 8.0 / (wall_s * 1e9) : 0.0;
+    double cpu_pct = wall_s > 0 ? 100.0 * cpu_s / wall_s : 0.0;
+
+    printf("SUMMARY label=%s messages=%llu bytes=%llu wall_s=%.3f throughput_gbps=%.6f "
+           "avg_us=%.3f p50_us=%.3f p99_us=%.3f p999_us=%.3f max_us=%.3f cpu_pct=%.1f "
+           "profile=%s hugepages=%s placement=%s ktls=%s build=%s\n",
+           label,
+           (unsigned long long)s->count,
+           (unsigned long long)s->bytes,
+           wall_s, gbps, avg_us,
+           latency_percentile_us(s, 50.0),
+           latency_percentile_us(s, 99.0),
+           latency_percentile_us(s, 99.9),
+           (double)s->max_ns / 1000.0,
+           cpu_pct, profile, hugepage_mode_name(msgbuf_effective_mode()),
+           placement_name(placement_effective()), ktls_name(ktls_effective()),
+           MT25034_BUILD_VARIANT);
+    fflush(stdout);
+}
@@ -0,0 +1,50 @@
+#ifndef MT25034_STATS_H
+#define MT25034_STATS_H
+//MT25034
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Makefile build variant (release, native, lto, pgo, ...) the binary was
+// compiled as; "custom" when built outside the Makefile's variants
+#ifndef MT25034_BUILD_VARIANT
+#define MT25034_BUILD_VARIANT "custom"
+#endif
+
+// Log-linear latency histogram: 16 sub-buckets per power of two, so any
+// percentile is within ~6% of the true value without storing samples.
+#define LAT_SUB_BITS 4
+#define LAT_BUCKETS (64 << LAT_SUB_BITS)
+
+typedef struct {
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[LAT_BUCKETS];
+} latency_stats_t;
+
+uint64_t now_ns(void);
+
+// Histogram bucket of a latency in nanoseconds.
+int latency_bucket(uint64_t ns);
+
+void latency_reset(latency_stats_t *s);
+void latency_record(latency_stats_t *s, uint64_t ns);
+void latency_merge(latency_stats_t *dst, const latency_stats_t *src);
+double latency_percentile_us(const latency_stats_t *s, double pct);
+
+// Process CPU time (user + sys) in seconds.
+double process_cpu_seconds(void);
+
+// CPU time of the calling thread in seconds.
+double thread_cpu_seconds(void);
+
+// Resident set size of this process in KiB (VmRSS), -1 if unavailable.
+long process_rss_kb(void);
+
+// One machine-readable line on stdout, parsed by the experiment script.
+void print_client_summary(const char *label, const char *profile,
+                          const latency_stats_t *s, double wall_s, double cpu_s);
+
+#endif
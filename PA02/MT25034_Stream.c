@@ -0,0 +1,545 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "MT25034_Client.h"
+#include "MT25034_ConnMem.h"
+#include "MT25034_Handler.h"
+#include "MT25034_Interval.h"
+#include "MT25034_Message.h"
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Stream.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+static const char *order_names[] = { "any", "fifo" };
+
+const char *stream_order_name(int order) {
+    if (order < 0 || order > STREAM_ORDER_FIFO) {
+        return "unknown";
+    }
+    return order_names[order];
+}
+
+int stream_order_parse(const char *name) {
+    for (int i = 0; i <= STREAM_ORDER_FIFO; i++) {
+        if (strcmp(order_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *host;
+    int port;
+    size_t msg_size;
+    int duration;
+    int index;
+    mux_strategy_init_fn init;
+    mux_strategy_free_fn fini;
+
+    latency_stats_t stats;
+    latency_stats_t fast;       // requests without --slow-ns work
+    latency_stats_t slow;
+    latency_stats_t *per_stream;
+} stream_thread_t;
+
+// Header plus the strategy's request payload, in one sendmsg
+static int send_request(int sock, mux_strategy_t *s, struct iovec *iov, stream_header_t *h) {
+    if (s->prepare) {
+        s->prepare(s);
+    }
+    iov[0].iov_base = h;
+    iov[0].iov_len = sizeof(*h);
+    memcpy(iov + 1, s->send_iov, sizeof(struct iovec) * (size_t)s->send_iovcnt);
+    struct msghdr mh = {0};
+    mh.msg_iov = iov;
+    mh.msg_iovlen = (size_t)s->send_iovcnt + 1;
+    return transport_sendmsg_all(sock, &mh, ktls_send_flags(s->send_flags));
+}
+
+static void *stream_client_thread(void *arg) {
+    stream_thread_t *t = (stream_thread_t *)arg;
+    int streams = bench_opts.streams;
+    size_t resp_size = response_size_for(t->msg_size);
+    transport_pin_thread(t->index);
+
+    int sock = engine_connect(t->host, t->port);
+    if (sock < 0) {
+        return NULL;
+    }
+    mux_strategy_t s = {0};
+    if (t->init(&s, t->msg_size) < 0) {
+        perror("malloc failed");
+        close(sock);
+        return NULL;
+    }
+    // One header per stream: the one in flight is never rewritten
+    stream_header_t *hdr = calloc((size_t)streams, sizeof(stream_header_t));
+    struct iovec *send_iov = malloc(sizeof(struct iovec) * ((size_t)s.send_iovcnt + 1));
+    struct iovec *recv_iov = malloc(sizeof(struct iovec) * ((size_t)s.recv_iovcnt + 1));
+    if (!hdr || !send_iov || !recv_iov) {
+        perror("malloc failed");
+        goto out;
+    }
+
+    // The slow share is drawn per request from a per-thread generator
+    unsigned int rng = 0x9e3779b9u * (unsigned int)(t->index + 1);
+    uint32_t slow_threshold = (uint32_t)(bench_opts.slow_pct / 100.0 * 4294967295.0);
+    uint64_t seq = 0;
+    int outstanding = 0;
+    uint64_t end = now_ns() + (uint64_t)t->duration * 1000000000ULL;
+
+    for (int i = 0; i < streams; i++) {
+        rng = rng * 1103515245u + 12345u;
+        hdr[i] = (stream_header_t){ (uint32_t)i, (uint32_t)t->msg_size, seq++, now_ns(),
+                                    rng < slow_threshold ? (uint32_t)bench_opts.slow_ns : 0, 0 };
+        if (send_request(sock, &s, send_iov, &hdr[i]) < 0) {
+            goto out;
+        }
+        outstanding++;
+    }
+
+    // Responses arrive in whatever order the server finished them; each
+    // one frees its stream for the next request
+    while (outstanding > 0) {
+        stream_header_t h;
+        recv_iov[0].iov_base = &h;
+        recv_iov[0].iov_len = sizeof(h);
+        memcpy(recv_iov + 1, s.recv_iov, sizeof(struct iovec) * (size_t)s.recv_iovcnt);
+        struct msghdr mh = {0};
+        mh.msg_iov = recv_iov;
+        mh.msg_iovlen = (size_t)s.recv_iovcnt + 1;
+        if (transport_recvmsg_all(sock, &mh, 0) < 0) {
+            break;
+        }
+        if (h.stream >= (uint32_t)streams || h.len != resp_size) {
+            fprintf(stderr, "stream: bad response header (stream %u, %u bytes)\n", h.stream, h.len);
+            break;
+        }
+        outstanding--;
+
+        uint64_t now = now_ns();
+        uint64_t ns = now - h.sent_ns;
+        latency_record(&t->stats, ns);
+        latency_record(h.work_ns ? &t->slow : &t->fast, ns);
+        latency_record(&t->per_stream[h.stream], ns);
+        t->stats.bytes += t->msg_size;
+        interval_record(t->index, ns, t->msg_size);
+
+        if (now < end) {
+            stream_header_t *next = &hdr[h.stream];
+            rng = rng * 1103515245u + 12345u;
+            *next = (stream_header_t){ h.stream, (uint32_t)t->msg_size, seq++, now_ns(),
+                                       rng < slow_threshold ? (uint32_t)bench_opts.slow_ns : 0, 0 };
+            if (send_request(sock, &s, send_iov, next) < 0) {
+                break;
+            }
+            outstanding++;
+        }
+    }
+
+out:
+    close(sock);
+    free(hdr);
+    free(send_iov);
+    free(recv_iov);
+    t->fini(&s);
+    return NULL;
+}
+
+int run_stream_clients(const char *label, const char *host, int port,
+                       int threads, size_t msg_size, int duration,
+                       mux_strategy_init_fn init, mux_strategy_free_fn fini) {
+    int streams = bench_opts.streams;
+    if (threads < 1) {
+        threads = 1;
+    }
+    pthread_t *tids = malloc(sizeof(pthread_t) * (size_t)threads);
+    stream_thread_t *args = calloc((size_t)threads, sizeof(stream_thread_t));
+    if (!tids || !args) {
+        perror("malloc failed");
+        free(tids);
+        free(args);
+        return -1;
+    }
+    for (int i = 0; i < threads; i++) {
+        args[i].per_stream = malloc(sizeof(latency_stats_t) * (size_t)streams);
+        if (!args[i].per_stream) {
+            perror("malloc failed");
+            for (int j = 0; j < i; j++) {
+                free(args[j].per_stream);
+            }
+            free(tids);
+            free(args);
+            return -1;
+        }
+    }
+
+    interval_start("client", label);
+    uint64_t wall_start = now_ns();
+    double cpu_start = process_cpu_seconds();
+
+    for (int i = 0; i < threads; i++) {
+        args[i].host = host;
+        args[i].port = port;
+        args[i].msg_size = msg_size;
+        args[i].duration = duration;
+        args[i].index = i;
+        args[i].init = init;
+        args[i].fini = fini;
+        latency_reset(&args[i].stats);
+        latency_reset(&args[i].fast);
+        latency_reset(&args[i].slow);
+        for (int s = 0; s < streams; s++) {
+            latency_reset(&args[i].per_stream[s]);
+        }
+        pthread_create(&tids[i], NULL, stream_client_thread, &args[i]);
+    }
+
+    latency_stats_t total, fast, slow;
+    latency_reset(&total);
+    latency_reset(&fast);
+    latency_reset(&slow);
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        latency_merge(&total, &args[i].stats);
+        latency_merge(&fast, &args[i].fast);
+        latency_merge(&slow, &args[i].slow);
+    }
+    interval_stop();
+    double wall_s = (double)(now_ns() - wall_start) / 1e9;
+
+    char profile[160];
+    socket_profile_describe(&bench_opts.profile, profile, sizeof(profile));
+    print_client_summary(label, profile, &total, wall_s, process_cpu_seconds() - cpu_start);
+
+    // Spread of the per-stream medians and tails: with head-of-line
+    // blocking the fast requests inherit the slow ones' latency
+    double p50_min = 0, p50_max = 0, p99_min = 0, p99_max = 0;
+    int counted = 0;
+    for (int i = 0; i < threads; i++) {
+        for (int s = 0; s < streams; s++) {
+            const latency_stats_t *st = &args[i].per_stream[s];
+            if (st->count == 0) {
+                continue;
+            }
+            double p50 = latency_percentile_us(st, 50.0), p99 = latency_percentile_us(st, 99.0);
+            if (counted++ == 0 || p50 < p50_min) p50_min = p50;
+            if (counted == 1 || p50 > p50_max) p50_max = p50;
+            if (counted == 1 || p99 < p99_min) p99_min = p99;
+            if (counted == 1 || p99 > p99_max) p99_max = p99;
+        }
+    }
+    // The stream server unpacks and repacks every request whatever the
+    // engine, so only the client side of the label differs between engines
+    printf("STREAMS streams=%d connections=%d order=%s server_path=packed slow_pct=%.2f slow_ns=%ld "
+           "conn_gbps=%.6f conn_msgs_per_s=%.1f fast_p50_us=%.3f fast_p99_us=%.3f "
+           "slow_messages=%llu slow_p99_us=%.3f stream_p50_min_us=%.3f stream_p50_max_us=%.3f "
+           "stream_p99_min_us=%.3f stream_p99_max_us=%.3f\n",
+           streams, threads, stream_order_name(bench_opts.stream_order), bench_opts.slow_pct,
+           bench_opts.slow_ns,
+           wall_s > 0 ? (double)total.bytes * 8.0 / (wall_s * 1e9) / threads : 0.0,
+           wall_s > 0 ? (double)total.count / wall_s / threads : 0.0,
+           latency_percentile_us(&fast, 50.0), latency_percentile_us(&fast, 99.0),
+           (unsigned long long)slow.count, latency_percentile_us(&slow, 99.0),
+           p50_min, p50_max, p99_min, p99_max);
+    for (int i = 0; i < threads; i++) {
+        for (int s = 0; s < streams; s++) {
+            const latency_stats_t *st = &args[i].per_stream[s];
+            printf("STREAM conn=%d stream=%d messages=%llu p50_us=%.3f p99_us=%.3f max_us=%.3f\n",
+                   i, s, (unsigned long long)st->count, latency_percentile_us(st, 50.0),
+                   latency_percentile_us(st, 99.0), (double)st->max_ns / 1000.0);
+        }
+    }
+    fflush(stdout);
+
+    for (int i = 0; i < threads; i++) {
+        free(args[i].per_stream);
+    }
+    free(tids);
+    free(args);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------
+
+struct stream_req;
+
+typedef struct {
+    int sock;
+    // Accounting and the fifo queue; never held across socket I/O, so the
+    // reader keeps draining requests while a response write blocks
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    int inflight;               // read but not yet answered
+    uint64_t arrived;           // requests read so far
+    uint64_t next_out;          // fifo: arrival number of the next response
+    struct stream_req *held;    // fifo: done out of turn, by arrival number
+    int draining;               // fifo: a worker is writing the held responses
+    pthread_mutex_t write_lock; // any: one response write at a time
+    int broken;                 // a write failed: later responses are dropped
+} stream_conn_t;
+
+typedef struct stream_req {
+    struct stream_req *next;    // first: buf_pool_t links idle blocks through it
+    stream_conn_t *conn;
+    stream_header_t h;
+    uint64_t order;             // arrival number on the connection
+    uint64_t received;          // request fully read, for the service time
+    const char *body;           // response payload once handled
+    char data[];                // the packed request, msg_size bytes
+} stream_req_t;
+
+// Worker pool and request queue shared by every stream connection
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    stream_req_t *head, *tail;
+    int started;
+    size_t msg_size;
+    size_t resp_size;
+    msg_layout_t layout;
+    char *resp;                 // packed response when sizes differ, read-only
+    buf_pool_t pool;
+} server = { .lock = PTHREAD_MUTEX_INITIALIZER, .ready = PTHREAD_COND_INITIALIZER };
+
+typedef struct {
+    int index;
+    Message msg;
+} stream_worker_t;
+
+static void write_response(stream_conn_t *c, stream_req_t *req) {
+    if (c->broken) {
+        return;
+    }
+    stream_header_t h = req->h;
+    h.len = (uint32_t)server.resp_size;
+    struct iovec iov[2] = {
+        { &h, sizeof(h) },
+        { (void *)req->body, server.resp_size },
+    };
+    struct msghdr mh = {0};
+    mh.msg_iov = iov;
+    mh.msg_iovlen = 2;
+    if (transport_sendmsg_all(c->sock, &mh, 0) < 0) {
+        c->broken = 1;
+    }
+}
+
+// Called with c->lock held
+static void finish_request(stream_conn_t *c, stream_req_t *req) {
+    buf_pool_put(&server.pool, req);
+    if (--c->inflight == 0) {
+        pthread_cond_signal(&c->idle);
+    }
+}
+
+static void respond(stream_req_t *req) {
+    stream_conn_t *c = req->conn;
+    if (bench_opts.stream_order == STREAM_ORDER_ANY) {
+        pthread_mutex_lock(&c->write_lock);
+        write_response(c, req);
+        pthread_mutex_unlock(&c->write_lock);
+        pthread_mutex_lock(&c->lock);
+        finish_request(c, req);
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+
+    // fifo: queue the response by arrival; whichever worker finds nobody
+    // draining writes every response that is next in turn, unlocking around
+    // each write, and hands over once the next one is not done yet
+    pthread_mutex_lock(&c->lock);
+    stream_req_t **p = &c->held;
+    while (*p && (*p)->order < req->order) {
+        p = &(*p)->next;
+    }
+    req->next = *p;
+    *p = req;
+    if (c->draining) {
+        pthread_mutex_unlock(&c->lock);
+        return;
+    }
+    c->draining = 1;
+    while (c->held && c->held->order == c->next_out) {
+        stream_req_t *r = c->held;
+        c->held = r->next;
+        c->next_out++;
+        pthread_mutex_unlock(&c->lock);
+        write_response(c, r);
+        pthread_mutex_lock(&c->lock);
+        finish_request(c, r);
+    }
+    c->draining = 0;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void *stream_worker(void *arg) {
+    stream_worker_t *w = (stream_worker_t *)arg;
+    transport_pin_thread(w->index);
+    int timed = bench_opts.interval_ms > 0;
+    for (;;) {
+        pthread_mutex_lock(&server.lock);
+        while (!server.head) {
+            pthread_cond_wait(&server.ready, &server.lock);
+        }
+        stream_req_t *req = server.head;
+        server.head = req->next;
+        if (!server.head) {
+            server.tail = NULL;
+        }
+        pthread_mutex_unlock(&server.lock);
+
+        unpack_message(&w->msg, &server.layout, req->data);
+        int modified = run_handler(w->msg.fields, server.layout.sizes, server.layout.count);
+        if (req->h.work_ns) {
+            handler_spin(req->h.work_ns);
+        }
+        if (server.resp) {
+            req->body = server.resp;
+        } else {
+            if (modified) {
+                pack_message(&w->msg, &server.layout, req->data);
+            }
+            req->body = req->data;
+        }
+        uint64_t received = req->received;
+        respond(req);
+        if (timed) {
+            interval_record(w->index, now_ns() - received, server.msg_size);
+        }
+    }
+    return NULL;
+}
+
+// First stream connection: request pool, shared response and the workers
+static void stream_start(size_t msg_size) {
+    pthread_mutex_lock(&server.lock);
+    if (server.started) {
+        pthread_mutex_unlock(&server.lock);
+        return;
+    }
+    server.started = 1;
+    server.msg_size = msg_size;
+    server.resp_size = response_size_for(msg_size);
+    buf_pool_init(&server.pool, sizeof(stream_req_t) + msg_size);
+    if (compute_field_sizes(&server.layout, msg_size) < 0) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    if (server.resp_size != msg_size) {
+        msg_layout_t resp_layout;
+        Message resp = {0};
+        server.resp = msgbuf_alloc(server.resp_size);
+        if (!server.resp || compute_field_sizes(&resp_layout, server.resp_size) < 0 ||
+            allocate_message(&resp, &resp_layout) < 0) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        fill_message_fields(&resp, &resp_layout);
+        pack_message(&resp, &resp_layout, server.resp);
+        free_message(&resp);
+        free_field_sizes(&resp_layout);
+    }
+
+    int workers = bench_opts.stream_workers;
+    if (workers <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = ncpu > 0 ? (int)ncpu : 1;
+    }
+    stream_worker_t *w = calloc((size_t)workers, sizeof(stream_worker_t));
+    if (!w) {
+        perror("malloc failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < workers; i++) {
+        pthread_t tid;
+        w[i].index = i;
+        if (allocate_message(&w[i].msg, &server.layout) < 0) {
+            perror("malloc failed");
+            exit(EXIT_FAILURE);
+        }
+        if (pthread_create(&tid, NULL, stream_worker, &w[i]) != 0) {
+            perror("pthread_create failed");
+            exit(EXIT_FAILURE);
+        }
+        pthread_detach(tid);
+    }
+    pthread_mutex_unlock(&server.lock);
+}
+
+void stream_serve(int sock, size_t msg_size) {
+    stream_start(msg_size);
+
+    stream_conn_t c = { .sock = sock };
+    pthread_mutex_init(&c.lock, NULL);
+    pthread_mutex_init(&c.write_lock, NULL);
+    pthread_cond_init(&c.idle, NULL);
+
+    // This thread only reads; the workers answer
+    for (;;) {
+        stream_header_t h;
+        if (transport_recv_all(sock, &h, sizeof(h)) < 0) {
+            break;
+        }
+        if (h.len != msg_size) {
+            fprintf(stderr, "stream: request of %u bytes, expected %zu\n", h.len, msg_size);
+            break;
+        }
+        stream_req_t *req = buf_pool_get(&server.pool);
+        if (!req) {
+            perror("malloc failed");
+            break;
+        }
+        if (transport_recv_all(sock, req->data, msg_size) < 0) {
+            buf_pool_put(&server.pool, req);
+            break;
+        }
+        req->next = NULL;
+        req->conn = &c;
+        req->h = h;
+        req->received = now_ns();
+
+        pthread_mutex_lock(&c.lock);
+        req->order = c.arrived++;
+        c.inflight++;
+        pthread_mutex_unlock(&c.lock);
+
+        pthread_mutex_lock(&server.lock);
+        if (server.tail) {
+            server.tail->next = req;
+        } else {
+            server.head = req;
+        }
+        server.tail = req;
+        pthread_cond_signal(&server.ready);
+        pthread_mutex_unlock(&server.lock);
+    }
+
+    // Requests still with the workers point at this connection
+    pthread_mutex_lock(&c.lock);
+    while (c.inflight > 0) {
+        pthread_cond_wait(&c.idle, &c.lock);
+    }
+    pthread_mutex_unlock(&c.lock);
+    pthread_mutex_destroy(&c.lock);
+    pthread_mutex_destroy(&c.write_lock);
+    pthread_cond_destroy(&c.idle);
+}
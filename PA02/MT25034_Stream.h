@@ -0,0 +1,50 @@
+#ifndef MT25034_STREAM_H
+#define MT25034_STREAM_H
+//MT25034
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "MT25034_Multiplex.h"
+
+// Stream-tagged protocol (--streams=N on both sides): every request and
+// response starts with a header naming its stream, so one connection
+// carries N logical request/response streams at once instead of a single
+// outstanding request. Each client thread owns one connection and keeps
+// one request in flight per stream. The server reads requests as they
+// arrive, hands them to a pool of --stream-workers threads and writes each
+// response as soon as it is done, in any order; --stream-order=fifo holds
+// finished responses back until all earlier ones are out (HTTP/1.1-style
+// pipelining), which shows head-of-line blocking.
+#define STREAM_MAX 4096
+
+enum {
+    STREAM_ORDER_ANY,   // responses leave as they finish
+    STREAM_ORDER_FIFO,  // responses leave in request order
+};
+
+typedef struct {
+    uint32_t stream;    // 0..streams-1
+    uint32_t len;       // payload bytes after the header
+    uint64_t seq;       // request number on this connection
+    uint64_t sent_ns;   // client clock at send, echoed back
+    uint32_t work_ns;   // extra server work the request asks for (--slow-pct)
+    uint32_t pad;
+} stream_header_t;
+
+const char *stream_order_name(int order);
+int stream_order_parse(const char *name);
+
+// Runs one connection per client thread with bench_opts.streams streams
+// each; requests go out through the pair's multiplex strategy. Prints the
+// SUMMARY, STREAMS and per-stream STREAM lines. Returns 0 on success.
+int run_stream_clients(const char *label, const char *host, int port,
+                       int threads, size_t msg_size, int duration,
+                       mux_strategy_init_fn init, mux_strategy_free_fn fini);
+
+// Serves stream-mode requests on an accepted, set-up socket until the
+// client closes it, and returns once every response is written. The caller
+// closes the socket.
+void stream_serve(int sock, size_t msg_size);
+
+#endif
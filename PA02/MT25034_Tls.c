@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <linux/tls.h>
+
+#include "MT25034_Options.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+static const char *ktls_names[] = {
+    "off", "aes-128-gcm", "aes-256-gcm", "chacha20-poly1305"
+};
+
+typedef union {
+    struct tls_crypto_info info;
+    struct tls12_crypto_info_aes_gcm_128 aes128;
+    struct tls12_crypto_info_aes_gcm_256 aes256;
+    struct tls12_crypto_info_chacha20_poly1305 chacha;
+} ktls_keys_t;
+
+static int ktls_failed;
+
+const char *ktls_name(int mode) {
+    if (mode < 0 || mode > KTLS_CHACHA20_POLY1305) {
+        return "unknown";
+    }
+    return ktls_names[mode];
+}
+
+int ktls_parse(const char *name) {
+    for (int i = 0; i <= KTLS_CHACHA20_POLY1305; i++) {
+        if (strcmp(ktls_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ktls_effective(void) {
+    return __atomic_load_n(&ktls_failed, __ATOMIC_RELAXED) ? KTLS_OFF : bench_opts.ktls;
+}
+
+// Fixed key material: both processes derive the same bytes for a direction
+// (0 = client to server, 1 = server to client) without exchanging anything.
+static void fill_secret(unsigned char *p, size_t n, int dir, unsigned char tag) {
+    for (size_t i = 0; i < n; i++) {
+        p[i] = (unsigned char)((tag << 4) ^ (dir ? 0xa5 : 0x3c) ^ (i * 7));
+    }
+}
+
+#define FILL_KEYS(c, dir) do {                                  \
+        fill_secret((c).iv, sizeof((c).iv), (dir), 1);          \
+        fill_secret((c).key, sizeof((c).key), (dir), 2);        \
+        fill_secret((c).salt, sizeof((c).salt), (dir), 3);      \
+        memset((c).rec_seq, 0, sizeof((c).rec_seq));            \
+    } while (0)
+
+static socklen_t build_keys(ktls_keys_t *k, int mode, int dir) {
+    memset(k, 0, sizeof(*k));
+    k->info.version = TLS_1_2_VERSION;
+    switch (mode) {
+    case KTLS_AES_128_GCM:
+        k->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+        FILL_KEYS(k->aes128, dir);
+        return sizeof(k->aes128);
+    case KTLS_AES_256_GCM:
+        k->info.cipher_type = TLS_CIPHER_AES_GCM_256;
+        FILL_KEYS(k->aes256, dir);
+        return sizeof(k->aes256);
+    case KTLS_CHACHA20_POLY1305:
+        k->info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        FILL_KEYS(k->chacha, dir);
+        return sizeof(k->chacha);
+    default:
+        return 0;
+    }
+}
+
+static int ktls_fallback(const char *what, int err) {
+    if (!__atomic_exchange_n(&ktls_failed, 1, __ATOMIC_ACQ_REL)) {
+        fprintf(stderr, "kTLS %s unavailable (%s: %s%s), running in plaintext\n",
+                ktls_name(bench_opts.ktls), what, strerror(err),
+                err == ENOENT ? "; is the tls module loaded? try 'modprobe tls'" : "");
+    }
+    return -1;
+}
+
+int ktls_setup_socket(int sock, int role) {
+    int mode = ktls_effective();
+    if (mode == KTLS_OFF) {
+        return -1;
+    }
+    if (setsockopt(sock, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) {
+        return ktls_fallback("TCP_ULP", errno);
+    }
+
+    // RX first: if it is refused, nothing is encrypted yet and the attached
+    // ULP passes plaintext through in both directions
+    int tx_dir = role == ROLE_SERVER ? 1 : 0;
+    ktls_keys_t keys;
+    socklen_t len = build_keys(&keys, mode, !tx_dir);
+    if (setsockopt(sock, SOL_TLS, TLS_RX, &keys, len) < 0) {
+        return ktls_fallback("TLS_RX", errno);
+    }
+    len = build_keys(&keys, mode, tx_dir);
+    if (setsockopt(sock, SOL_TLS, TLS_TX, &keys, len) < 0) {
+        int err = errno;
+        ktls_fallback("TLS_TX", err);
+        fprintf(stderr, "kTLS: socket %d decrypts but cannot encrypt, its connection will stall\n", sock);
+        return -1;
+    }
+    return 0;
+}
+
+int ktls_send_flags(int flags) {
+    return ktls_effective() != KTLS_OFF ? flags & ~MSG_ZEROCOPY : flags;
+}
+
+int ktls_active(int sock) {
+    char name[16] = "";
+    socklen_t len = sizeof(name);
+    if (getsockopt(sock, IPPROTO_TCP, TCP_ULP, name, &len) < 0) {
+        return 0;
+    }
+    return strcmp(name, "tls") == 0;
+}
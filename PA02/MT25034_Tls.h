@@ -0,0 +1,38 @@
+#ifndef MT25034_TLS_H
+#define MT25034_TLS_H
+//MT25034
+
+// Kernel TLS (--ktls[=CIPHER]). After connect/accept a socket gets the "tls"
+// upper-layer protocol and static pre-shared TLS 1.2 keys, one set per
+// direction, so records are encrypted and decrypted in the kernel with no
+// handshake library. The keys are fixed test values: this measures what
+// encryption does to the copy paths, it does not secure anything.
+enum {
+    KTLS_OFF,
+    KTLS_AES_128_GCM,
+    KTLS_AES_256_GCM,
+    KTLS_CHACHA20_POLY1305,
+};
+
+const char *ktls_name(int mode);
+int ktls_parse(const char *name);
+
+// Installs the TX and RX keys for bench_opts.ktls on a connected socket;
+// `role` (ROLE_CLIENT or ROLE_SERVER) picks which direction is which. Returns
+// 0, or -1 when the socket stays plaintext. The first failure (typically no
+// tls module) is reported once and turns kTLS off for the rest of the
+// process; both ends run on the same kernel and fall back alike.
+int ktls_setup_socket(int sock, int role);
+
+// Cipher in use: KTLS_OFF without --ktls or after a fallback.
+int ktls_effective(void);
+
+// 1 if `sock` has kTLS attached. MSG_ZEROCOPY is rejected on such sockets
+// with EOPNOTSUPP: each record is encrypted into a kernel buffer, which is
+// the copy zero-copy would have saved. sendfile still works.
+int ktls_active(int sock);
+
+// `flags` without MSG_ZEROCOPY while kTLS is in use.
+int ktls_send_flags(int flags);
+
+#endif
@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "MT25034_Options.h"
+#include "MT25034_Topology.h"
+//MT25034
+
+#define TOPO_MAX_CPUS 1024
+#define SYSFS_CPU "/sys/devices/system/cpu"
+
+typedef struct {
+    int cpu;
+    int core;       // lowest CPU among its SMT siblings
+    int llc;        // lowest CPU sharing its last-level cache
+    int node;
+    int package;
+} cpu_info_t;
+
+static const char *placement_names[] = {
+    "none", "same-core", "smt-sibling", "same-llc", "cross-llc", "cross-node"
+};
+
+static pthread_once_t topo_once = PTHREAD_ONCE_INIT;
+static cpu_info_t cpus[TOPO_MAX_CPUS];
+static int ncpus;
+static int pairs[TOPO_MAX_CPUS][2];     // [server CPU, client CPU]
+static int npairs;
+static int effective_policy;
+static int role = ROLE_CLIENT;
+
+const char *placement_name(int policy) {
+    if (policy < 0 || policy > PLACEMENT_CROSS_NODE) {
+        return "unknown";
+    }
+    return placement_names[policy];
+}
+
+int placement_parse(const char *name) {
+    for (int i = 0; i <= PLACEMENT_CROSS_NODE; i++) {
+        if (strcmp(placement_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void placement_set_role(int r) {
+    role = r;
+}
+
+static int read_int(const char *path, int fallback) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return fallback;
+    }
+    int v;
+    if (fscanf(f, "%d", &v) != 1) {
+        v = fallback;
+    }
+    fclose(f);
+    return v;
+}
+
+// First CPU of a sysfs list such as "0-3,8-11" (the scan stops at '-' or ',')
+static int read_first_cpu(const char *path, int fallback) {
+    return read_int(path, fallback);
+}
+
+// Lowest CPU sharing the highest-level data or unified cache with `cpu`
+static int read_llc(int cpu, int fallback) {
+    int best_level = -1, llc = fallback;
+    for (int idx = 0;; idx++) {
+        char path[256], type[32] = "";
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/type", cpu, idx);
+        FILE *f = fopen(path, "r");
+        if (!f) {
+            break;
+        }
+        int ok = fscanf(f, "%31s", type) == 1;
+        fclose(f);
+        if (!ok || strcmp(type, "Instruction") == 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, idx);
+        int level = read_int(path, -1);
+        if (level > best_level) {
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, idx);
+            best_level = level;
+            llc = read_first_cpu(path, fallback);
+        }
+    }
+    return llc;
+}
+
+static int read_node(int cpu) {
+    char path[64];
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d", cpu);
+    DIR *d = opendir(path);
+    if (!d) {
+        return 0;
+    }
+    int node = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, "node", 4) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9') {
+            node = atoi(e->d_name + 4);
+            break;
+        }
+    }
+    closedir(d);
+    return node;
+}
+
+static void load_topology(void) {
+    long conf = sysconf(_SC_NPROCESSORS_CONF);
+    if (conf <= 0) {
+        conf = 1;
+    }
+    if (conf > TOPO_MAX_CPUS) {
+        conf = TOPO_MAX_CPUS;
+    }
+    for (int cpu = 0; cpu < conf; cpu++) {
+        char path[128];
+        // cpu0 usually has no "online" file because it cannot go offline
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/online", cpu);
+        if (read_int(path, 1) != 1) {
+            continue;
+        }
+        cpu_info_t *c = &cpus[ncpus++];
+        c->cpu = cpu;
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/thread_siblings_list", cpu);
+        c->core = read_first_cpu(path, cpu);
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+        c->package = read_int(path, 0);
+        c->llc = read_llc(cpu, c->package);
+        c->node = read_node(cpu);
+    }
+}
+
+static const cpu_info_t *cpu_info(int cpu) {
+    for (int i = 0; i < ncpus; i++) {
+        if (cpus[i].cpu == cpu) {
+            return &cpus[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_pair(int server, int client) {
+    if (npairs < TOPO_MAX_CPUS) {
+        pairs[npairs][0] = server;
+        pairs[npairs][1] = client;
+        npairs++;
+    }
+}
+
+static int is_primary(const cpu_info_t *c) {
+    return c->core == c->cpu;
+}
+
+// Group key for pairing whole cores across LLCs or nodes
+static int group_key(const cpu_info_t *c, int policy) {
+    if (policy == PLACEMENT_CROSS_LLC) {
+        return c->llc;
+    }
+    // Without NUMA information separate sockets are the next best thing
+    return c->node * TOPO_MAX_CPUS + c->package;
+}
+
+// Pairs the primary threads of one group with those of the next group
+// (groups in CPU order), member by member.
+static void pair_groups(int policy) {
+    int keys[TOPO_MAX_CPUS], nkeys = 0;
+    for (int i = 0; i < ncpus; i++) {
+        if (!is_primary(&cpus[i])) {
+            continue;
+        }
+        int k = group_key(&cpus[i], policy), seen = 0;
+        for (int j = 0; j < nkeys; j++) {
+            seen |= keys[j] == k;
+        }
+        if (!seen) {
+            keys[nkeys++] = k;
+        }
+    }
+    for (int g = 0; g + 1 < nkeys; g += 2) {
+        int a = 0, b = 0;
+        for (;;) {
+            while (a < ncpus && !(is_primary(&cpus[a]) && group_key(&cpus[a], policy) == keys[g])) {
+                a++;
+            }
+            while (b < ncpus && !(is_primary(&cpus[b]) && group_key(&cpus[b], policy) == keys[g + 1])) {
+                b++;
+            }
+            if (a >= ncpus || b >= ncpus) {
+                break;
+            }
+            add_pair(cpus[a++].cpu, cpus[b++].cpu);
+        }
+    }
+}
+
+static void build_pairs(int policy) {
+    npairs = 0;
+    switch (policy) {
+    case PLACEMENT_SAME_CORE:
+        for (int i = 0; i < ncpus; i++) {
+            if (is_primary(&cpus[i])) {
+                add_pair(cpus[i].cpu, cpus[i].cpu);
+            }
+        }
+        break;
+    case PLACEMENT_SMT_SIBLING:
+        for (int i = 0; i < ncpus; i++) {
+            for (int j = 0; is_primary(&cpus[i]) && j < ncpus; j++) {
+                if (cpus[j].core == cpus[i].cpu && j != i) {
+                    add_pair(cpus[i].cpu, cpus[j].cpu);
+                    break;
+                }
+            }
+        }
+        break;
+    case PLACEMENT_SAME_LLC: {
+        // Consecutive cores of each LLC form a pair
+        int used[TOPO_MAX_CPUS] = {0};
+        for (int i = 0; i < ncpus; i++) {
+            if (!is_primary(&cpus[i]) || used[i]) {
+                continue;
+            }
+            for (int j = i + 1; j < ncpus; j++) {
+                if (is_primary(&cpus[j]) && !used[j] && cpus[j].llc == cpus[i].llc) {
+                    used[i] = used[j] = 1;
+                    add_pair(cpus[i].cpu, cpus[j].cpu);
+                    break;
+                }
+            }
+        }
+        break;
+    }
+    case PLACEMENT_CROSS_LLC:
+    case PLACEMENT_CROSS_NODE:
+        pair_groups(policy);
+        break;
+    default:
+        break;
+    }
+}
+
+static void init_placement(void) {
+    load_topology();
+    int policy = bench_opts.placement;
+    if (policy == PLACEMENT_NONE) {
+        effective_policy = PLACEMENT_NONE;
+        return;
+    }
+    if (ncpus == 0) {
+        // No sysfs: treat every configured CPU as its own core
+        cpus[0] = (cpu_info_t){ 0, 0, 0, 0, 0 };
+        ncpus = 1;
+    }
+    for (int p = policy; p >= PLACEMENT_SAME_CORE; p--) {
+        build_pairs(p);
+        if (npairs > 0) {
+            effective_policy = p;
+            break;
+        }
+    }
+    if (effective_policy != policy && role == ROLE_SERVER) {
+        fprintf(stderr, "placement %s not available on this machine (%d CPUs), using %s\n",
+                placement_name(policy), ncpus, placement_name(effective_policy));
+    }
+}
+
+int placement_cpu(int index) {
+    pthread_once(&topo_once, init_placement);
+    if (effective_policy == PLACEMENT_NONE || npairs == 0) {
+        return -1;
+    }
+    int side = role == ROLE_SERVER ? 0 : 1;
+    return pairs[index % npairs][side];
+}
+
+int placement_effective(void) {
+    pthread_once(&topo_once, init_placement);
+    return effective_policy;
+}
+
+int topology_cpu_node(int cpu) {
+    pthread_once(&topo_once, init_placement);
+    const cpu_info_t *c = cpu_info(cpu);
+    return c ? c->node : 0;
+}
+
+int placement_buffer_node(void) {
+    if (bench_opts.placement == PLACEMENT_NONE) {
+        return -1;
+    }
+    int cpu = sched_getcpu();
+    return cpu < 0 ? -1 : topology_cpu_node(cpu);
+}
@@ -0,0 +1,45 @@
+#ifndef MT25034_TOPOLOGY_H
+#define MT25034_TOPOLOGY_H
+//MT25034
+
+// CPU topology from sysfs and client/server thread placement (--placement).
+// Both processes read the same topology and enumerate the same list of
+// (server CPU, client CPU) pairs for the policy; thread/connection i of each
+// side takes pair i, so the two ends of a connection land in the requested
+// relation without talking to each other.
+enum {
+    PLACEMENT_NONE,         // leave threads to the scheduler (or --pin)
+    PLACEMENT_SAME_CORE,    // both ends on the same logical CPU
+    PLACEMENT_SMT_SIBLING,  // hyperthreads of one physical core
+    PLACEMENT_SAME_LLC,     // different cores sharing the last-level cache
+    PLACEMENT_CROSS_LLC,    // cores with different last-level caches
+    PLACEMENT_CROSS_NODE,   // different NUMA nodes (or sockets)
+};
+
+enum {
+    ROLE_CLIENT,
+    ROLE_SERVER,
+};
+
+const char *placement_name(int policy);
+int placement_parse(const char *name);
+
+// Which side of each pair this process takes; servers call it after parsing
+// options, clients keep the default.
+void placement_set_role(int role);
+
+// CPU for thread `index` under bench_opts.placement, -1 when unplaced.
+int placement_cpu(int index);
+
+// Policy actually in use: one the machine cannot provide (no SMT, a single
+// LLC or node) falls back to the nearest closer one, with a note on stderr.
+int placement_effective(void);
+
+// NUMA node of `cpu`, 0 when sysfs has no node information.
+int topology_cpu_node(int cpu);
+
+// Node message buffers of the calling thread should live on, -1 when
+// placement is off (buffers are then left to first touch).
+int placement_buffer_node(void);
+
+#endif
@@ -0,0 +1,452 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Tls.h"
+#include "MT25034_Topology.h"
+#include "MT25034_Transport.h"
+//MT25034
+
+#define MIN_SPIN_NS 1000ULL
+
+// Per-thread spin budget. It doubles when data shows up while spinning and
+// halves when the thread had to block anyway, so a peer that answers slowly
+// stops costing a full core.
+static __thread uint64_t spin_budget_ns;
+
+typedef struct {
+    uint64_t start;
+    int spun;
+    int blocked;
+} spin_state_t;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static uint64_t max_spin_ns(void) {
+    return (uint64_t)(bench_opts.spin_us > 0 ? bench_opts.spin_us : 0) * 1000ULL;
+}
+
+static void spin_begin(spin_state_t *st) {
+    if (spin_budget_ns == 0) {
+        spin_budget_ns = max_spin_ns();
+    }
+    st->start = 0;
+    st->spun = 0;
+    st->blocked = 0;
+}
+
+static void spin_end(spin_state_t *st) {
+    uint64_t max = max_spin_ns();
+    if (st->blocked) {
+        spin_budget_ns /= 2;
+        if (spin_budget_ns < MIN_SPIN_NS) {
+            spin_budget_ns = MIN_SPIN_NS;
+        }
+    } else if (st->spun) {
+        spin_budget_ns *= 2;
+        if (spin_budget_ns > max) {
+            spin_budget_ns = max;
+        }
+    }
+}
+
+// Called after an EAGAIN: spin while within budget, otherwise block in poll().
+static int spin_wait(spin_state_t *st, int sock, short events) {
+    if (!st->blocked) {
+        uint64_t now = now_ns();
+        if (st->start == 0) {
+            st->start = now;
+        }
+        if (now - st->start < spin_budget_ns) {
+            st->spun = 1;
+            cpu_relax();
+            return 0;
+        }
+    }
+
+    struct pollfd pfd = { .fd = sock, .events = events };
+    st->blocked = 1;
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+        return -1;
+    }
+    return 0;
+}
+
+static inline int would_block(int err) {
+    return err == EAGAIN || err == EWOULDBLOCK;
+}
+
+// TCP_QUICKACK is not sticky: the kernel drops back to delayed ACKs, so
+// the latency profile re-arms it after every successful receive.
+static inline void rearm_quickack(int sock, ssize_t n) {
+    if (n > 0 && bench_opts.profile.quickack > 0) {
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+    }
+}
+
+static inline void set_cork(int sock, int on) {
+    if (bench_opts.profile.cork > 0) {
+        int saved = errno;
+        setsockopt(sock, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+        errno = saved;
+    }
+}
+
+void transport_prepare_socket(int sock) {
+    socket_profile_apply_pre_connect(sock, &bench_opts.profile);
+}
+
+void transport_setup_socket(int sock) {
+    socket_profile_apply(sock, &bench_opts.profile);
+
+    if (!bench_opts.busy_poll) {
+        return;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    // Raising the busy-poll time above the sysctl default needs CAP_NET_ADMIN;
+    // without it the user-space spin still applies.
+    int usec = bench_opts.spin_us;
+    setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+#ifdef SO_PREFER_BUSY_POLL
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one));
+#endif
+}
+
+void transport_pin_thread(int index) {
+    int cpu;
+    if (bench_opts.placement != PLACEMENT_NONE) {
+        cpu = placement_cpu(index);
+    } else if (bench_opts.pin_cpu >= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        if (ncpu <= 0) {
+            return;
+        }
+        cpu = (int)((bench_opts.pin_cpu + index) % ncpu);
+    } else {
+        return;
+    }
+    if (cpu < 0) {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        errno = rc;
+        perror("pthread_setaffinity_np failed");
+    }
+}
+
+// Listeners only ever end on SIGTERM, which skips the exit-time profile
+// dump of an instrumented build (make pgo); libgcov is only linked there
+extern void __gcov_dump(void) __attribute__((weak));
+
+static void dump_profile_and_exit(int sig) {
+    (void)sig;
+    __gcov_dump();
+    _exit(0);
+}
+
+void transport_signal_ready(void) {
+    static const char msg[] = "READY\n";
+    if (__gcov_dump) {
+        signal(SIGTERM, dump_profile_and_exit);
+    }
+    if (bench_opts.ready_fd < 0) {
+        return;
+    }
+    if (write(bench_opts.ready_fd, msg, sizeof(msg) - 1) < 0) {
+        perror("ready-fd write failed");
+    }
+    close(bench_opts.ready_fd);
+    bench_opts.ready_fd = -1;
+}
+
+static ssize_t busy_send(int sock, const void *buf, size_t len, int flags) {
+    if (!bench_opts.busy_poll) {
+        return send(sock, buf, len, flags);
+    }
+    spin_state_t st;
+    spin_begin(&st);
+    for (;;) {
+        ssize_t n = send(sock, buf, len, flags | MSG_DONTWAIT);
+        if (n >= 0 || !would_block(errno)) {
+            spin_end(&st);
+            return n;
+        }
+        if (spin_wait(&st, sock, POLLOUT) < 0) {
+            return -1;
+        }
+    }
+}
+
+static ssize_t busy_recv(int sock, void *buf, size_t len, int flags) {
+    if (!bench_opts.busy_poll) {
+        return recv(sock, buf, len, flags);
+    }
+    spin_state_t st;
+    spin_begin(&st);
+    for (;;) {
+        ssize_t n = recv(sock, buf, len, flags | MSG_DONTWAIT);
+        if (n >= 0 || !would_block(errno)) {
+            spin_end(&st);
+            return n;
+        }
+        if (spin_wait(&st, sock, POLLIN) < 0) {
+            return -1;
+        }
+    }
+}
+
+static ssize_t busy_sendmsg(int sock, const struct msghdr *msg, int flags) {
+    if (!bench_opts.busy_poll) {
+        return sendmsg(sock, msg, flags);
+    }
+    spin_state_t st;
+    spin_begin(&st);
+    for (;;) {
+        ssize_t n = sendmsg(sock, msg, flags | MSG_DONTWAIT);
+        if (n >= 0 || !would_block(errno)) {
+            spin_end(&st);
+            return n;
+        }
+        if (spin_wait(&st, sock, POLLOUT) < 0) {
+            return -1;
+        }
+    }
+}
+
+static ssize_t busy_recvmsg(int sock, struct msghdr *msg, int flags) {
+    if (!bench_opts.busy_poll) {
+        return recvmsg(sock, msg, flags);
+    }
+    spin_state_t st;
+    spin_begin(&st);
+    for (;;) {
+        ssize_t n = recvmsg(sock, msg, flags | MSG_DONTWAIT);
+        if (n >= 0 || !would_block(errno)) {
+            spin_end(&st);
+            return n;
+        }
+        if (spin_wait(&st, sock, POLLIN) < 0) {
+            return -1;
+        }
+    }
+}
+
+static ssize_t busy_sendfile(int sock, int in_fd, off_t *offset, size_t count) {
+    if (!bench_opts.busy_poll) {
+        return sendfile(sock, in_fd, offset, count);
+    }
+    spin_state_t st;
+    spin_begin(&st);
+    for (;;) {
+        ssize_t n = sendfile(sock, in_fd, offset, count);
+        if (n >= 0 || !would_block(errno)) {
+            spin_end(&st);
+            return n;
+        }
+        if (spin_wait(&st, sock, POLLOUT) < 0) {
+            return -1;
+        }
+    }
+}
+
+ssize_t transport_send(int sock, const void *buf, size_t len, int flags) {
+    flags = ktls_send_flags(flags);
+    set_cork(sock, 1);
+    ssize_t n = busy_send(sock, buf, len, flags);
+    set_cork(sock, 0);
+    return n;
+}
+
+ssize_t transport_recv(int sock, void *buf, size_t len, int flags) {
+    ssize_t n = busy_recv(sock, buf, len, flags);
+    rearm_quickack(sock, n);
+    return n;
+}
+
+ssize_t transport_sendmsg(int sock, const struct msghdr *msg, int flags) {
+    flags = ktls_send_flags(flags);
+    set_cork(sock, 1);
+    ssize_t n = busy_sendmsg(sock, msg, flags);
+    set_cork(sock, 0);
+    return n;
+}
+
+ssize_t transport_recvmsg(int sock, struct msghdr *msg, int flags) {
+    ssize_t n = busy_recvmsg(sock, msg, flags);
+    rearm_quickack(sock, n);
+    return n;
+}
+
+ssize_t transport_sendfile(int sock, int in_fd, off_t *offset, size_t count) {
+    set_cork(sock, 1);
+    ssize_t n = busy_sendfile(sock, in_fd, offset, count);
+    set_cork(sock, 0);
+    return n;
+}
+
+int iov_slice(const struct iovec *iov, int cnt, size_t offset, struct iovec *out) {
+    int n = 0;
+    for (int i = 0; i < cnt; i++) {
+        if (offset >= iov[i].iov_len) {
+            offset -= iov[i].iov_len;
+            continue;
+        }
+        out[n].iov_base = (char *)iov[i].iov_base + offset;
+        out[n].iov_len = iov[i].iov_len - offset;
+        offset = 0;
+        n++;
+    }
+    return n;
+}
+
+static size_t iov_total(const struct iovec *iov, size_t cnt) {
+    size_t total = 0;
+    for (size_t i = 0; i < cnt; i++) {
+        total += iov[i].iov_len;
+    }
+    return total;
+}
+
+int transport_send_all(int sock, const void *buf, size_t len) {
+    const char *p = (const char *)buf;
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = transport_send(sock, p + sent, len - sent, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+int transport_recv_all(int sock, void *buf, size_t len) {
+    char *p = (char *)buf;
+    size_t recvd = 0;
+    while (recvd < len) {
+        ssize_t n = transport_recv(sock, p + recvd, len - recvd, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;
+        }
+        recvd += (size_t)n;
+    }
+    return 0;
+}
+
+void iov_cursor_init(iov_cursor_t *c, const struct msghdr *msg) {
+    c->iov = msg->msg_iov;
+    c->cnt = msg->msg_iovlen;
+    c->offset = 0;
+    c->head.iov_base = NULL;
+    c->head.iov_len = 0;
+}
+
+void iov_cursor_part(iov_cursor_t *c, struct msghdr *part) {
+    if (c->offset > 0) {
+        c->head.iov_base = (char *)c->iov[0].iov_base + c->offset;
+        c->head.iov_len = c->iov[0].iov_len - c->offset;
+        part->msg_iov = &c->head;
+        part->msg_iovlen = 1;
+    } else {
+        part->msg_iov = (struct iovec *)c->iov;
+        part->msg_iovlen = c->cnt;
+    }
+}
+
+void iov_cursor_advance(iov_cursor_t *c, size_t n) {
+    n += c->offset;
+    while (c->cnt > 0 && n >= c->iov[0].iov_len) {
+        n -= c->iov[0].iov_len;
+        c->iov++;
+        c->cnt--;
+    }
+    c->offset = n;
+}
+
+int transport_sendmsg_all(int sock, const struct msghdr *msg, int flags) {
+    size_t total = iov_total(msg->msg_iov, msg->msg_iovlen);
+    size_t done = 0;
+    iov_cursor_t cur;
+    iov_cursor_init(&cur, msg);
+    struct msghdr part = *msg;
+
+    while (done < total) {
+        // First attempt uses the caller's iovec as it is
+        iov_cursor_part(&cur, &part);
+        ssize_t n = transport_sendmsg(sock, &part, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+        iov_cursor_advance(&cur, (size_t)n);
+    }
+    return 0;
+}
+
+int transport_recvmsg_all(int sock, struct msghdr *msg, int flags) {
+    size_t total = iov_total(msg->msg_iov, msg->msg_iovlen);
+    size_t done = 0;
+    iov_cursor_t cur;
+    iov_cursor_init(&cur, msg);
+    struct msghdr part = *msg;
+
+    while (done < total) {
+        iov_cursor_part(&cur, &part);
+        ssize_t n = transport_recvmsg(sock, &part, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;
+        }
+        done += (size_t)n;
+        iov_cursor_advance(&cur, (size_t)n);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef MT25034_TRANSPORT_H
+#define MT25034_TRANSPORT_H
+//MT25034
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+// Socket I/O wrappers used by every client and server. In the default
+// blocking mode they are plain send/recv/sendmsg/recvmsg calls. With
+// --busy-poll the socket is non-blocking and an empty queue is spun on
+// for an adaptive budget before the thread falls back to poll().
+
+// Socket-profile options that must precede listen()/connect() (buffer sizes).
+void transport_prepare_socket(int sock);
+
+// Applies per-connection options (socket profile, non-blocking, SO_BUSY_POLL)
+// to a connected or accepted socket.
+void transport_setup_socket(int sock);
+
+// Pins the calling thread to its --placement CPU, or to core
+// (pin_cpu + index) % ncpu; no-op when unpinned.
+void transport_pin_thread(int index);
+
+// Tells whoever started this server (the orchestrator, via --ready-fd) that
+// it is listening; no-op without --ready-fd.
+void transport_signal_ready(void);
+
+ssize_t transport_send(int sock, const void *buf, size_t len, int flags);
+ssize_t transport_recv(int sock, void *buf, size_t len, int flags);
+ssize_t transport_sendmsg(int sock, const struct msghdr *msg, int flags);
+ssize_t transport_recvmsg(int sock, struct msghdr *msg, int flags);
+ssize_t transport_sendfile(int sock, int in_fd, off_t *offset, size_t count);
+
+// Fills `out` with the part of `iov` that starts `offset` bytes in and
+// returns its element count.
+int iov_slice(const struct iovec *iov, int cnt, size_t offset, struct iovec *out);
+
+// Cursor over a caller's iovec for loops that resume after short
+// transfers. It points into the caller's array instead of copying it (up to
+// IOV_MAX entries would not fit small --stack-kb thread stacks); a partly
+// done entry goes out alone from `head` before the rest.
+typedef struct {
+    const struct iovec *iov;    // first entry not yet fully done
+    size_t cnt;
+    size_t offset;              // bytes of iov[0] already done
+    struct iovec head;
+} iov_cursor_t;
+
+void iov_cursor_init(iov_cursor_t *c, const struct msghdr *msg);
+// Points part->msg_iov/msg_iovlen at what is left to transfer.
+void iov_cursor_part(iov_cursor_t *c, struct msghdr *part);
+// Moves past `n` transferred bytes.
+void iov_cursor_advance(iov_cursor_t *c, size_t n);
+
+// send/recv until all `len` bytes are transferred (the TwoCopy pair's
+// path). 0 on success, -1 on error or end of stream.
+int transport_send_all(int sock, const void *buf, size_t len);
+int transport_recv_all(int sock, void *buf, size_t len);
+
+// sendmsg/recvmsg until every byte of msg->msg_iov is transferred, resuming
+// after short transfers. 0 on success, -1 on error or end of stream.
+int transport_sendmsg_all(int sock, const struct msghdr *msg, int flags);
+int transport_recvmsg_all(int sock, struct msghdr *msg, int flags);
+
+#endif
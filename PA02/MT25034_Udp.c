@@ -0,0 +1,333 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "MT25034_MsgBuf.h"
+#include "MT25034_Options.h"
+#include "MT25034_Stats.h"
+#include "MT25034_Udp.h"
+//MT25034
+
+static const char *udp_mode_names[] = { "single", "mmsg", "gso" };
+
+const char *udp_mode_name(int mode) {
+    if (mode < 0 || mode > UDP_MODE_GSO) {
+        return "unknown";
+    }
+    return udp_mode_names[mode];
+}
+
+int udp_mode_parse(const char *name) {
+    for (int i = 0; i <= UDP_MODE_GSO; i++) {
+        if (strcmp(udp_mode_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int udp_endpoint_init(udp_endpoint_t *e, int sock, size_t max_len, int connected) {
+    memset(e, 0, sizeof(*e));
+    e->sock = sock;
+    e->mode = bench_opts.udp_mode;
+    e->connected = connected;
+    e->batch = e->mode == UDP_MODE_SINGLE ? 1 : bench_opts.udp_batch;
+    e->rx_len = max_len;
+
+    int one = 1;
+    if (e->mode == UDP_MODE_GSO) {
+        if (setsockopt(sock, IPPROTO_UDP, UDP_GRO, &one, sizeof(one)) == 0) {
+            e->gro = 1;
+            e->rx_len = UDP_GRO_BUF;
+        } else {
+            perror("setsockopt UDP_GRO (receiving datagram by datagram)");
+        }
+    }
+    if (bench_opts.udp_zerocopy) {
+        // Without SO_ZEROCOPY the kernel silently ignores MSG_ZEROCOPY
+        if (setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+            e->zc.enabled = 1;
+        } else {
+            perror("setsockopt SO_ZEROCOPY (falling back to copying sends)");
+        }
+    }
+    if (bench_opts.busy_poll) {
+        int usec = bench_opts.spin_us;
+        setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec));
+    }
+
+    e->rx_area = msgbuf_alloc(e->rx_len * (size_t)e->batch);
+    return e->rx_area ? 0 : -1;
+}
+
+void udp_endpoint_free(udp_endpoint_t *e) {
+    msgbuf_free(e->rx_area);
+    e->rx_area = NULL;
+}
+
+void udp_release(udp_endpoint_t *e) {
+    zerocopy_reap(e->sock, &e->zc, 1);
+}
+
+// Datagrams the kernel would not take right now are lost like any other
+// datagram; ECONNREFUSED is a port-unreachable for an earlier one
+static int is_drop(int err) {
+    return err == ENOBUFS || err == EAGAIN || err == EWOULDBLOCK || err == ECONNREFUSED;
+}
+
+static void dgram_msghdr(const udp_endpoint_t *e, struct msghdr *mh, struct iovec *iov,
+                         udp_dgram_t *d, size_t len) {
+    memset(mh, 0, sizeof(*mh));
+    iov->iov_base = d->data;
+    iov->iov_len = len;
+    mh->msg_iov = iov;
+    mh->msg_iovlen = 1;
+    if (!e->connected) {
+        mh->msg_name = &d->addr;
+        mh->msg_namelen = sizeof(d->addr);
+    }
+}
+
+// One sendmsg; 1 if accepted, 0 if dropped, -1 on error
+static int send_msghdr(udp_endpoint_t *e, struct msghdr *mh, int flags) {
+    for (;;) {
+        e->send_calls++;
+        if (sendmsg(e->sock, mh, flags) >= 0) {
+            if (flags & MSG_ZEROCOPY) {
+                e->zc.sends++;
+            }
+            return 1;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return is_drop(errno) ? 0 : -1;
+    }
+}
+
+static int same_dest(const udp_endpoint_t *e, const udp_dgram_t *a, const udp_dgram_t *b) {
+    return e->connected || (a->addr.sin_addr.s_addr == b->addr.sin_addr.s_addr &&
+                            a->addr.sin_port == b->addr.sin_port);
+}
+
+static int send_single(udp_endpoint_t *e, udp_dgram_t *d, int count, int flags) {
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        struct msghdr mh;
+        struct iovec iov;
+        dgram_msghdr(e, &mh, &iov, &d[i], d[i].len);
+        int rc = send_msghdr(e, &mh, flags);
+        if (rc < 0) {
+            return -1;
+        }
+        sent += rc;
+    }
+    return sent;
+}
+
+static int send_mmsg(udp_endpoint_t *e, udp_dgram_t *d, int count, int flags) {
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    int sent = 0;
+    for (int base = 0; base < count; base += UDP_MAX_BATCH) {
+        int n = count - base < UDP_MAX_BATCH ? count - base : UDP_MAX_BATCH;
+        for (int i = 0; i < n; i++) {
+            dgram_msghdr(e, &msgs[i].msg_hdr, &iov[i], &d[base + i], d[base + i].len);
+        }
+        int off = 0;
+        while (off < n) {
+            e->send_calls++;
+            int rc = sendmmsg(e->sock, msgs + off, (unsigned int)(n - off), flags);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (!is_drop(errno)) {
+                    return -1;
+                }
+                // sendmmsg fails only on its first message: skip that one
+                off++;
+                continue;
+            }
+            if (flags & MSG_ZEROCOPY) {
+                e->zc.sends += (uint64_t)rc;
+            }
+            off += rc;
+            sent += rc;
+        }
+    }
+    return sent;
+}
+
+static int send_gso(udp_endpoint_t *e, udp_dgram_t *d, int count, int flags) {
+    int sent = 0;
+    int i = 0;
+    while (i < count) {
+        // Longest run that can leave as one super-datagram
+        int j = i + 1;
+        size_t total = d[i].len;
+        while (j < count && j - i < UDP_MAX_BATCH && d[j].len == d[i].len &&
+               d[j].data == d[j - 1].data + d[j - 1].len && same_dest(e, &d[i], &d[j]) &&
+               total + d[j].len <= UDP_MAX_PAYLOAD) {
+            total += d[j].len;
+            j++;
+        }
+
+        struct msghdr mh;
+        struct iovec iov;
+        char control[CMSG_SPACE(sizeof(uint16_t))] __attribute__((aligned(8)));
+        dgram_msghdr(e, &mh, &iov, &d[i], total);
+        if (j - i > 1) {
+            memset(control, 0, sizeof(control));
+            mh.msg_control = control;
+            mh.msg_controllen = sizeof(control);
+            struct cmsghdr *cm = CMSG_FIRSTHDR(&mh);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t seg = (uint16_t)d[i].len;
+            memcpy(CMSG_DATA(cm), &seg, sizeof(seg));
+        }
+        int rc = send_msghdr(e, &mh, flags);
+        if (rc < 0) {
+            return -1;
+        }
+        sent += rc ? j - i : 0;
+        i = j;
+    }
+    return sent;
+}
+
+int udp_send(udp_endpoint_t *e, udp_dgram_t *d, int count) {
+    int flags = e->zc.enabled ? MSG_ZEROCOPY : 0;
+    int sent;
+    switch (e->mode) {
+    case UDP_MODE_MMSG:
+        sent = send_mmsg(e, d, count, flags);
+        break;
+    case UDP_MODE_GSO:
+        sent = send_gso(e, d, count, flags);
+        break;
+    default:
+        sent = send_single(e, d, count, flags);
+        break;
+    }
+    if (sent < 0) {
+        return -1;
+    }
+    e->datagrams_out += (uint64_t)sent;
+    e->drops += (uint64_t)(count - sent);
+    return sent;
+}
+
+// 1 when a datagram is waiting, 0 on timeout. Zero-copy completions wake
+// poll() with POLLERR; they are reaped here so they do not spin the loop.
+static int wait_readable(udp_endpoint_t *e, int timeout_ms) {
+    struct pollfd pfd = { .fd = e->sock, .events = POLLIN };
+    uint64_t deadline = timeout_ms >= 0 ? now_ns() + (uint64_t)timeout_ms * 1000000ULL : 0;
+    uint64_t spin_until = bench_opts.busy_poll ? now_ns() + (uint64_t)bench_opts.spin_us * 1000ULL : 0;
+    for (;;) {
+        uint64_t now = now_ns();
+        int wait_ms = -1;
+        if (now < spin_until) {
+            wait_ms = 0;
+        } else if (timeout_ms >= 0) {
+            if (now >= deadline) {
+                return 0;
+            }
+            wait_ms = (int)((deadline - now + 999999ULL) / 1000000ULL);
+        }
+        int rc = poll(&pfd, 1, wait_ms);
+        if (rc < 0 && errno != EINTR) {
+            return -1;
+        }
+        if (rc > 0 && (pfd.revents & POLLIN)) {
+            return 1;
+        }
+        if (rc > 0 && (pfd.revents & POLLERR)) {
+            if (!e->zc.enabled) {
+                return 1;   // a pending ICMP error: let recvmsg report it
+            }
+            zerocopy_reap(e->sock, &e->zc, 0);
+        }
+    }
+}
+
+int udp_recv(udp_endpoint_t *e, int timeout_ms, udp_recv_fn fn, void *ctx) {
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    struct sockaddr_in addrs[UDP_MAX_BATCH];
+    char control[UDP_MAX_BATCH][CMSG_SPACE(sizeof(int))] __attribute__((aligned(8)));
+
+    int rc = wait_readable(e, timeout_ms);
+    if (rc <= 0) {
+        return rc;
+    }
+
+    memset(msgs, 0, sizeof(msgs[0]) * (size_t)e->batch);
+    for (int i = 0; i < e->batch; i++) {
+        iov[i].iov_base = e->rx_area + (size_t)i * e->rx_len;
+        iov[i].iov_len = e->rx_len;
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        if (e->gro) {
+            msgs[i].msg_hdr.msg_control = control[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+    }
+
+    int n;
+    e->recv_calls++;
+    if (e->mode == UDP_MODE_SINGLE) {
+        ssize_t len = recvmsg(e->sock, &msgs[0].msg_hdr, MSG_DONTWAIT);
+        msgs[0].msg_len = len > 0 ? (unsigned int)len : 0;
+        n = len < 0 ? -1 : 1;
+    } else {
+        n = recvmmsg(e->sock, msgs, (unsigned int)e->batch, MSG_DONTWAIT, NULL);
+    }
+    if (n < 0) {
+        // Spurious wake-up, signal, or the ICMP error of an earlier datagram
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNREFUSED ? 0 : -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        struct msghdr *mh = &msgs[i].msg_hdr;
+        size_t len = msgs[i].msg_len;
+        if (mh->msg_flags & MSG_TRUNC) {
+            continue;
+        }
+        size_t seg = len;
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(mh); e->gro && cm; cm = CMSG_NXTHDR(mh, cm)) {
+            if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+                int gso_size;
+                memcpy(&gso_size, CMSG_DATA(cm), sizeof(gso_size));
+                if (gso_size > 0 && (size_t)gso_size < len) {
+                    seg = (size_t)gso_size;
+                    e->gro_buffers++;
+                }
+            }
+        }
+        char *buf = (char *)iov[i].iov_base;
+        for (size_t off = 0; off < len; off += seg) {
+            udp_dgram_t d;
+            d.data = buf + off;
+            d.len = len - off < seg ? len - off : seg;
+            d.addr = addrs[i];
+            fn(ctx, &d);
+            count++;
+        }
+    }
+    e->datagrams_in += (uint64_t)count;
+    return count;
+}
@@ -0,0 +1,86 @@
+#ifndef MT25034_UDP_H
+#define MT25034_UDP_H
+//MT25034
+
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "MT25034_Payload.h"
+
+// Datagram I/O for the UDP pair (MT25034_Part_A4_*). Datagrams are sent and
+// received in batches of up to --batch, one system call per datagram or
+// per batch depending on --udp:
+enum {
+    UDP_MODE_SINGLE,    // sendmsg/recvmsg per datagram
+    UDP_MODE_MMSG,      // sendmmsg/recvmmsg per batch
+    UDP_MODE_GSO,       // UDP_SEGMENT sends and UDP_GRO receives (with recvmmsg)
+};
+
+// Largest batch; also the kernel's cap on segments per GSO send
+#define UDP_MAX_BATCH 64
+#define UDP_MAX_PAYLOAD 65507
+// A GRO receive can hold up to 64 KiB of coalesced datagrams
+#define UDP_GRO_BUF 65536
+
+// Start of every datagram: the client checks echoes against it to count
+// loss and reordering and to time the round trip.
+typedef struct {
+    uint32_t flow;      // client thread
+    uint32_t len;       // datagram length
+    uint64_t seq;       // per-flow sequence number, from 0
+    uint64_t sent_ns;   // now_ns() at send
+} udp_header_t;
+
+// One datagram to send, or one handed to a receive callback.
+typedef struct {
+    char *data;
+    size_t len;
+    struct sockaddr_in addr;    // destination or source; unused on connected sockets
+} udp_dgram_t;
+
+typedef struct {
+    int sock;
+    int mode;
+    int gro;                // UDP_GRO accepted by the socket
+    int connected;          // send without addresses
+    int batch;              // datagrams (or GRO buffers) per receive call
+    size_t rx_len;          // bytes per receive buffer
+    char *rx_area;          // `batch` receive buffers of rx_len bytes
+    zc_counters_t zc;       // --udp-zerocopy bookkeeping
+    uint64_t send_calls;
+    uint64_t recv_calls;
+    uint64_t datagrams_out;
+    uint64_t datagrams_in;
+    uint64_t gro_buffers;   // receives that held more than one datagram
+    uint64_t drops;         // sends the kernel refused (ENOBUFS, ...)
+} udp_endpoint_t;
+
+const char *udp_mode_name(int mode);
+int udp_mode_parse(const char *name);
+
+// Applies bench_opts.udp_mode to `sock` (UDP_GRO for gso, SO_ZEROCOPY with
+// --udp-zerocopy, SO_BUSY_POLL) and allocates --batch receive buffers for
+// datagrams of up to `max_len` bytes. -1 on allocation failure.
+int udp_endpoint_init(udp_endpoint_t *e, int sock, size_t max_len, int connected);
+void udp_endpoint_free(udp_endpoint_t *e);
+
+// Sends `count` datagrams. In gso mode runs of equal-sized datagrams that
+// are adjacent in memory and go to the same address leave as one
+// UDP_SEGMENT send. Returns the number the kernel accepted, -1 on error.
+int udp_send(udp_endpoint_t *e, udp_dgram_t *d, int count);
+
+typedef void (*udp_recv_fn)(void *ctx, udp_dgram_t *d);
+
+// Receives one batch (GRO buffers are split back into datagrams) and calls
+// `fn` for each datagram. Waits at most timeout_ms for the first one (-1 =
+// forever). Returns the number of datagrams, 0 on timeout, -1 on error.
+// Buffers are reused by the next call.
+int udp_recv(udp_endpoint_t *e, int timeout_ms, udp_recv_fn fn, void *ctx);
+
+// Waits for the kernel to release MSG_ZEROCOPY buffers before they are
+// rewritten.
+void udp_release(udp_endpoint_t *e);
+
+#endif